@@ -0,0 +1,96 @@
+/*
+ * clock_plan.c
+ *
+ *  Picks the system PLL setting and S/PDIF PIO divider for each supported sample rate.
+ *
+ *  The PIO spends 256 cycles per S/PDIF frame, so with the 16.8 divider the frame period is
+ *  exactly pio_div_q8 system clocks. For every PLL setting in the VCO and system clock limits
+ *  the divider is rounded to nearest and the setting with the smallest rate error wins, ties
+ *  going to the faster system clock (smaller jitter, more DSP headroom). An integer divider
+ *  (no fractional jitter) is 63ppm off at best (44.1k) and 186-344ppm at the others, against
+ *  under 1ppm fractional, so no setting is worth one and every plan jitters by a system clock
+ *  period.
+ *
+ *  Plain integer C with no SDK dependencies so it can be run on the host.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "clock_plan.h"
+
+#define CLOCK_PLAN_FB_MIN 16u
+#define CLOCK_PLAN_FB_MAX 320u
+#define CLOCK_PLAN_POST_DIV_MAX 7u
+
+#define CLOCK_PLAN_ENTRY(freq, code) { .sample_freq = (freq), .cs_freq_code = (code) },
+
+static struct clock_plan plans[CLOCK_PLAN_RATE_COUNT] = {
+        CLOCK_PLAN_RATES(CLOCK_PLAN_ENTRY)
+};
+
+static int64_t plan_error_ppb(uint32_t vco_freq, uint32_t post_div, uint32_t div_q8, uint32_t sample_freq) {
+    // achieved / nominal - 1, the crystal counted as exact
+    int64_t denom = (int64_t) post_div * div_q8 * sample_freq;
+    return ((int64_t) vco_freq * 1000000000ll + denom / 2) / denom - 1000000000ll;
+}
+
+bool clock_plan_compute(uint32_t sample_freq, uint8_t cs_freq_code, struct clock_plan *plan) {
+    int64_t best_score = INT64_MAX;
+    plan->sys_freq = 0;
+
+    for(uint32_t fb = CLOCK_PLAN_FB_MIN; fb <= CLOCK_PLAN_FB_MAX; fb++) {
+        uint32_t vco = CLOCK_PLAN_XOSC_HZ * fb;
+        if(vco < CLOCK_PLAN_VCO_MIN_HZ || vco > CLOCK_PLAN_VCO_MAX_HZ) continue;
+
+        for(uint32_t pd1 = 1; pd1 <= CLOCK_PLAN_POST_DIV_MAX; pd1++) {
+            for(uint32_t pd2 = 1; pd2 <= pd1; pd2++) {
+                uint32_t pd = pd1 * pd2;
+                uint32_t sys = vco / pd;
+                if(sys < CLOCK_PLAN_SYS_MIN_HZ || sys > CLOCK_PLAN_SYS_MAX_HZ) continue;
+
+                // nearest 16.8 divider
+                uint32_t div_q8 = (uint32_t) (((uint64_t) vco + (uint64_t) pd * sample_freq / 2) / ((uint64_t) pd * sample_freq));
+                if(div_q8 < 0x100u || div_q8 > 0xffffffu) continue;
+
+                int64_t error = plan_error_ppb(vco, pd, div_q8, sample_freq);
+                int64_t score = error < 0 ? -error : error;
+                if(score < best_score || (score == best_score && sys > plan->sys_freq)) {
+                    best_score = score;
+                    plan->sample_freq = sample_freq;
+                    plan->vco_freq = vco;
+                    plan->post_div1 = (uint8_t) pd1;
+                    plan->post_div2 = (uint8_t) pd2;
+                    plan->cs_freq_code = cs_freq_code;
+                    plan->sys_freq = sys;
+                    plan->pio_div_q8 = div_q8;
+                    plan->error_ppb = (int32_t) error;
+                }
+            }
+        }
+    }
+
+    return best_score != INT64_MAX;
+}
+
+// a few thousand candidates per rate, done once at boot
+void clock_plan_init(void) {
+    for(uint32_t i = 0; i < CLOCK_PLAN_RATE_COUNT; i++) {
+        clock_plan_compute(plans[i].sample_freq, plans[i].cs_freq_code, &plans[i]);
+    }
+}
+
+const struct clock_plan *clock_plan_get(uint32_t sample_freq) {
+    for(uint32_t i = 0; i < CLOCK_PLAN_RATE_COUNT; i++) {
+        if(plans[i].sample_freq == sample_freq) return &plans[i];
+    }
+    return NULL;
+}
+
+const struct clock_plan *clock_plan_get_index(uint32_t index) {
+    return index < CLOCK_PLAN_RATE_COUNT ? &plans[index] : NULL;
+}
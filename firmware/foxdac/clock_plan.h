@@ -0,0 +1,62 @@
+/*
+ * clock_plan.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_CLOCK_PLAN_H_
+#define FOXDAC_CLOCK_PLAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// every rate S/PDIF can be clocked at: X(rate, IEC 60958-3 channel status sample frequency code)
+// rates that fit a full speed iso packet at 24 bit
+#define CLOCK_PLAN_RATES_BASE(X) \
+    X(32000, 0x3) \
+    X(44100, 0x0) \
+    X(48000, 0x2) \
+    X(88200, 0x8) \
+    X(96000, 0xa)
+
+// 16 bit only over full speed USB (1023 byte packets)
+#define CLOCK_PLAN_RATES_HIGH(X) \
+    X(176400, 0xc) \
+    X(192000, 0xe)
+
+#define CLOCK_PLAN_RATES(X) CLOCK_PLAN_RATES_BASE(X) CLOCK_PLAN_RATES_HIGH(X)
+
+#define CLOCK_PLAN_COUNT_RATE(freq, code) + 1
+#define CLOCK_PLAN_RATE_COUNT (0 CLOCK_PLAN_RATES(CLOCK_PLAN_COUNT_RATE))
+
+#define CLOCK_PLAN_MAX_RATE 192000
+
+// 12MHz crystal, PLL limits from the RP2040 datasheet
+#define CLOCK_PLAN_XOSC_HZ 12000000u
+#define CLOCK_PLAN_VCO_MIN_HZ 750000000u
+#define CLOCK_PLAN_VCO_MAX_HZ 1600000000u
+
+// The DSP needs the bottom end. The top end is well over the RP2040's 133MHz rating, which it
+// runs at with the core at 1.15V instead of the default 1.10V (main raises it before the first
+// PLL change).
+#define CLOCK_PLAN_SYS_MIN_HZ 125000000u
+#define CLOCK_PLAN_SYS_MAX_HZ 200000000u
+
+struct clock_plan {
+    uint32_t sample_freq;
+    uint32_t vco_freq;
+    uint8_t post_div1;
+    uint8_t post_div2;
+    uint8_t cs_freq_code;      // channel status bits 24-27
+    uint32_t sys_freq;         // rounded down, as set_sys_clock_pll reports it
+    uint32_t pio_div_q8;       // PIO clock divider, 16.8; also system clocks per S/PDIF frame
+    int32_t error_ppb;         // achieved rate against sample_freq, crystal assumed exact
+};
+
+void clock_plan_init(void);
+bool clock_plan_compute(uint32_t sample_freq, uint8_t cs_freq_code, struct clock_plan *plan);
+const struct clock_plan *clock_plan_get(uint32_t sample_freq);
+const struct clock_plan *clock_plan_get_index(uint32_t index);
+
+#endif /* FOXDAC_CLOCK_PLAN_H_ */
@@ -0,0 +1,272 @@
+/*
+ * asrc.c
+ *
+ *  Polyphase asynchronous sample rate converter, USB input rate -> ASRC_OUT_FREQ.
+ *
+ *  Each output frame is a ASRC_TAPS tap FIR over the input, with the taps taken from a
+ *  Kaiser windowed sinc sampled at ASRC_PHASES fractional positions and linearly
+ *  interpolated between the two nearest ones. The step between output frames (in input
+ *  frames, Q8.24) follows the S/PDIF rate measured by the USB feedback loop.
+ *
+ *  Coefficients are Q15 and each sample is split into its top 15 and next 9 bits, so
+ *  all 24 bits go through with 32 bit accumulators (no 64 bit multiplies on the M0+).
+ *  The sum of |coefficients| of a phase is a bit over 2.0, so 15 bits is what keeps the
+ *  top accumulator from wrapping on any input.
+ *
+ *  That makes it a ~14 bit converter: THD+N is about -84dB at -1dBFS (host/asrc_test). The
+ *  32 tap, 64 phase filter with exact taps gets to about -90dB, so Q31 taps would buy ~6dB
+ *  for a 32x32 multiply per tap (several times the cost on the M0+). Fine for 16 bit
+ *  sources; 24 bit ones lose their bottom bits, so leave AUDIO_ASRC off for those.
+ *  Output frames are split between core 0 and core 1, each doing both channels so the
+ *  interpolated coefficient is only worked out once.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "asrc.h"
+#include "dsp_pipeline.h"
+
+// prototype low-pass cutoff as a fraction of the lower Nyquist of input and output, and its window
+#define ASRC_CUTOFF 0.92
+#define ASRC_KAISER_BETA 8.0
+
+#define ASRC_HIST_FRAMES (ASRC_TAPS + ASRC_MAX_IN_FRAMES)
+
+// a table of taps per cutoff, all built by asrc_init: index 0 for input rates up to
+// ASRC_OUT_FREQ, then one for each higher input rate it was given
+struct asrc_table {
+    uint32_t in_freq;
+    // one extra phase so phase ASRC_PHASES-1 can interpolate towards the next tap
+    int16_t coeffs[ASRC_PHASES + 1][ASRC_TAPS];
+};
+static struct asrc_table tables[ASRC_MAX_TABLES];
+static uint8_t table_count;
+static const int16_t (*coeffs)[ASRC_TAPS] = tables[0].coeffs;
+
+// input frames not fully used yet, interleaved stereo
+static int32_t hist[2 * ASRC_HIST_FRAMES];
+static uint32_t hist_frames;
+
+// position of the first tap of the next output frame, in input frames, Q8.24
+static uint32_t pos_q24;
+static uint32_t step_q24;
+static uint32_t curr_in_freq = 48000;
+
+// the packet being converted, set up by asrc_begin
+static struct asrc_part {
+    int32_t *out;
+    uint32_t pos;
+    uint32_t count;
+} parts[2];
+static uint32_t run_count;
+
+// output of asrc_block
+static int32_t block_out[2 * ASRC_MAX_OUT_FRAMES];
+
+static double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    for(int k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// cutoff relative to the input Nyquist
+static double asrc_cutoff(uint32_t in_freq) {
+    if(in_freq <= ASRC_OUT_FREQ) return ASRC_CUTOFF;
+    // going down in rate the filter has to stop at the output Nyquist instead
+    return ASRC_CUTOFF * ASRC_OUT_FREQ / in_freq;
+}
+
+// every table at once, the window is the same for all of them; soft float, so ~tens of ms
+// per table, which is why it is done here and not on a rate change
+static void asrc_build_tables(void) {
+    double norm = bessel_i0(ASRC_KAISER_BETA);
+    double cutoff[ASRC_MAX_TABLES];
+    for(int i = 0; i < table_count; i++) {
+        cutoff[i] = asrc_cutoff(tables[i].in_freq);
+    }
+
+    for(int p = 0; p <= ASRC_PHASES; p++) {
+        double f = (double) p / ASRC_PHASES;
+        double c[ASRC_MAX_TABLES][ASRC_TAPS];
+        double sum[ASRC_MAX_TABLES] = { 0 };
+
+        for(int k = 0; k < ASRC_TAPS; k++) {
+            // distance from tap k to the output instant, in input frames
+            double t = f + ASRC_TAPS / 2 - 1 - k;
+            double w = t / (ASRC_TAPS / 2);
+            double win = fabs(w) < 1.0 ? bessel_i0(ASRC_KAISER_BETA * sqrt(1.0 - w * w)) / norm : 0.0;
+            for(int i = 0; i < table_count; i++) {
+                double x = M_PI * cutoff[i] * t;
+                c[i][k] = (x == 0.0 ? 1.0 : sin(x) / x) * win;
+                sum[i] += c[i][k];
+            }
+        }
+
+        // unity DC gain on every phase, otherwise the gain would wobble with the phase
+        for(int i = 0; i < table_count; i++) {
+            for(int k = 0; k < ASRC_TAPS; k++) {
+                tables[i].coeffs[p][k] = (int16_t) lrint(c[i][k] / sum[i] * 32768.0);
+            }
+        }
+    }
+}
+
+// in_freqs are the input rates asrc_reset will be asked for; only those above ASRC_OUT_FREQ
+// need a table of their own
+void asrc_init(const uint32_t *in_freqs, uint8_t count) {
+    tables[0].in_freq = ASRC_OUT_FREQ;
+    table_count = 1;
+    for(int i = 0; i < count && table_count < ASRC_MAX_TABLES; i++) {
+        uint32_t in_freq = in_freqs[i] > ASRC_MAX_IN_FREQ ? ASRC_MAX_IN_FREQ : in_freqs[i];
+        if(in_freq <= ASRC_OUT_FREQ) continue;
+
+        // kept in rising order
+        int t = table_count;
+        while(t > 1 && tables[t - 1].in_freq > in_freq) t--;
+        if(t > 1 && tables[t - 1].in_freq == in_freq) continue;
+        memmove(&tables[t + 1], &tables[t], (table_count - t) * sizeof(tables[0]));
+        tables[t].in_freq = in_freq;
+        table_count++;
+    }
+    asrc_build_tables();
+    asrc_reset(curr_in_freq);
+}
+
+// Cheap enough for the audio IRQ: picks a table, never builds one.
+void asrc_reset(uint32_t in_freq) {
+    if(in_freq < ASRC_MIN_IN_FREQ) in_freq = ASRC_MIN_IN_FREQ;
+    if(in_freq > ASRC_MAX_IN_FREQ) in_freq = ASRC_MAX_IN_FREQ;
+
+    // the table for this rate, else the one of the next rate up (a lower cutoff, so nothing
+    // aliases), else the highest rate there is
+    const struct asrc_table *table = &tables[0];
+    if(in_freq > ASRC_OUT_FREQ && table_count > 1) {
+        int i = 1;
+        while(i < table_count - 1 && tables[i].in_freq < in_freq) i++;
+        table = &tables[i];
+    }
+    coeffs = table->coeffs;
+
+    curr_in_freq = in_freq;
+    step_q24 = (uint32_t) (((uint64_t) in_freq << 24) / ASRC_OUT_FREQ);
+
+    // start on silence so output comes out from the first packet
+    memset(hist, 0, sizeof(hist));
+    hist_frames = ASRC_TAPS - 1;
+    pos_q24 = 0;
+}
+
+// out_frames_per_ms_q16 is the measured S/PDIF rate in USB time, so the step also takes
+// out the difference between our crystal and the host's
+void asrc_set_out_rate(uint32_t out_frames_per_ms_q16) {
+    if(!out_frames_per_ms_q16) return;
+    step_q24 = (uint32_t) (((uint64_t) curr_in_freq << 40) / ((uint64_t) out_frames_per_ms_q16 * 1000u));
+}
+
+static inline int32_t sat_q29(int32_t x) {
+    if(x > 0x1fffffff) return 0x1fffffff;
+    if(x < -0x20000000) return -0x20000000;
+    return x;
+}
+
+static void asrc_run(int32_t *out, uint32_t pos, uint32_t step, uint32_t count) {
+    for(uint32_t n = 0; n < count; n++, pos += step) {
+        const int32_t *x = &hist[2 * (pos >> 24)];
+        uint32_t frac = pos & 0xffffffu;
+        const int16_t *c0 = coeffs[frac >> (24 - ASRC_PHASE_BITS)];
+        const int16_t *c1 = c0 + ASRC_TAPS;
+        int32_t fi = (int32_t) ((frac >> (24 - ASRC_PHASE_BITS - 15)) & 0x7fffu);
+
+        int32_t hl = 0, ll = 0, hr = 0, lr = 0;
+        for(int k = 0; k < ASRC_TAPS; k++) {
+            int32_t c = c0[k] + (((c1[k] - c0[k]) * fi + 0x4000) >> 15);
+            int32_t xl = x[2 * k];
+            int32_t xr = x[2 * k + 1];
+            hl += (xl >> 17) * c;
+            ll += ((xl >> 8) & 0x1ff) * c;
+            hr += (xr >> 17) * c;
+            lr += ((xr >> 8) & 0x1ff) * c;
+        }
+
+        // (hi << 17 + lo << 8) * Q15 -> Q31 is hi * 4 + lo / 128, saturate at a quarter first
+        *out++ = sat_q29(hl + (ll >> 9)) << 2;
+        *out++ = sat_q29(hr + (lr >> 9)) << 2;
+    }
+}
+
+// In and out are interleaved stereo, MSB aligned. Takes in the input frames and returns the
+// number of output frames, which come out of asrc_run_part(0) and (1) (on either core, at the
+// same time) and are final once asrc_end has been called.
+uint32_t asrc_begin(const int32_t *in, uint32_t in_frames, int32_t *out, uint32_t max_out_frames) {
+    parts[0].count = parts[1].count = 0;
+    run_count = 0;
+
+    if(in_frames > ASRC_HIST_FRAMES - hist_frames) in_frames = ASRC_HIST_FRAMES - hist_frames;
+    memcpy(&hist[2 * hist_frames], in, in_frames * 2 * sizeof(int32_t));
+    hist_frames += in_frames;
+
+    // each output frame needs ASRC_TAPS input frames from its first tap on
+    if(hist_frames < ASRC_TAPS) return 0;
+    uint32_t limit = (hist_frames - ASRC_TAPS + 1) << 24;
+    if(pos_q24 >= limit) return 0;
+    uint32_t count = (limit - pos_q24 + step_q24 - 1) / step_q24;
+    if(count > max_out_frames) count = max_out_frames;
+
+    uint32_t half = count / 2;
+    parts[0].out = out;
+    parts[0].pos = pos_q24;
+    parts[0].count = half;
+    parts[1].out = out + 2 * half;
+    parts[1].pos = pos_q24 + half * step_q24;
+    parts[1].count = count - half;
+    run_count = count;
+
+    return count;
+}
+
+void asrc_run_part(uint8_t part) {
+    asrc_run(parts[part].out, parts[part].pos, step_q24, parts[part].count);
+}
+
+void asrc_end(void) {
+    // drop the input frames no later output frame reaches back to
+    pos_q24 += run_count * step_q24;
+    uint32_t used = pos_q24 >> 24;
+    memmove(hist, &hist[2 * used], (hist_frames - used) * 2 * sizeof(int32_t));
+    hist_frames -= used;
+    pos_q24 &= 0xffffffu;
+    run_count = 0;
+}
+
+static void asrc_block_prepare(struct dsp_packet *packet) {
+    packet->frames = asrc_begin(packet->samples, packet->frames, block_out, ASRC_MAX_OUT_FRAMES);
+    packet->samples = block_out;
+}
+
+static void asrc_block_process(const struct dsp_packet *packet, uint8_t part) {
+    (void) packet;
+    asrc_run_part(part);
+}
+
+static void asrc_block_finish(struct dsp_packet *packet) {
+    (void) packet;
+    asrc_end();
+}
+
+const struct dsp_block asrc_block = {
+    .name = "ASRC",
+    .kind = DSP_BLOCK_SPLIT,
+    // per output frame, so counted against input frames it is an overestimate above ASRC_OUT_FREQ
+    .cycles_per_frame = ASRC_TAPS * 22 + 60,
+    .prepare = asrc_block_prepare,
+    .process = asrc_block_process,
+    .finish = asrc_block_finish,
+};
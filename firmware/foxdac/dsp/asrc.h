@@ -0,0 +1,48 @@
+/*
+ * asrc.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_ASRC_H_
+#define FOXDAC_DSP_ASRC_H_
+
+#include <stdint.h>
+
+// rate everything is converted to, S/PDIF and the system clock stay fixed for it
+#define ASRC_OUT_FREQ 96000
+
+#define ASRC_TAPS 32
+#define ASRC_PHASE_BITS 6
+#define ASRC_PHASES (1 << ASRC_PHASE_BITS)
+
+#define ASRC_MIN_IN_FREQ 32000
+#define ASRC_MAX_IN_FREQ 192000
+
+// tap tables: one for every input rate up to ASRC_OUT_FREQ, one per higher rate (176.4k and
+// 192k), ~4k of RAM each
+#define ASRC_MAX_TABLES 3
+
+// input frames per call, one USB packet of up to one frame over nominal
+#define ASRC_MAX_IN_FRAMES (ASRC_MAX_IN_FREQ / 1000 + 1)
+// worst case output for one packet, at the lowest input rate: (in + 2) * out / in + 1
+#define ASRC_MAX_OUT_FRAMES (ASRC_OUT_FREQ / 1000 + 2 * ASRC_OUT_FREQ / ASRC_MIN_IN_FREQ + 2)
+
+// Cycle budget (estimated from the inner loop, ~22 cycles per tap for a stereo frame since the
+// interpolated coefficient is shared by both channels):
+//   ASRC_TAPS * 22 + ~60 = ~760 cycles per stereo output frame
+//   at 96k out that is ~73M cycles/s, split evenly over the two cores: ~19% of each core at 192MHz
+//   (the input rate only changes how often coefficients are rebuilt, not the per frame cost)
+
+// the ASRC as a dsp_pipeline block, runs on every packet and leaves it pointing at its output
+extern const struct dsp_block asrc_block;
+
+void asrc_init(const uint32_t *in_freqs, uint8_t count);
+void asrc_reset(uint32_t in_freq);
+void asrc_set_out_rate(uint32_t out_frames_per_ms_q16);
+uint32_t asrc_begin(const int32_t *in, uint32_t in_frames, int32_t *out, uint32_t max_out_frames);
+void asrc_run_part(uint8_t part);
+void asrc_end(void);
+
+#endif /* FOXDAC_DSP_ASRC_H_ */
@@ -0,0 +1,105 @@
+/*
+ * biquad_cascade.c
+ *
+ *  Portable C version of the EQ cascade kernel, bit exact with biquad_cascade_m0.S, and the
+ *  helpers that pack coefficients into a cascade block.
+ *
+ *  Plain integer C with no SDK dependencies so it can be run on the host.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "biquad_cascade.h"
+#include "mulhs.h"
+
+// the 5 coefficients of each stage in b0 b1 b2 a1 a2 order, Q28, b0 b1 b2 down by the stage's
+// shift (NULL for none)
+void biquad_cascade_set_coeffs(int32_t *block, const int32_t *coeffs, const uint8_t *shifts, uint32_t stages) {
+    for(uint32_t s = 0; s < stages; s++, block += BIQUAD_CASCADE_STAGE_WORDS, coeffs += 5) {
+        for(int i = 0; i < 5; i++) {
+            block[2 + 2 * i] = coeffs[i] >> 16;
+            block[3 + 2 * i] = coeffs[i] & 0xffff;
+        }
+
+        // 1 - a1 - a2 (A(1), the feedback terms being negated) is |1 - p|^2 for the pole pair
+        int64_t a_dc = (int64_t) (1 << 28) - coeffs[3] - coeffs[4];
+        bool lf = a_dc > 0 && a_dc * BIQUAD_CASCADE_LF_DC_GAIN < (int64_t) (1 << 28);
+        if(!lf) {
+            // so the error feedback starts from nothing if the stage comes back to it
+            block[BIQUAD_CASCADE_EF_WORD + 1] = 0;
+            block[BIQUAD_CASCADE_EF_WORD + 2] = 0;
+        }
+        block[BIQUAD_CASCADE_EF_WORD] = (lf ? BIQUAD_CASCADE_EF_LF : 0) |
+                ((shifts ? shifts[s] : 0) << BIQUAD_CASCADE_EF_SHIFT);
+    }
+}
+
+void biquad_cascade_reset(int32_t *block, uint32_t stages) {
+    for(uint32_t s = 0; s <= stages; s++, block += BIQUAD_CASCADE_STAGE_WORDS) {
+        block[0] = 0;
+        block[1] = 0;
+        if(s < stages) {
+            block[BIQUAD_CASCADE_EF_WORD + 1] = 0;
+            block[BIQUAD_CASCADE_EF_WORD + 2] = 0;
+        }
+    }
+}
+
+static inline int32_t sat_q29(int32_t x) {
+    if(x > 0x1fffffff) return 0x1fffffff;
+    if(x < -0x20000000) return -0x20000000;
+    return x;
+}
+
+// (ch:cl) * v in full
+static inline int64_t stage_mac(int64_t acc, const int32_t *c, int32_t v) {
+    return mac64(acc, (int32_t) (((uint32_t) c[0] << 16) | (uint32_t) c[1]), v);
+}
+
+void biquad_cascade_exact_ref(int32_t *samples, uint32_t frames, int32_t *block, uint32_t stages) {
+    for(uint32_t n = 0; n < frames; n++, samples += 2) {
+        int32_t *p = block;
+        int32_t x = *samples >> BIQUAD_CASCADE_HEADROOM_BITS;
+
+        for(uint32_t s = 0; s < stages; s++, p += BIQUAD_CASCADE_STAGE_WORDS) {
+            int32_t x1 = p[0];
+            int32_t x2 = p[1];
+            p[0] = x;
+            p[1] = x1;
+
+            // the whole sum in Q28, rounded once
+            uint32_t ef = (uint32_t) p[BIQUAD_CASCADE_EF_WORD];
+            int64_t acc = stage_mac(0, &p[2], x);
+            acc = stage_mac(acc, &p[4], x1);
+            acc = stage_mac(acc, &p[6], x2);
+            acc = (int64_t) ((uint64_t) acc << (ef >> BIQUAD_CASCADE_EF_SHIFT));
+            acc = stage_mac(acc, &p[8], p[BIQUAD_CASCADE_STAGE_WORDS]);
+            acc = stage_mac(acc, &p[10], p[BIQUAD_CASCADE_STAGE_WORDS + 1]);
+
+            if(ef & BIQUAD_CASCADE_EF_LF) {
+                // low frequency mode: last two rounding errors back in, then keep this one
+                int32_t *e = &p[BIQUAD_CASCADE_EF_WORD + 1];
+                acc += 2 * e[0] - e[1];
+                e[1] = e[0];
+                e[0] = (int32_t) ((uint32_t) acc << BIQUAD_CASCADE_POSTSHIFT) >> BIQUAD_CASCADE_POSTSHIFT;
+            }
+            // an output past 30 bits saturates rather than wrap into the next stage
+            int32_t top = (int32_t) (acc >> 32) >> (29 - BIQUAD_CASCADE_POSTSHIFT);
+            if(top != 0 && top != -1) {
+                x = acc < 0 ? -0x20000000 : 0x1fffffff;
+            } else {
+                x = (int32_t) (((uint64_t) acc + (1u << (31 - BIQUAD_CASCADE_POSTSHIFT))) >> (32 - BIQUAD_CASCADE_POSTSHIFT));
+            }
+        }
+
+        p[1] = p[0];
+        p[0] = x;
+
+        *samples = (int32_t) ((uint32_t) sat_q29(x) << 2);
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * biquad_cascade.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_BIQUAD_CASCADE_H_
+#define FOXDAC_DSP_BIQUAD_CASCADE_H_
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+#endif
+
+// 0 runs the portable C version instead of the hand-scheduled M0+ one (same output bit for bit)
+#ifndef BIQUAD_CASCADE_ASM
+#define BIQUAD_CASCADE_ASM 1
+#endif
+
+// Packed per channel block, walked front to back once per sample:
+//   for each stage: d1 d2 b0h b0l b1h b1l b2h b2l a1h a1l a2h a2l ef e1 e2
+//   then: d1 d2 (last two outputs of the last stage)
+// d1 d2 are the last two inputs of the stage, which are also the last two outputs of the stage
+// before it, so DF1 state is only kept once per line. Coefficients are Q28 (feedback terms
+// negated, as CMSIS) split into the signed top and unsigned bottom 16 bits, so the kernel
+// doesn't have to split them per sample.
+// ef holds the stage's shift and its low frequency mode flag. b0 b1 b2 can
+// be over the 8 Q28 holds (a +20dB shelf's reach 20), so they come shifted down by the shift
+// and the kernel shifts their part of the sum back up before the feedback terms go in.
+// e1 e2 are the low frequency mode: with it on, the part of the sum the rounding to the output
+// drops is kept (e1 e2, Q28 sample fractions) and fed back as 2 e1 - e2. That puts a double
+// zero at DC in the rounding noise's path, against the double pole near DC of a low band, which
+// otherwise amplifies it by up to the stage's DC gain (~95dB for a 64Hz band at 96k) and lets it
+// sit in a limit cycle. biquad_cascade_set_coeffs turns it on for stages whose poles are close
+// enough to DC, see BIQUAD_CASCADE_LF_DC_GAIN.
+#define BIQUAD_CASCADE_STAGE_WORDS 15
+#define BIQUAD_CASCADE_WORDS(stages) (BIQUAD_CASCADE_STAGE_WORDS * (stages) + 2)
+#define BIQUAD_CASCADE_EF_WORD 12
+#define BIQUAD_CASCADE_EF_LF 1
+#define BIQUAD_CASCADE_EF_SHIFT 1
+
+// stages whose feedback DC gain 1 / (1 - a1 - a2) is over this run in the low frequency mode
+#ifndef BIQUAD_CASCADE_LF_DC_GAIN
+#define BIQUAD_CASCADE_LF_DC_GAIN 64
+#endif
+
+// samples go in >> 6 for headroom and come out saturated to 30 bits << 2, like the 16 bit path did;
+// the kernel saturates each stage's output to the same 30 bits (24dB over full scale), so
+// boosts stacked past that clip instead of wrapping round
+#define BIQUAD_CASCADE_HEADROOM_BITS 6
+// Q28 coefficients, high word of the product << 4 is back to the sample scale
+#define BIQUAD_CASCADE_POSTSHIFT 4
+
+// The kernel sums each stage's five products exactly in 64 bits (mulhs.h) and rounds once to
+// the stage output, so a flat EQ is bit transparent; stages in the low frequency mode have the
+// rounding error fed back.
+//
+// Cycles (M0+, zero wait state RAM, single cycle multiplier), per channel, as host/m0_kernel_test.py
+// measures them running the assembled kernel on an instruction level model over cascade_test's
+// cases:
+//   114 per sample per stage in the stage loop, ~13 more in the low frequency mode, 10 more with
+//   b shifted, ~23 per sample outside it
+//   8 stages, 48 frame blocks (eq48, the 4 lowest in the LF mode):
+//                                        987.9 per sample, 123.5 per sample per stage
+//   2 stages, 96 frame blocks (lf96, both in the LF mode):
+//                                        277.5 per sample, 138.7 per sample per stage
+//   ~24% of each core at 48k and ~48% at 96k (199.2MHz) for 8 stages; at 176.4k and 192k the
+//   plan leaves room for fewer (see biquad_eq_set_max_stages)
+// BIQUAD_CASCADE_CYCLES is the worst case per sample, every stage in the LF mode with b shifted.
+#define BIQUAD_CASCADE_CYCLES(stages) (138 * (stages) + 25)
+
+#ifndef __ASSEMBLER__
+void biquad_cascade_set_coeffs(int32_t *block, const int32_t *coeffs, const uint8_t *shifts, uint32_t stages);
+void biquad_cascade_reset(int32_t *block, uint32_t stages);
+
+// runs one channel of interleaved stereo in place: samples points at its first sample, stride 2
+void biquad_cascade_exact_m0(int32_t *samples, uint32_t frames, int32_t *block, uint32_t stages);
+void biquad_cascade_exact_ref(int32_t *samples, uint32_t frames, int32_t *block, uint32_t stages);
+#endif
+
+#if BIQUAD_CASCADE_ASM
+#define biquad_cascade_exact_process biquad_cascade_exact_m0
+#else
+#define biquad_cascade_exact_process biquad_cascade_exact_ref
+#endif
+
+#endif /* FOXDAC_DSP_BIQUAD_CASCADE_H_ */
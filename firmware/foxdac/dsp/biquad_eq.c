@@ -11,93 +11,508 @@
 
 #include "arm_math.h"
 
-#define NUM_EQ_STAGES 8
+#include "biquad_cascade.h"
+#include "biquad_eq.h"
+#include "dsp_pipeline.h"
+#include "limiter.h"
 
 #define FILTER_Q 0.707
 
 #define Q28_SCALE_FACTOR 268435456.0f
-#define COEFF_POSTSHIFT 3
 
-#define TMP_BUFFER_LEN 384
+// a stage that passes its input straight through, what off and flat bands get
+#define Q28_ONE (1 << 28)
 
-static uint8_t eq_enabled = 0;
+// the cascades leave samples this far down (see BIQUAD_CASCADE_HEADROOM_BITS), which is what
+// lets a band boost without clipping; the limiter brings them back up
+#define EQ_LEVEL_SHIFT 4
 
-//static int freq_bands[NUM_EQ_STAGES] = { 32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000 };
-static int freq_bands[NUM_EQ_STAGES] = { 64, 125, 250, 500, 1000, 2000, 4000, 8000 };
-static float freq_band_gains[NUM_EQ_STAGES] = { 0.0f };
+// points the preamp checks the response at, log spaced from 20Hz up (plus every band's centre)
+#define PREAMP_POINTS 64
 
-// 5 coefficients per filter stage, in the following order:
-// b10 b11 b12 a11 a12 .. b20 b21
-static volatile q31_t freq_band_coeffs[5 * NUM_EQ_STAGES];
+static uint8_t eq_enabled = 0;
 
-// 4 vars * NUM_EQ_STAGES bands
-static volatile q31_t biquad_state_l[4 * NUM_EQ_STAGES];
-static volatile q31_t biquad_state_r[4 * NUM_EQ_STAGES];
+static struct biquad_eq_band bands[BIQUAD_EQ_BANDS];
 
-// Temp buffer for scaled-down samples
-static volatile q31_t samples32[TMP_BUFFER_LEN];
+// bands whose parameters changed since the coefficients were last worked out
+static uint32_t dirty_bands = 0;
 
-static int curr_fs = 48000;
+// Coefficients for every sample rate we can be switched to, so a rate change is a pointer swap.
+// 5 coefficients per band (flat and off bands included), in the following order:
+// b10 b11 b12 a11 a12 .. b20 b21
+// each band's b shifted down by its shift (see biquad_eq_design_band), and the preamp (Q30,
+// never above unity) that keeps the peak of the whole response at 0dB.
+// Only written by the UI (biquad_eq_update_coeffs), the cascades run from live_coeffs instead.
+static struct eq_coeff_set {
+    int fs;
+    q31_t coeffs[5 * BIQUAD_EQ_BANDS];
+    uint8_t shifts[BIQUAD_EQ_BANDS];
+    int32_t preamp;
+} coeff_cache[BIQUAD_EQ_MAX_RATES];
+
+static uint8_t coeff_cache_count = 0;
+
+// odd while the UI is writing coeff_cache, bumped again when done
+static volatile uint32_t coeff_seq = 0;
+
+// set for the current rate, picked up at the next packet boundary
+static struct eq_coeff_set *volatile active_set = &coeff_cache[0];
+
+// Bank the cascades run with, the other bank being coeff_cache. Only written at the start
+// of a packet before core 1 is started, so both channels switch on the same sample and a
+// half written set is never used. Filter state is kept across the switch.
+static q31_t live_coeffs[5 * BIQUAD_EQ_BANDS];
+static uint8_t live_shifts[BIQUAD_EQ_BANDS];
+static int32_t live_preamp = LIMITER_UNITY;
+static uint32_t live_seq = ~0u;
+static const struct eq_coeff_set *live_set = NULL;
+
+// Large jumps (a whole encoder detent on a sharp band) are ramped in over a few packets.
+// Peaking stages are second order and the stable (a1, a2) region is a triangle, so every
+// point on the way between two stable sets is stable too. 0 switches straight away.
+#ifndef BIQUAD_EQ_RAMP_PACKETS
+#define BIQUAD_EQ_RAMP_PACKETS 8
+#endif
+// Q28, a coefficient moving further than this starts a ramp (~0.016)
+#define BIQUAD_EQ_RAMP_THRESHOLD (1 << 22)
+
+static q31_t ramp_target[5 * BIQUAD_EQ_BANDS];
+static uint8_t ramp_target_shifts[BIQUAD_EQ_BANDS];
+static q31_t ramp_delta[5 * BIQUAD_EQ_BANDS];
+static int32_t preamp_target, preamp_delta;
+static uint8_t ramp_left = 0;
+
+// Bands in the cascades and how many. Only bands that aren't a straight pass-through with the
+// live coefficients are run, so flat and off bands cost nothing. One that has just gone flat
+// is run for one more packet first, see remap_lines.
+static uint32_t live_bands = 0;
+static uint32_t live_stages = 0;
+static uint32_t live_active = 0;
+static bool drop_pending = false;
+
+// the cap from biquad_eq_set_max_stages, and the one the cascades were last packed with
+static volatile uint8_t max_stages = BIQUAD_EQ_BANDS;
+static uint8_t live_max_stages = BIQUAD_EQ_BANDS;
+
+// coefficients and state packed for the kernel, one per channel
+static int32_t cascade_l[BIQUAD_CASCADE_WORDS(BIQUAD_EQ_BANDS)];
+static int32_t cascade_r[BIQUAD_CASCADE_WORDS(BIQUAD_EQ_BANDS)];
+
+static const float default_freqs[] = { 32, 64, 125, 250, 500, 1000, 2000, 4000, 8000, 16000 };
+
+#if BIQUAD_EQ_BANDS > 10
+#error "BIQUAD_EQ_BANDS > 10 needs more default_freqs"
+#endif
 
-static volatile int sample_cnt = 0;
+static bool band_is_flat(const struct biquad_eq_band *band) {
+    switch(band->type) {
+    case BIQUAD_EQ_PEAKING:
+    case BIQUAD_EQ_LOW_SHELF:
+    case BIQUAD_EQ_HIGH_SHELF:
+        return band->gain == 0.0f;
+    case BIQUAD_EQ_LOW_PASS:
+    case BIQUAD_EQ_HIGH_PASS:
+    case BIQUAD_EQ_NOTCH:
+        return false;
+    default:
+        return true;
+    }
+}
 
-typedef enum {
-   LEFT_CHANNEL,
-   RIGHT_CHANNEL,
-   BOTH_CHANNELS
-} channel_sel_t;
+static float clamp_gain(float gain) {
+    if(gain > BIQUAD_EQ_MAX_GAIN) return BIQUAD_EQ_MAX_GAIN;
+    if(gain < -BIQUAD_EQ_MAX_GAIN) return -BIQUAD_EQ_MAX_GAIN;
+    return gain;
+}
 
 // based on http://www.earlevel.com/scripts/widgets/20131013/biquads2.js
 // equations from http://shepazu.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
-static void calc_biquad_peaking_coeff(double Q, double peakGain, double Fc, double Fs, volatile q31_t* coeffs) {
+// (shelves take Q in place of the script's fixed sqrt(2))
+uint32_t biquad_eq_design_band(const struct biquad_eq_band *band, double Fs, double *ideal, int32_t *coeffs) {
     double norm, a0, a1, a2, b1, b2;
 
+    if(band_is_flat(band)) {
+        coeffs[0] = Q28_ONE;
+        coeffs[1] = coeffs[2] = coeffs[3] = coeffs[4] = 0;
+        if(ideal) {
+            ideal[0] = 1.0;
+            ideal[1] = ideal[2] = ideal[3] = ideal[4] = 0.0;
+        }
+        return 0;
+    }
+
+    double Q = band->q;
+    double Fc = band->freq;
+    double peakGain = clamp_gain(band->gain);
+
+    // keep clear of DC, Nyquist and absurd Qs, whatever the rate
+    if(Fc > 0.45 * Fs) Fc = 0.45 * Fs;
+    if(Fc < 10.0) Fc = 10.0;
+    if(Q < 0.1) Q = 0.1;
+    if(Q > 20.0) Q = 20.0;
+
     double V = pow(10, fabs(peakGain) / 20.0);
     double K = tan(M_PI * (Fc / Fs));
 
-    if(peakGain >= 0) {
-        norm = 1 / (1 + 1/Q * K + K * K);
-        a0 = (1 + V/Q * K + K * K) * norm;
-        a1 = 2 * (K * K - 1) * norm;
-        a2 = (1 - V/Q * K + K * K) * norm;
-        b1 = a1;
-        b2 = (1 - 1/Q * K + K * K) * norm;
-    } else {
-        norm = 1 / (1 + V/Q * K + K * K);
-        a0 = (1 + 1/Q * K + K * K) * norm;
+    switch(band->type) {
+    default:
+    case BIQUAD_EQ_PEAKING:
+        if(peakGain >= 0) {
+            norm = 1 / (1 + 1/Q * K + K * K);
+            a0 = (1 + V/Q * K + K * K) * norm;
+            a1 = 2 * (K * K - 1) * norm;
+            a2 = (1 - V/Q * K + K * K) * norm;
+            b1 = a1;
+            b2 = (1 - 1/Q * K + K * K) * norm;
+        } else {
+            norm = 1 / (1 + V/Q * K + K * K);
+            a0 = (1 + 1/Q * K + K * K) * norm;
+            a1 = 2 * (K * K - 1) * norm;
+            a2 = (1 - 1/Q * K + K * K) * norm;
+            b1 = a1;
+            b2 = (1 - V/Q * K + K * K) * norm;
+        }
+        break;
+    case BIQUAD_EQ_LOW_SHELF:
+        if(peakGain >= 0) {
+            norm = 1 / (1 + 1/Q * K + K * K);
+            a0 = (1 + sqrt(V)/Q * K + V * K * K) * norm;
+            a1 = 2 * (V * K * K - 1) * norm;
+            a2 = (1 - sqrt(V)/Q * K + V * K * K) * norm;
+            b1 = 2 * (K * K - 1) * norm;
+            b2 = (1 - 1/Q * K + K * K) * norm;
+        } else {
+            norm = 1 / (1 + sqrt(V)/Q * K + V * K * K);
+            a0 = (1 + 1/Q * K + K * K) * norm;
+            a1 = 2 * (K * K - 1) * norm;
+            a2 = (1 - 1/Q * K + K * K) * norm;
+            b1 = 2 * (V * K * K - 1) * norm;
+            b2 = (1 - sqrt(V)/Q * K + V * K * K) * norm;
+        }
+        break;
+    case BIQUAD_EQ_HIGH_SHELF:
+        if(peakGain >= 0) {
+            norm = 1 / (1 + 1/Q * K + K * K);
+            a0 = (V + sqrt(V)/Q * K + K * K) * norm;
+            a1 = 2 * (K * K - V) * norm;
+            a2 = (V - sqrt(V)/Q * K + K * K) * norm;
+            b1 = 2 * (K * K - 1) * norm;
+            b2 = (1 - 1/Q * K + K * K) * norm;
+        } else {
+            norm = 1 / (V + sqrt(V)/Q * K + K * K);
+            a0 = (1 + 1/Q * K + K * K) * norm;
+            a1 = 2 * (K * K - 1) * norm;
+            a2 = (1 - 1/Q * K + K * K) * norm;
+            b1 = 2 * (K * K - V) * norm;
+            b2 = (V - sqrt(V)/Q * K + K * K) * norm;
+        }
+        break;
+    case BIQUAD_EQ_LOW_PASS:
+        norm = 1 / (1 + K / Q + K * K);
+        a0 = K * K * norm;
+        a1 = 2 * a0;
+        a2 = a0;
+        b1 = 2 * (K * K - 1) * norm;
+        b2 = (1 - K / Q + K * K) * norm;
+        break;
+    case BIQUAD_EQ_HIGH_PASS:
+        norm = 1 / (1 + K / Q + K * K);
+        a0 = 1 * norm;
+        a1 = -2 * a0;
+        a2 = a0;
+        b1 = 2 * (K * K - 1) * norm;
+        b2 = (1 - K / Q + K * K) * norm;
+        break;
+    case BIQUAD_EQ_NOTCH:
+        norm = 1 / (1 + K / Q + K * K);
+        a0 = (1 + K * K) * norm;
         a1 = 2 * (K * K - 1) * norm;
-        a2 = (1 - 1/Q * K + K * K) * norm;
+        a2 = a0;
         b1 = a1;
-        b2 = (1 - V/Q * K + K * K) * norm;
+        b2 = (1 - K / Q + K * K) * norm;
+        break;
     }
 
     // negate feedback terms for CMSIS
     b1 *= -1.0;
     b2 *= -1.0;
 
-    // store as Q28 + postshift 3 for Q31
-    coeffs[0] = clip_q63_to_q31((q63_t) (a0 * Q28_SCALE_FACTOR)); // b10
-    coeffs[1] = clip_q63_to_q31((q63_t) (a1 * Q28_SCALE_FACTOR)); // b11
-    coeffs[2] = clip_q63_to_q31((q63_t) (a2 * Q28_SCALE_FACTOR)); // b12
-    coeffs[3] = clip_q63_to_q31((q63_t) (b1 * Q28_SCALE_FACTOR)); // a11
-    coeffs[4] = clip_q63_to_q31((q63_t) (b2 * Q28_SCALE_FACTOR)); // a12
+    if(ideal) {
+        ideal[0] = a0;
+        ideal[1] = a1;
+        ideal[2] = a2;
+        ideal[3] = b1;
+        ideal[4] = b2;
+    }
+
+    // Boosts can take the feed forward terms well past 4 (~10 for a +20dB high shelf at 100Hz,
+    // ~20 for a +20dB low shelf near 0.45fs), so they are shifted down until they are under it
+    // and the kernel shifts their sum back up (see biquad_cascade.h). The feedback terms of a
+    // stable stage are always under 2.
+    uint32_t shift = 0;
+    double b_max = fmax(fabs(a0), fmax(fabs(a1), fabs(a2)));
+    while(b_max >= 4.0) {
+        b_max *= 0.5;
+        shift++;
+    }
+    double b_scale = ldexp(Q28_SCALE_FACTOR, -(int) shift);
+
+    // store as Q28 + postshift 3 for Q31, rounded
+    coeffs[0] = clip_q63_to_q31(llround(a0 * b_scale)); // b10
+    coeffs[1] = clip_q63_to_q31(llround(a1 * b_scale)); // b11
+    coeffs[2] = clip_q63_to_q31(llround(a2 * b_scale)); // b12
+    coeffs[3] = clip_q63_to_q31(llround(b1 * Q28_SCALE_FACTOR)); // a11
+    coeffs[4] = clip_q63_to_q31(llround(b2 * Q28_SCALE_FACTOR)); // a12
+    return shift;
 }
 
-void biquad_eq_update_coeffs(void) {
-    for(int i = 0; i < NUM_EQ_STAGES; i++) {
-        calc_biquad_peaking_coeff(FILTER_Q, freq_band_gains[i], freq_bands[i], curr_fs, &freq_band_coeffs[i * 5]);
+static bool coeffs_are_unity(const q31_t *c) {
+    return c[0] == Q28_ONE && c[1] == 0 && c[2] == 0 && c[3] == 0 && c[4] == 0;
+}
+
+// |H|^2 of the whole cascade at w (radians per sample), from the quantised coefficients the
+// kernels run with
+static float cascade_power(const struct eq_coeff_set *set, float w) {
+    float c1 = cosf(w), s1 = sinf(w);
+    float c2 = 2.0f * c1 * c1 - 1.0f, s2 = 2.0f * s1 * c1;
+    float power = 1.0f;
+    const q31_t *coeffs = set->coeffs;
+
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++, coeffs += 5) {
+        if(coeffs_are_unity(coeffs)) continue;
+
+        float b_scale = ldexpf(1.0f / Q28_SCALE_FACTOR, set->shifts[i]);
+        float b0 = coeffs[0] * b_scale, b1 = coeffs[1] * b_scale, b2 = coeffs[2] * b_scale;
+        // feedback terms are stored negated
+        float a1 = coeffs[3] / Q28_SCALE_FACTOR, a2 = coeffs[4] / Q28_SCALE_FACTOR;
+
+        float nr = b0 + b1 * c1 + b2 * c2, ni = b1 * s1 + b2 * s2;
+        float dr = 1.0f - a1 * c1 - a2 * c2, di = a1 * s1 + a2 * s2;
+        power *= (nr * nr + ni * ni) / (dr * dr + di * di);
     }
+    return power;
+}
 
-    // (re)init cascades
-    memset((q31_t*) biquad_state_l, 0, 4 * NUM_EQ_STAGES * sizeof(q31_t));
-    memset((q31_t*) biquad_state_r, 0, 4 * NUM_EQ_STAGES * sizeof(q31_t));
+// Gain that brings the highest point of the response down to 0dB, checked on a log grid over
+// the audio band and at each band's centre (where a peak is). A resonance between the points
+// can still be a little over, the limiter takes care of that.
+static int32_t calc_preamp(const struct eq_coeff_set *set) {
+    float fs = (float) set->fs;
+    float top = fs * 0.45f < 20000.0f ? fs * 0.45f : 20000.0f;
+    float ratio = powf(top / 20.0f, 1.0f / (PREAMP_POINTS - 1));
+    float peak = 1.0f;
+
+    float f = 20.0f;
+    for(int i = 0; i < PREAMP_POINTS; i++, f *= ratio) {
+        float p = cascade_power(set, 2.0f * (float) M_PI * f / fs);
+        if(p > peak) peak = p;
+    }
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(band_is_flat(&bands[i])) continue;
+        f = bands[i].freq;
+        if(f > 0.45f * fs) f = 0.45f * fs;
+        if(f < 10.0f) f = 10.0f;
+        float p = cascade_power(set, 2.0f * (float) M_PI * f / fs);
+        if(p > peak) peak = p;
+    }
+
+    if(peak <= 1.0f) return LIMITER_UNITY;
+    return (int32_t) ((float) LIMITER_UNITY / sqrtf(peak));
+}
+
+static void calc_coeff_set(struct eq_coeff_set *set, uint32_t dirty) {
+    // never picked up
+    if(set->fs > BIQUAD_EQ_MAX_FS) return;
+
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(dirty & (1u << i)) {
+            set->shifts[i] = (uint8_t) biquad_eq_design_band(&bands[i], set->fs, NULL, &set->coeffs[i * 5]);
+        }
+    }
+    set->preamp = calc_preamp(set);
+}
+
+// soft float heavy, call from core 1 (the UI) after changing bands, not from an IRQ
+void biquad_eq_update_coeffs(void) {
+    uint32_t dirty = dirty_bands;
+    dirty_bands = 0;
+    if(!dirty) return;
+
+    coeff_seq++;
+    __dmb();
+
+    for(int i = 0; i < coeff_cache_count; i++) {
+        calc_coeff_set(&coeff_cache[i], dirty);
+    }
 
     __dmb();
+    coeff_seq++;
 }
 
+// called from the USB IRQ on a rate change, the new set is picked up with the next packet
 void biquad_eq_set_fs(int fs) {
-    curr_fs = fs;
-    biquad_eq_update_coeffs();
+    // every rate _audio_reconfigure lets through is in the cache
+    for(int i = 0; i < coeff_cache_count; i++) {
+        if(coeff_cache[i].fs == fs) {
+            active_set = &coeff_cache[i];
+            return;
+        }
+    }
+}
+
+// Moves the history lines of a cascade from the bands in old_mask to those in new_mask. A band
+// that isn't run passes its input through, so the signal at any point of the chain is the
+// output of the last band before it that was run, and that's the line a new stage starts with.
+// A dropped stage has to have passed its input through for two samples already: the stage
+// before it carries on with its output line as its own feedback history.
+static void remap_lines(int32_t *block, uint32_t old_mask, uint32_t new_mask) {
+    int32_t lines[2 * (BIQUAD_EQ_BANDS + 1)];
+    uint32_t old_count = 0;
+
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(old_mask & (1u << i)) old_count++;
+    }
+    for(uint32_t k = 0; k <= old_count; k++) {
+        lines[2 * k] = block[k * BIQUAD_CASCADE_STAGE_WORDS];
+        lines[2 * k + 1] = block[k * BIQUAD_CASCADE_STAGE_WORDS + 1];
+    }
+
+    uint32_t k = 0, old_k = 0;
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(new_mask & (1u << i)) {
+            block[k * BIQUAD_CASCADE_STAGE_WORDS] = lines[2 * old_k];
+            block[k * BIQUAD_CASCADE_STAGE_WORDS + 1] = lines[2 * old_k + 1];
+            k++;
+        }
+        if(old_mask & (1u << i)) old_k++;
+    }
+    block[k * BIQUAD_CASCADE_STAGE_WORDS] = lines[2 * old_count];
+    block[k * BIQUAD_CASCADE_STAGE_WORDS + 1] = lines[2 * old_count + 1];
+}
+
+// packs the bands that do something into both cascades
+static void eq_load_cascades(void) {
+    q31_t packed[5 * BIQUAD_EQ_BANDS];
+    uint8_t packed_shifts[BIQUAD_EQ_BANDS];
+    uint32_t active = 0, mask, stages = 0;
+
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(!coeffs_are_unity(&live_coeffs[i * 5])) active |= 1u << i;
+    }
+
+    // bands that went flat since the last packet stay in as pass-throughs for this one
+    mask = active | live_active;
+    live_active = active;
+    drop_pending = mask != active;
+
+    // bands past the cap pass through, like flat ones; it only changes with the rate, which
+    // brings a new filter anyway, so they drop out without the packet of pass-through
+    live_max_stages = max_stages;
+    for(int i = 0, n = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if((mask & (1u << i)) && ++n > live_max_stages) mask &= ~(1u << i);
+    }
+
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        if(mask & (1u << i)) {
+            memcpy(&packed[stages * 5], &live_coeffs[i * 5], 5 * sizeof(q31_t));
+            packed_shifts[stages] = live_shifts[i];
+            stages++;
+        }
+    }
+
+    if(mask != live_bands) {
+        remap_lines(cascade_l, live_bands, mask);
+        remap_lines(cascade_r, live_bands, mask);
+        live_bands = mask;
+        live_stages = stages;
+    }
+
+    biquad_cascade_set_coeffs(cascade_l, packed, packed_shifts, stages);
+    biquad_cascade_set_coeffs(cascade_r, packed, packed_shifts, stages);
+}
+
+// Start of a packet, core 0: copy the set for the current rate into live_coeffs if it changed,
+// or take the next ramp step. A copy torn by a concurrent update is dropped and retried on
+// the next packet, by which time the update has usually finished (it never blocks the audio).
+static void eq_apply_pending(void) {
+    uint32_t seq = coeff_seq;
+    const struct eq_coeff_set *set = active_set;
+    bool changed = ramp_left != 0 || drop_pending || max_stages != live_max_stages;
+
+    if(!(seq & 1) && (seq != live_seq || set != live_set)) {
+        q31_t next[5 * BIQUAD_EQ_BANDS];
+        uint8_t next_shifts[BIQUAD_EQ_BANDS];
+
+        __dmb();
+        memcpy(next, set->coeffs, sizeof(next));
+        memcpy(next_shifts, set->shifts, sizeof(next_shifts));
+        int32_t preamp = set->preamp;
+        __dmb();
+
+        if(coeff_seq == seq) {
+            // a rate change comes with a different filter anyway, don't drag the old one along
+            bool ramp = BIQUAD_EQ_RAMP_PACKETS > 1 && set == live_set;
+            if(ramp) {
+                ramp = false;
+                for(int i = 0; i < 5 * BIQUAD_EQ_BANDS; i++) {
+                    int32_t d = next[i] - live_coeffs[i];
+                    if(d > BIQUAD_EQ_RAMP_THRESHOLD || d < -BIQUAD_EQ_RAMP_THRESHOLD) ramp = true;
+                    if(next_shifts[i / 5] != live_shifts[i / 5]) ramp = true;
+                }
+            }
+
+            if(ramp) {
+                // from wherever the last ramp got to; a band whose shift changes ramps with its
+                // b at the larger of the two shifts and lands on its own at the end
+                for(int b = 0; b < BIQUAD_EQ_BANDS; b++) {
+                    uint8_t shift = next_shifts[b] > live_shifts[b] ? next_shifts[b] : live_shifts[b];
+                    for(int i = 5 * b; i < 5 * b + 5; i++) {
+                        int32_t to = next[i];
+                        if(i < 5 * b + 3) {
+                            live_coeffs[i] >>= shift - live_shifts[b];
+                            to >>= shift - next_shifts[b];
+                        }
+                        ramp_target[i] = next[i];
+                        ramp_delta[i] = (to - live_coeffs[i]) / BIQUAD_EQ_RAMP_PACKETS;
+                    }
+                    live_shifts[b] = shift;
+                    ramp_target_shifts[b] = next_shifts[b];
+                }
+                // the preamp follows the response down, or the limiter would have to
+                preamp_target = preamp;
+                preamp_delta = (preamp - live_preamp) / BIQUAD_EQ_RAMP_PACKETS;
+                ramp_left = BIQUAD_EQ_RAMP_PACKETS;
+            } else {
+                memcpy(live_coeffs, next, sizeof(live_coeffs));
+                memcpy(live_shifts, next_shifts, sizeof(live_shifts));
+                live_preamp = preamp;
+                ramp_left = 0;
+            }
+
+            live_seq = seq;
+            live_set = set;
+            changed = true;
+        }
+    }
+
+    if(ramp_left) {
+        if(--ramp_left) {
+            for(int i = 0; i < 5 * BIQUAD_EQ_BANDS; i++) {
+                live_coeffs[i] += ramp_delta[i];
+            }
+            live_preamp += preamp_delta;
+        } else {
+            // land exactly on the target whatever the rounding of the steps, so a band ramped
+            // to flat drops out of the cascade
+            memcpy(live_coeffs, ramp_target, sizeof(live_coeffs));
+            memcpy(live_shifts, ramp_target_shifts, sizeof(live_shifts));
+            live_preamp = preamp_target;
+        }
+    }
+
+    if(changed) {
+        eq_load_cascades();
+    }
 }
 
 void biquad_eq_set_enabled(uint8_t enabled) {
@@ -108,227 +523,175 @@ uint8_t biquad_eq_get_enabled(void) {
     return eq_enabled;
 }
 
-void biquad_eq_set_stage_gain(uint8_t stage, float gain) {
-    if(stage >= NUM_EQ_STAGES) return;
-    freq_band_gains[stage] = gain;
-}
+// octave spaced flat peaking bands around the middle of default_freqs
+void biquad_eq_get_default_band(uint8_t band, struct biquad_eq_band *params) {
+    const int first = (count_of(default_freqs) + 1 - BIQUAD_EQ_BANDS) / 2;
 
-//static int mulhs(int u, int v) {
-//    unsigned u0, v0, w0;
-//    int u1, v1, w1, w2, t;
-//    u0 = u & 0xFFFF; u1 = u >> 16;
-//    v0 = v & 0xFFFF; v1 = v >> 16;
-//    w0 = u0*v0;
-//    t = u1*v0 + (w0 >> 16);
-//    w1 = t & 0xFFFF;
-//    w2 = t >> 16;
-//    w1 = u0*v1 + w1;
-//    return u1*v1 + w2 + (w1 >> 16);
-//}
-
-// Based on https://community.arm.com/developer/ip-products/processors/f/cortex-m-forum/49526/mulshift32-in-14-cycles
-static inline int mulhs(int a, int b) {
-    register int t0, t1;
-    __asm__ volatile (
-            " .syntax unified\n"
-
-            "asrs %[t1], %[a], #16 //Factor0 hi [16:31] \n"
-            "uxth %[a], %[a] //Factor0 lo [0:15] \n"
-            "uxth %[t0], %[b] //Factor1 lo [0:15] \n"
-            "asrs %[b], %[b], #16 //Factor1 hi [16:31] \n"
-
-            "muls %[a], %[b] //Factor0 lo * Factor1 hi \n"
-            "muls %[t0], %[t1] //Factor1 lo * Factor0 hi \n"
-            "muls %[b], %[t1] //Factor1 hi * Factor0 hi \n"
-
-            "adds %[a], %[t0] //(Factor0 lo * Factor1 hi) + (Factor1 lo * Factor0 hi) \n"
-
-            // TODO surely this is important? but output is 1 off with negative numbers
-            //"movs %[t0], #0 \n"
-            //"adcs %[t0], %[t0] //C --> bit 16 (t0 contains $00000000 or $00010000) \n"
-            //"lsls %[t0], %[t0], #16 // \n"
-
-            "asrs %[t1], %[a], #16 //Extract partial result [bits 16-31] \n"
-
-            //"adds %[t0], %[t1] //Partial [bits 16-47] \n"
-            "adds %[b], %[t1] //Results [bit 32-63] \n" // should be t0
-
-            : [a] "+l" (a), [b] "+l" (b), [t0] "+l" (t0), [t1] "+l" (t1)
-            : );
-    return b;
+    params->type = BIQUAD_EQ_PEAKING;
+    params->freq = default_freqs[(first + band) % count_of(default_freqs)];
+    params->q = FILTER_Q;
+    params->gain = 0.0f;
 }
 
-//static int mulhs(int a, int b) {
-//    register int t0, t1, t2;
-//    __asm__ volatile (
-//            " .syntax unified\n"
-//
-//            "uxth    %[t0],%[a]           // b \n"
-//            "asrs    %[a],%[a],#16       // a \n"
-//            "asrs    %[t1],%[b],#16       // c \n"
-//            "uxth    %[b],%[b]           // d \n"
-//            "movs    %[t2],%[b]           // d \n"
-//
-//            "muls    %[b],%[t0]           // bd \n"
-//            "muls    %[t2],%[a]           // ad \n"
-//            "muls    %[a],%[t1]           // ac \n"
-//            "muls    %[t1],%[t0]           // bc \n"
-//
-//            "lsls    %[t0],%[t2],#16 \n"
-//            "asrs    %[t2],%[t2],#16 \n"
-//            "adds    %[b],%[t0] \n"
-//            "adcs    %[a],%[t2] \n"
-//            "lsls    %[t0],%[t1],#16 \n"
-//            "asrs    %[t1],%[t1],#16 \n"
-//            "adds    %[b],%[t0] \n"
-//            "adcs    %[a],%[t1] \n"
-//
-//            : [a] "+l" (a), [b] "+l" (b), [t0] "+l" (t0), [t1] "+l" (t1), [t2] "+l" (t2)
-//            : );
-//    return a;
-//}
-
-static void biquad_step(volatile q31_t *pIn, volatile q31_t *pOut, volatile q31_t *pStateLeft,
-        volatile q31_t *pStateRight, volatile q31_t *pCoeffs, uint32_t blockSize, channel_sel_t channel_sel) {
-    // Reading the coefficients
-    const q31_t b0 = pCoeffs[0];
-    const q31_t b1 = pCoeffs[1];
-    const q31_t b2 = pCoeffs[2];
-    const q31_t a1 = pCoeffs[3];
-    const q31_t a2 = pCoeffs[4];
-
-    volatile q31_t *pState = (channel_sel == RIGHT_CHANNEL) ? pStateRight : pStateLeft;
-
-    // Reading the pState values
-    q31_t Xn1 = pState[0];
-    q31_t Xn2 = pState[1];
-    q31_t Yn1 = pState[2];
-    q31_t Yn2 = pState[3];
-
-    int stride = channel_sel == BOTH_CHANNELS ? 1 : 2;
-#pragma GCC unroll 4
-    for(int i = (channel_sel == RIGHT_CHANNEL) ? 1 : 0; i < blockSize * 2; i += stride) {
-
-#ifdef ENABLE_BOTH_CHANNELS
-        if(channel_sel == BOTH_CHANNELS) {
-            pState = (i % 2 == 0) ? pStateLeft : pStateRight;
-
-            Xn1 = pState[0];
-            Xn2 = pState[1];
-            Yn1 = pState[2];
-            Yn2 = pState[3];
-        }
-#endif
+void biquad_eq_get_band(uint8_t band, struct biquad_eq_band *params) {
+    if(band >= BIQUAD_EQ_BANDS) return;
+    *params = bands[band];
+}
 
-        // Read the input
-        q31_t Xn = pIn[i];
-
-        // acc =  b0 * x[n] + b1 * x[n-1] + b2 * x[n-2] + a1 * y[n-1] + a2 * y[n-2]
-        q31_t acc = mulhs(b0, Xn) + mulhs(b1, Xn1) + mulhs(b2, Xn2) + mulhs(a1, Yn1) + mulhs(a2, Yn2);
-
-        // The result is converted to 1.31
-        acc = acc << COEFF_POSTSHIFT + 1;
-
-        // Store output in destination buffer.
-        pOut[i] = acc;
-
-        /* Every time after the output is computed state should be updated.
-         * The states should be updated as:
-         * Xn2 = Xn1
-         * Xn1 = Xn
-         * Yn2 = Yn1
-         * Yn1 = acc */
-        Xn2 = Xn1;
-        Xn1 = Xn;
-        Yn2 = Yn1;
-        Yn1 = (q31_t) acc;
-
-#ifdef ENABLE_BOTH_CHANNELS
-        if(channel_sel == BOTH_CHANNELS) {
-            // Store the updated state variables back into the pState array
-            pState[0] = Xn1;
-            pState[1] = Xn2;
-            pState[2] = Yn1;
-            pState[3] = Yn2;
-        }
-#endif
+// call biquad_eq_update_coeffs after a batch of these
+void biquad_eq_set_band(uint8_t band, const struct biquad_eq_band *params) {
+    if(band >= BIQUAD_EQ_BANDS) return;
+    if(params->type >= BIQUAD_EQ_TYPE_COUNT) return;
+    struct biquad_eq_band b = *params;
+    b.gain = clamp_gain(b.gain);
+    if(bands[band].type != b.type || bands[band].freq != b.freq ||
+            bands[band].q != b.q || bands[band].gain != b.gain) {
+        dirty_bands |= 1u << band;
     }
+    bands[band] = b;
+}
 
-    // Store the updated state variables back into the pState array
-    pState[0] = Xn1;
-    pState[1] = Xn2;
-    pState[2] = Yn1;
-    pState[3] = Yn2;
+void biquad_eq_set_band_gain(uint8_t band, float gain) {
+    if(band >= BIQUAD_EQ_BANDS) return;
+    gain = clamp_gain(gain);
+    if(bands[band].gain != gain) dirty_bands |= 1u << band;
+    bands[band].gain = gain;
 }
 
-void biquad_eq_init(void) {
-    // TODO read stored gains
-    freq_band_gains[0] = 0;
-    freq_band_gains[1] = 0;
-    freq_band_gains[2] = 0;
-    freq_band_gains[3] = 0;
-    freq_band_gains[4] = 0;
-    freq_band_gains[5] = 0;
-    freq_band_gains[6] = 0;
-    freq_band_gains[7] = 0;
-
-    // calculate default coefficients and init cascades
+void biquad_eq_init(const uint32_t *rates, uint8_t rate_count) {
+    if(rate_count > BIQUAD_EQ_MAX_RATES) rate_count = BIQUAD_EQ_MAX_RATES;
+    for(int i = 0; i < rate_count; i++) {
+        coeff_cache[i].fs = (int) rates[i];
+    }
+    coeff_cache_count = rate_count;
+    active_set = &coeff_cache[0];
+
+    // flat until the UI loads the stored bands
+    for(int i = 0; i < BIQUAD_EQ_BANDS; i++) {
+        biquad_eq_get_default_band(i, &bands[i]);
+    }
+
+    // calculate default coefficients for every rate and init cascades
+    dirty_bands = (1u << BIQUAD_EQ_BANDS) - 1;
     biquad_eq_update_coeffs();
-}
 
-static void core1_irq_handler() {
-    while(multicore_fifo_rvalid()) {
-        multicore_fifo_pop_blocking();
+    biquad_cascade_reset(cascade_l, BIQUAD_EQ_BANDS);
+    biquad_cascade_reset(cascade_r, BIQUAD_EQ_BANDS);
+    limiter_reset();
+}
 
-        for(int stage = 0; stage < NUM_EQ_STAGES; stage++) {
-            biquad_step(samples32, samples32, &biquad_state_l[4 * stage],
-                    &biquad_state_r[4 * stage], &freq_band_coeffs[stage * 5], sample_cnt, RIGHT_CHANNEL);
-        }
+// Kernel cycles per packet on each core (one channel each) are the frames times the per sample
+// figures in biquad_cascade.h, which is all the EQ costs: ~47.4k for 8 active bands at 48k
+// (cascade_test's eq48 as m0_kernel_test runs it), about twice that at 96k.
+// With no active band (EQ off, or every band flat, or a rate over BIQUAD_EQ_MAX_FS) packets
+// aren't even decoded.
+static void eq_cascade(int32_t *samples, uint32_t frames, int32_t *block) {
+    if(live_stages == 0) {
+        // only the scaling and the history line left to do, the C version is as quick at that
+        biquad_cascade_exact_ref(samples, frames, block, 0);
+    } else {
+        biquad_cascade_exact_process(samples, frames, block, live_stages);
     }
+}
 
-    multicore_fifo_clear_irq();
-    multicore_fifo_push_blocking(0);
+void biquad_eq_set_max_stages(uint8_t stages) {
+    if(stages > BIQUAD_EQ_BANDS) stages = BIQUAD_EQ_BANDS;
+    max_stages = stages;
+    biquad_eq_block.cycles_per_frame = BIQUAD_CASCADE_CYCLES(stages);
 }
 
-void biquad_eq_init_core1(void) {
-    multicore_fifo_clear_irq();
-    irq_set_exclusive_handler(SIO_IRQ_PROC1, core1_irq_handler);
-    irq_set_enabled(SIO_IRQ_PROC1, true);
+uint8_t biquad_eq_get_max_stages(void) {
+    return max_stages;
 }
 
-void biquad_eq_process_inplace(int16_t* samples, int16_t len) {
-    if(!eq_enabled) {
-        return;
-    }
+bool biquad_eq_rate_supported(void) {
+    return active_set->fs <= BIQUAD_EQ_MAX_FS;
+}
 
-    sample_cnt = len;
-    assert((sample_cnt * 2) <= TMP_BUFFER_LEN);
+// on, and at a rate it runs at
+static bool eq_running(void) {
+    return eq_enabled && biquad_eq_rate_supported();
+}
 
-    // Scale down and convert to Q31
-    for(int i = 0; i < len * 2; i++) {
-      q31_t Xn = ((q31_t) samples[i]) << 14;
-      samples32[i] = mulhs(0x7FFFFFFF, Xn);
-      samples32[i] = samples32[i] >> 3;
+// Start of every packet, core 0, before biquad_eq_process_channel. Picks up new coefficients
+// (both cores use the same set for the whole packet, even if the rate or gains change meanwhile)
+// and returns false if no band needs running. The packet then doesn't have to be decoded for
+// the EQ: every band flat, with the limiter back up to unity, passes samples straight through.
+bool biquad_eq_begin_packet(void) {
+    if(!eq_running()) {
+        return false;
     }
 
-    __dmb();
+    eq_apply_pending();
 
-    multicore_fifo_push_blocking(0);
+    return live_stages != 0;
+}
 
-    // Run through all cascades
-    for(int stage = 0; stage < NUM_EQ_STAGES; stage++) {
-        biquad_step(samples32, samples32, &biquad_state_l[4 * stage],
-                &biquad_state_r[4 * stage], &freq_band_coeffs[stage * 5], len, LEFT_CHANNEL); // BOTH_CHANNELS
+// For a packet that skipped biquad_eq_process_channel after biquad_eq_begin_packet said no
+// band needs running: the history the cascades would have kept, the last two input frames.
+void biquad_eq_track_bypassed(const int32_t *frames, uint32_t count) {
+    if(!eq_running() || live_stages != 0 || count < 2) {
+        return;
     }
 
-    while(multicore_fifo_rvalid()) {
-        multicore_fifo_pop_blocking();
-    }
+    frames += 2 * (count - 2);
+    cascade_l[0] = frames[2] >> BIQUAD_CASCADE_HEADROOM_BITS;
+    cascade_l[1] = frames[0] >> BIQUAD_CASCADE_HEADROOM_BITS;
+    cascade_r[0] = frames[3] >> BIQUAD_CASCADE_HEADROOM_BITS;
+    cascade_r[1] = frames[1] >> BIQUAD_CASCADE_HEADROOM_BITS;
+}
 
-    __dmb();
+// samples are MSB aligned 32 bit (up to 24 significant bits), interleaved stereo; runs one
+// channel (0 left, 1 right) after biquad_eq_begin_packet, so the two can go on different cores.
+// Each sample goes through all the stages in registers (headroom and saturation included).
+void biquad_eq_process_channel(int32_t *samples, uint32_t frames, uint8_t channel) {
+    eq_cascade(samples + channel, frames, channel ? cascade_r : cascade_l);
+}
 
-    // Convert back to Q16
-    for(int i = 0; i < len * 2; i++) {
-      samples[i] = clip_q31_to_q15(samples32[i] >> 14);
+// what the EQ and the limiter after it do with this packet, they always go together
+static uint8_t eq_run = DSP_BLOCK_SKIP;
+
+static uint8_t eq_block_begin(void) {
+    if(!eq_running()) {
+        limiter_reset();
+        eq_run = DSP_BLOCK_SKIP;
+        return eq_run;
     }
+
+    // Every band flat and the limiter at unity leaves the samples as they are, so undecoded
+    // packets can go straight to the encoder. The limiter has to see every packet until then,
+    // or its gain would jump back up.
+    bool stages = biquad_eq_begin_packet();
+    eq_run = stages || live_preamp != LIMITER_UNITY || !limiter_is_unity() ? DSP_BLOCK_RUN : DSP_BLOCK_IF_DECODED;
+    return eq_run;
 }
+
+static void eq_block_process(const struct dsp_packet *packet, uint8_t channel) {
+    biquad_eq_process_channel(packet->samples, packet->frames, channel);
+}
+
+struct dsp_block biquad_eq_block = {
+    .name = "EQ",
+    .kind = DSP_BLOCK_CHANNEL,
+    // every band active, see biquad_cascade.h
+    .cycles_per_frame = BIQUAD_CASCADE_CYCLES(BIQUAD_EQ_BANDS),
+    .begin = eq_block_begin,
+    .process = eq_block_process,
+};
+
+static uint8_t limiter_block_begin(void) {
+    return eq_run;
+}
+
+static void limiter_block_process(const struct dsp_packet *packet, uint8_t part) {
+    (void) part;
+    limiter_process(packet->samples, packet->frames, live_preamp, EQ_LEVEL_SHIFT);
+}
+
+const struct dsp_block biquad_eq_limiter_block = {
+    .name = "Limit",
+    .kind = DSP_BLOCK_STEREO,
+    .cycles_per_frame = LIMITER_CYCLES_PER_FRAME,
+    .begin = limiter_block_begin,
+    .process = limiter_block_process,
+};
@@ -8,14 +8,76 @@
 #ifndef FOXDAC_DSP_BIQUAD_EQ_H_
 #define FOXDAC_DSP_BIQUAD_EQ_H_
 
+#include <stdint.h>
+#include <stdbool.h>
 
-void biquad_eq_init(void);
-void biquad_eq_init_core1(void);
+// sample rates coefficients are kept ready for
+#define BIQUAD_EQ_MAX_RATES 8
+
+// number of bands, each one biquad stage (up to 10 have default frequencies)
+#ifndef BIQUAD_EQ_BANDS
+#define BIQUAD_EQ_BANDS 8
+#endif
+
+// Highest rate the EQ runs at; above it the EQ passes audio through as if it were off and
+// biquad_eq_rate_supported says so. At 176.4k and 192k every band doesn't fit in the time a
+// packet has (see biquad_cascade.h), audio_plan_dsp caps the stages with biquad_eq_set_max_stages.
+#ifndef BIQUAD_EQ_MAX_FS
+#define BIQUAD_EQ_MAX_FS 192000
+#endif
+
+enum biquad_eq_type {
+    BIQUAD_EQ_OFF = 0,
+    BIQUAD_EQ_PEAKING,
+    BIQUAD_EQ_LOW_SHELF,
+    BIQUAD_EQ_HIGH_SHELF,
+    BIQUAD_EQ_LOW_PASS,
+    BIQUAD_EQ_HIGH_PASS,
+    BIQUAD_EQ_NOTCH,
+    BIQUAD_EQ_TYPE_COUNT
+};
+
+// Gain is ignored by the pass and notch types; off bands and peaking or shelf bands at 0dB
+// aren't run at all. The UI stores each field on its own (eq_curve.c), a new one needs a new
+// version of that format.
+struct biquad_eq_band {
+    uint8_t type;   // enum biquad_eq_type
+    float freq;     // Hz, centre or corner
+    float q;
+    float gain;     // dB
+};
+
+// gains are clamped to +-this, dB: the range eq_analysis checks every type over, and boosts
+// stacked past the cascade's headroom clip at the stage outputs (see biquad_cascade.h)
+#define BIQUAD_EQ_MAX_GAIN 20
+
+// the EQ as a dsp_pipeline block, both channels at once on the two cores; its cycles follow
+// biquad_eq_set_max_stages
+extern struct dsp_block biquad_eq_block;
+// and the preamp and peak limiter that has to come straight after it, on whichever core has time
+extern const struct dsp_block biquad_eq_limiter_block;
+
+void biquad_eq_init(const uint32_t *rates, uint8_t rate_count);
 void biquad_eq_update_coeffs(void);
 uint8_t biquad_eq_get_enabled(void);
 void biquad_eq_set_enabled(uint8_t enabled);
 void biquad_eq_set_fs(int fs);
-void biquad_eq_process_inplace(int16_t* samples, int16_t len);
-void biquad_eq_set_stage_gain(uint8_t stage, float gain);
+// false while the rate is over BIQUAD_EQ_MAX_FS, for the UI
+bool biquad_eq_rate_supported(void);
+// Most bands run at once, the first active ones in band order (the rest pass through), from
+// the deferred IRQ when it plans the DSP chain; BIQUAD_EQ_BANDS for all of them
+void biquad_eq_set_max_stages(uint8_t stages);
+uint8_t biquad_eq_get_max_stages(void);
+bool biquad_eq_begin_packet(void);
+void biquad_eq_process_channel(int32_t *samples, uint32_t frames, uint8_t channel);
+void biquad_eq_track_bypassed(const int32_t *frames, uint32_t count);
+void biquad_eq_get_default_band(uint8_t band, struct biquad_eq_band *params);
+void biquad_eq_get_band(uint8_t band, struct biquad_eq_band *params);
+void biquad_eq_set_band(uint8_t band, const struct biquad_eq_band *params);
+void biquad_eq_set_band_gain(uint8_t band, float gain);
+// A band's Q28 coefficients at rate fs (b0 b1 b2 a1 a2, feedback terms negated), and the
+// unquantised ones in ideal if not NULL. Returns the shift b0 b1 b2 are down by (all under 4
+// after it), for biquad_cascade_set_coeffs.
+uint32_t biquad_eq_design_band(const struct biquad_eq_band *band, double fs, double *ideal, int32_t *coeffs);
 
 #endif /* FOXDAC_DSP_BIQUAD_EQ_H_ */
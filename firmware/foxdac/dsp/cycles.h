@@ -0,0 +1,46 @@
+/*
+ * cycles.h
+ *
+ *  Cycle counts for the load figures: SysTick of the core it runs on, counting clk_sys down
+ *  from 2^24 - 1, so a span must stay under 2^24 cycles (87ms at 192MHz). The host build
+ *  counts ns.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_CYCLES_H_
+#define FOXDAC_DSP_CYCLES_H_
+
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_6M__)
+#include "hardware/structs/systick.h"
+
+static inline uint32_t cycles_now(void) {
+    if(!(systick_hw->csr & 1)) {
+        systick_hw->rvr = 0xffffff;
+        systick_hw->cvr = 0;
+        systick_hw->csr = 5;    // enabled, on the processor clock, no IRQ
+    }
+    return systick_hw->cvr;
+}
+
+static inline uint32_t cycles_since(uint32_t start) {
+    return (start - systick_hw->cvr) & 0xffffff;
+}
+#else
+#include <time.h>
+
+static inline uint32_t cycles_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ts.tv_sec * 1000000000u + (uint32_t) ts.tv_nsec;
+}
+
+static inline uint32_t cycles_since(uint32_t start) {
+    return cycles_now() - start;
+}
+#endif
+
+#endif /* FOXDAC_DSP_CYCLES_H_ */
@@ -0,0 +1,110 @@
+/*
+ * dither.c
+ *
+ *  Requantisation to 24 bits with TPDF dither and optional error feedback noise shaping. The
+ *  dither comes from a xorshift32 per channel (one step a sample gives both uniform values),
+ *  the feedback works a bit down from full scale so nothing can wrap and the result is clamped
+ *  to 24 bits.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "dither.h"
+#include "dsp_pipeline.h"
+
+// x >> 1, where the feedback is done; 24 bit LSB there
+#define HALF_LSB_BITS (DITHER_DROP_BITS - 1)
+
+static uint8_t mode = DITHER_DEFAULT_MODE;
+
+// per channel, only touched by the core running it
+static struct dither_state {
+    uint32_t rng;
+    int32_t e1, e2;     // last two quantisation errors, at x >> 1
+} state[2] = {
+    { 0x9e3779b9, 0, 0 },
+    { 0x6a09e667, 0, 0 },
+};
+
+void dither_set_mode(uint8_t new_mode) {
+    if(new_mode < DITHER_MODE_COUNT) mode = new_mode;
+}
+
+uint8_t dither_get_mode(void) {
+    return mode;
+}
+
+// true if every sample of the channel already fits in 24 bits
+static bool channel_is_24bit(const int32_t *samples, uint32_t frames) {
+    uint32_t low = 0;
+    for(uint32_t i = 0; i < frames; i++, samples += 2) {
+        low |= (uint32_t) *samples << (32 - DITHER_DROP_BITS);
+        if(low) return false;
+    }
+    return true;
+}
+
+void dither_process_channel(int32_t *samples, uint32_t frames, uint8_t channel) {
+    struct dither_state *st = &state[channel];
+    uint8_t m = mode;
+
+    samples += channel;
+    if(m == DITHER_OFF) return;
+    if(channel_is_24bit(samples, frames)) {
+        // nothing to round, start the feedback afresh next time
+        st->e1 = st->e2 = 0;
+        return;
+    }
+
+    uint32_t rng = st->rng;
+    int32_t e1 = st->e1, e2 = st->e2;
+
+    for(uint32_t i = 0; i < frames; i++, samples += 2) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+
+        // two uniform values of one LSB each (at x >> 1), summed: -1..+1 LSB triangular, plus
+        // half an LSB so the floor below rounds to nearest
+        int32_t d = (int32_t) ((rng & 0x7f) + ((rng >> 8) & 0x7f)) - (1 << HALF_LSB_BITS) + (1 << (HALF_LSB_BITS - 1));
+
+        int32_t v = *samples >> 1;
+        if(m == DITHER_SHAPED_1) {
+            v -= e1;
+        } else if(m == DITHER_SHAPED_2) {
+            v -= 2 * e1 - e2;
+        }
+
+        int32_t q = (v + d) >> HALF_LSB_BITS;
+
+        // the error before clamping, so a clipped peak isn't fed back
+        e2 = e1;
+        e1 = (q << HALF_LSB_BITS) - v;
+
+        if(q > 0x7fffff) q = 0x7fffff;
+        if(q < -0x800000) q = -0x800000;
+        *samples = q << DITHER_DROP_BITS;
+    }
+
+    st->rng = rng;
+    st->e1 = e1;
+    st->e2 = e2;
+}
+
+static uint8_t dither_block_begin(void) {
+    // only decoded packets have anything below 24 bits
+    return mode == DITHER_OFF ? DSP_BLOCK_SKIP : DSP_BLOCK_IF_DECODED;
+}
+
+static void dither_block_process(const struct dsp_packet *packet, uint8_t channel) {
+    dither_process_channel(packet->samples, packet->frames, channel);
+}
+
+const struct dsp_block dither_block = {
+    .name = "Dither",
+    .kind = DSP_BLOCK_CHANNEL,
+    .cycles_per_frame = DITHER_CYCLES_PER_FRAME,
+    .begin = dither_block_begin,
+    .process = dither_block_process,
+};
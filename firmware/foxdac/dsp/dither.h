@@ -0,0 +1,48 @@
+/*
+ * dither.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_DITHER_H_
+#define FOXDAC_DSP_DITHER_H_
+
+#include <stdint.h>
+
+// bits dropped going from the pipeline's 32 bit samples to the 24 S/PDIF carries
+#define DITHER_DROP_BITS 8
+
+enum dither_mode {
+    DITHER_OFF = 0,         // truncated by the encoder, as before
+    DITHER_TPDF,            // +-1 LSB triangular dither, white
+    DITHER_SHAPED_1,        // TPDF, error fed back through 1 - z^-1 (+6dB at Nyquist, less below fs/6)
+    DITHER_SHAPED_2,        // TPDF, error fed back through (1 - z^-1)^2 (+12dB at Nyquist, less below fs/6)
+    DITHER_MODE_COUNT
+};
+
+#ifndef DITHER_DEFAULT_MODE
+#define DITHER_DEFAULT_MODE DITHER_TPDF
+#endif
+
+// Cycle budget (estimated from the inner loop, per sample so per channel and core):
+//   ~12 for the xorshift and the two uniform values, ~16 for loading, rounding, the 24 bit
+//   clamp and storing, +3 first order, +6 second order; up to ~5 to check the channel isn't
+//   already 24 bit (one sample is usually enough)
+//   at 96k (96 frames a packet, one channel per core): ~3.5k cycles per packet per core with
+//   second order shaping, ~1.8% of each core at 192MHz
+#define DITHER_CYCLES_PER_FRAME 36
+
+// the requantiser as a dsp_pipeline block, goes last in the chain
+extern const struct dsp_block dither_block;
+
+// set from the DSP screen (OK), which keeps it across reboots
+void dither_set_mode(uint8_t mode);
+uint8_t dither_get_mode(void);
+
+// Rounds one channel (0 left, 1 right) of interleaved stereo in place to 24 bits (low
+// DITHER_DROP_BITS clear), so the encoder's shift is exact. A channel that is already at 24
+// bits is left alone, so a chain that didn't change the samples stays bit transparent.
+void dither_process_channel(int32_t *samples, uint32_t frames, uint8_t channel);
+
+#endif /* FOXDAC_DSP_DITHER_H_ */
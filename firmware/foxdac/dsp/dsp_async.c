@@ -0,0 +1,110 @@
+/*
+ * dsp_async.c
+ *
+ *  Splits DSP work between the cores without either side waiting for the other. Each round is
+ *  one job per core: core 1 runs its job in the SIO FIFO IRQ, core 0 in its main loop, so the
+ *  IRQ that posts the round only pays for the handoff. Whoever finishes last gets done_irq
+ *  pended on core 0, where the results are picked up.
+ *
+ *  The round number is the queue: posted is only written by dsp_async_post, done[n] only by
+ *  core n once its job for that round has run. The FIFO only rings core 1's bell.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+
+#include "cycles.h"
+#include "dsp_async.h"
+
+static dsp_async_job_t jobs[2];
+static volatile uint32_t posted = 0;
+static volatile uint32_t done[2] = { 0, 0 };
+
+// the FIFO carries the launch handshake until core 1 is up, no bells before that
+static volatile bool core1_ready = false;
+
+// what core 1 has spent in its IRQ since boot, only written there
+static volatile uint32_t core1_cycles = 0;
+
+// core 0 only
+static uint done_irq;
+static uint32_t notified = 0;
+
+static void core1_irq_handler() {
+    uint32_t start = cycles_now();
+
+    while(multicore_fifo_rvalid()) {
+        (void) multicore_fifo_pop_blocking();
+    }
+    multicore_fifo_clear_irq();
+
+    uint32_t round = posted;
+    if(done[1] != round) {
+        __dmb();
+        jobs[1]();
+        __dmb();
+        done[1] = round;
+
+        // core 1 can't pend core 0's IRQs, wake its main loop to do it
+        __sev();
+    }
+
+    core1_cycles += cycles_since(start);
+}
+
+void dsp_async_init_core1(void) {
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler(SIO_IRQ_PROC1, core1_irq_handler);
+    irq_set_enabled(SIO_IRQ_PROC1, true);
+
+    core1_ready = true;
+    // anything posted before now
+    irq_set_pending(SIO_IRQ_PROC1);
+}
+
+void dsp_async_init_core0(uint irq) {
+    done_irq = irq;
+}
+
+void dsp_async_run_core0(void) {
+    uint32_t round = posted;
+    if(done[0] != round) {
+        __dmb();
+        jobs[0]();
+        __dmb();
+        done[0] = round;
+    }
+
+    if(round != notified && done[1] == round && done[0] == round) {
+        notified = round;
+        irq_set_pending(done_irq);
+    }
+}
+
+void dsp_async_post(dsp_async_job_t core0_job, dsp_async_job_t core1_job) {
+    jobs[0] = core0_job;
+    jobs[1] = core1_job;
+    __dmb();
+    posted++;
+
+    // a full FIFO already has a bell in it
+    if(core1_ready && multicore_fifo_wready()) {
+        multicore_fifo_push_blocking(posted);
+    }
+
+    // and core 0's main loop, in case it is about to sleep
+    __sev();
+}
+
+uint32_t dsp_async_core1_cycles(void) {
+    return core1_cycles;
+}
+
+bool dsp_async_busy(void) {
+    uint32_t round = posted;
+    return done[0] != round || done[1] != round;
+}
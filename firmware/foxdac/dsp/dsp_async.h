@@ -0,0 +1,34 @@
+/*
+ * dsp_async.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_DSP_ASYNC_H_
+#define FOXDAC_DSP_DSP_ASYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*dsp_async_job_t)(void);
+
+// call on core 1, its jobs then run in its SIO FIFO IRQ
+void dsp_async_init_core1(void);
+
+// call on core 0 before the first round, done_irq is pended on core 0 each time a round is done
+void dsp_async_init_core0(unsigned int done_irq);
+
+// call from core 0's main loop: runs core 0's job in thread mode, below every IRQ
+void dsp_async_run_core0(void);
+
+// From a core 0 IRQ: hand one job to each core and return straight away. One round is in
+// flight at a time, post the next one once dsp_async_busy() says this one is done.
+void dsp_async_post(dsp_async_job_t core0_job, dsp_async_job_t core1_job);
+bool dsp_async_busy(void);
+
+// cycles core 1 has spent in its IRQ since boot (wraps, take differences), for whatever else
+// runs there to take out of its own count
+uint32_t dsp_async_core1_cycles(void);
+
+#endif /* FOXDAC_DSP_DSP_ASYNC_H_ */
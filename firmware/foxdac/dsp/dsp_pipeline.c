@@ -0,0 +1,221 @@
+/*
+ * dsp_pipeline.c
+ *
+ *  Runs a chain of DSP blocks over each packet on both cores, through dsp_async. The chain is
+ *  cut into rounds, both cores waiting for each other only between rounds:
+ *    consecutive DSP_BLOCK_CHANNEL blocks share a round, each core taking one channel through
+ *    all of them
+ *    a DSP_BLOCK_SPLIT block is a round of its own, each core running one of its parts
+ *    a DSP_BLOCK_STEREO block is a round of its own on one core, the one with less work so far
+ *    (core 0 starting with what its IRQs take)
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stddef.h>
+
+#include "cycles.h"
+#include "dsp_async.h"
+#include "dsp_pipeline.h"
+
+#define CORE_BOTH 2
+
+static const struct dsp_block *blocks[DSP_PIPELINE_MAX_BLOCKS];
+static uint8_t block_count = 0;
+
+// from dsp_pipeline_plan: blocks round_first[r] .. round_first[r + 1] - 1 make round r
+static uint8_t block_core[DSP_PIPELINE_MAX_BLOCKS];
+static uint8_t round_first[DSP_PIPELINE_MAX_BLOCKS + 1];
+static uint8_t round_count = 0;
+static struct dsp_pipeline_load plan_load;
+
+// what every block does with the packet, from dsp_pipeline_begin_packet
+static uint8_t block_run[DSP_PIPELINE_MAX_BLOCKS];
+
+static struct dsp_block_stats stats[DSP_PIPELINE_MAX_BLOCKS];
+
+enum pipeline_state {
+    PIPELINE_IDLE = 0,
+    PIPELINE_RUNNING,
+    PIPELINE_DONE,
+};
+
+// only written on core 0 while no round is in flight, read by both cores' parts
+static struct dsp_packet packet;
+static uint8_t state = PIPELINE_IDLE;
+static uint8_t round;
+static bool round_posted;
+
+bool dsp_pipeline_add(const struct dsp_block *block) {
+    if(block_count == DSP_PIPELINE_MAX_BLOCKS) return false;
+    blocks[block_count++] = block;
+    return true;
+}
+
+bool dsp_pipeline_plan(uint32_t max_frames, uint32_t budget, uint32_t core0_reserve) {
+    uint32_t cycles[2] = { core0_reserve, 0 };
+    uint32_t round_cycles[2] = { 0, 0 };
+    uint32_t critical = 0;
+
+    round_count = 0;
+    for(int i = 0; i < block_count; i++) {
+        const struct dsp_block *b = blocks[i];
+        uint32_t cost = b->cycles_per_frame * max_frames;
+
+        // only channel blocks go on from the round before
+        bool joins = i > 0 && b->kind == DSP_BLOCK_CHANNEL && blocks[i - 1]->kind == DSP_BLOCK_CHANNEL;
+        if(!joins) {
+            critical += round_cycles[0] > round_cycles[1] ? round_cycles[0] : round_cycles[1];
+            round_cycles[0] = round_cycles[1] = 0;
+            round_first[round_count++] = i;
+        }
+
+        if(b->kind == DSP_BLOCK_STEREO) {
+            uint8_t core = cycles[0] < cycles[1] ? 0 : 1;
+            block_core[i] = core;
+            round_cycles[core] += cost;
+            cycles[core] += cost;
+        } else {
+            if(b->kind == DSP_BLOCK_SPLIT) cost /= 2;
+            block_core[i] = CORE_BOTH;
+            for(int core = 0; core < 2; core++) {
+                round_cycles[core] += cost;
+                cycles[core] += cost;
+            }
+        }
+    }
+    critical += round_cycles[0] > round_cycles[1] ? round_cycles[0] : round_cycles[1];
+    round_first[round_count] = block_count;
+
+    plan_load.cycles[0] = cycles[0];
+    plan_load.cycles[1] = cycles[1];
+    plan_load.critical = critical;
+    plan_load.budget = budget;
+    plan_load.reserve = core0_reserve;
+    plan_load.rounds = round_count;
+    plan_load.fits = critical + core0_reserve <= budget;
+
+    return plan_load.fits;
+}
+
+void dsp_pipeline_get_load(struct dsp_pipeline_load *load) {
+    *load = plan_load;
+}
+
+bool dsp_pipeline_begin_packet(void) {
+    bool decode = false;
+    for(int i = 0; i < block_count; i++) {
+        block_run[i] = blocks[i]->begin ? blocks[i]->begin() : DSP_BLOCK_RUN;
+        if(block_run[i] == DSP_BLOCK_RUN) decode = true;
+    }
+    return decode;
+}
+
+// one core's share of the round in flight
+static void run_part(uint8_t core) {
+    for(int i = round_first[round]; i < round_first[round + 1]; i++) {
+        if(block_run[i] == DSP_BLOCK_SKIP) continue;
+        if(block_core[i] != CORE_BOTH && block_core[i] != core) continue;
+
+        uint32_t start = cycles_now();
+        blocks[i]->process(&packet, block_core[i] == CORE_BOTH ? core : 0);
+        uint32_t cycles = cycles_since(start);
+
+        stats[i].last[core] = cycles;
+        if(cycles > stats[i].peak[core]) stats[i].peak[core] = cycles;
+    }
+}
+
+static void core0_part(void) {
+    run_part(0);
+}
+
+static void core1_part(void) {
+    run_part(1);
+}
+
+static bool round_runs(uint8_t r) {
+    for(int i = round_first[r]; i < round_first[r + 1]; i++) {
+        if(block_run[i] != DSP_BLOCK_SKIP) return true;
+    }
+    return false;
+}
+
+// the round in flight (if any) is done: finish it and post the next one that has work
+static void advance(void) {
+    if(round_posted) {
+        for(int i = round_first[round]; i < round_first[round + 1]; i++) {
+            if(block_run[i] != DSP_BLOCK_SKIP && blocks[i]->finish) blocks[i]->finish(&packet);
+        }
+        round++;
+        round_posted = false;
+    }
+
+    while(round < round_count && !round_runs(round)) {
+        round++;
+    }
+    if(round == round_count) {
+        state = PIPELINE_DONE;
+        return;
+    }
+
+    for(int i = round_first[round]; i < round_first[round + 1]; i++) {
+        if(block_run[i] != DSP_BLOCK_SKIP && blocks[i]->prepare) blocks[i]->prepare(&packet);
+    }
+    round_posted = true;
+    dsp_async_post(core0_part, core1_part);
+}
+
+void dsp_pipeline_start(int32_t *samples, uint32_t frames) {
+    packet.samples = samples;
+    packet.frames = frames;
+
+    // the packet is decoded now, so they run too
+    for(int i = 0; i < block_count; i++) {
+        if(block_run[i] == DSP_BLOCK_IF_DECODED) block_run[i] = DSP_BLOCK_RUN;
+    }
+
+    state = PIPELINE_RUNNING;
+    round = 0;
+    round_posted = false;
+    advance();
+}
+
+const struct dsp_packet *dsp_pipeline_poll(void) {
+    while(state == PIPELINE_RUNNING && !dsp_async_busy()) {
+        advance();
+    }
+    if(state != PIPELINE_DONE) return NULL;
+
+    state = PIPELINE_IDLE;
+    return &packet;
+}
+
+bool dsp_pipeline_idle(void) {
+    return state == PIPELINE_IDLE;
+}
+
+uint8_t dsp_pipeline_get_block_count(void) {
+    return block_count;
+}
+
+const char *dsp_pipeline_get_block_name(uint8_t block) {
+    return block < block_count ? blocks[block]->name : NULL;
+}
+
+uint8_t dsp_pipeline_get_block_core(uint8_t block) {
+    return block < block_count ? block_core[block] : CORE_BOTH;
+}
+
+void dsp_pipeline_get_block_stats(uint8_t block, struct dsp_block_stats *block_stats) {
+    if(block >= block_count) return;
+    // each word is written whole by one core, good enough for display
+    *block_stats = stats[block];
+}
+
+void dsp_pipeline_clear_peaks(void) {
+    for(int i = 0; i < block_count; i++) {
+        stats[i].peak[0] = stats[i].peak[1] = 0;
+    }
+}
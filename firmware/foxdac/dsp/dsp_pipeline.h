@@ -0,0 +1,94 @@
+/*
+ * dsp_pipeline.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_DSP_PIPELINE_H_
+#define FOXDAC_DSP_DSP_PIPELINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DSP_PIPELINE_MAX_BLOCKS 8
+
+// the packet going through, interleaved stereo, MSB aligned 32 bit
+struct dsp_packet {
+    int32_t *samples;
+    uint32_t frames;
+};
+
+// how a block's work is split over the two cores
+enum dsp_block_kind {
+    DSP_BLOCK_CHANNEL = 0,  // each channel on its own, left on core 0 and right on core 1 (part = channel)
+    DSP_BLOCK_SPLIT,        // both channels, split by the block itself into parts 0 and 1 (one per core)
+    DSP_BLOCK_STEREO,       // both channels at once on one core (part 0), picked by dsp_pipeline_plan
+};
+
+// what a block does with the next packet, from its begin
+enum dsp_block_run {
+    DSP_BLOCK_SKIP = 0,     // not at all
+    DSP_BLOCK_RUN,          // runs, so the packet has to be decoded
+    DSP_BLOCK_IF_DECODED,   // only runs if another block (or anything else) has the packet decoded
+};
+
+struct dsp_block {
+    const char *name;
+    uint8_t kind;                   // enum dsp_block_kind
+    // worst case per frame, per channel for DSP_BLOCK_CHANNEL and for both channels otherwise
+    uint32_t cycles_per_frame;
+
+    // core 0, at the start of every packet, returns enum dsp_block_run (NULL: always runs)
+    uint8_t (*begin)(void);
+    // core 0, once the blocks before it are done; can change the packet (e.g. point it at the
+    // block's own output). Optional.
+    void (*prepare)(struct dsp_packet *packet);
+    // on either core, at the same time as the other part
+    void (*process)(const struct dsp_packet *packet, uint8_t part);
+    // core 0, once both parts are done. Optional.
+    void (*finish)(struct dsp_packet *packet);
+};
+
+// what dsp_pipeline_plan worked out, per core: the cycles of its parts (core 0's reserve
+// included) and, as both cores wait for each other between rounds, the time the whole chain
+// takes; fits is what dsp_pipeline_plan returned
+struct dsp_pipeline_load {
+    uint32_t cycles[2];
+    uint32_t critical;
+    uint32_t budget;
+    uint32_t reserve;
+    uint8_t rounds;
+    bool fits;
+};
+
+// per block, measured on the core each part ran on (SysTick cycles, ns in the host build)
+struct dsp_block_stats {
+    uint32_t last[2];
+    uint32_t peak[2];
+};
+
+// blocks run in the order they are added; call before dsp_pipeline_plan
+bool dsp_pipeline_add(const struct dsp_block *block);
+// groups the blocks into rounds and the stereo blocks onto cores for packets of up to
+// max_frames, core 0 already having core0_reserve of the budget taken; false if over budget
+bool dsp_pipeline_plan(uint32_t max_frames, uint32_t budget, uint32_t core0_reserve);
+void dsp_pipeline_get_load(struct dsp_pipeline_load *load);
+
+// From the packet IRQ (core 0). begin_packet asks every block about the next packet and returns
+// true if one needs it decoded; start hands the decoded packet to the cores (with the
+// DSP_BLOCK_IF_DECODED blocks in too) and poll, from the IRQ dsp_async pends, returns it once
+// it is through and NULL until then. One packet at a time, start the next one once idle.
+bool dsp_pipeline_begin_packet(void);
+void dsp_pipeline_start(int32_t *samples, uint32_t frames);
+const struct dsp_packet *dsp_pipeline_poll(void);
+bool dsp_pipeline_idle(void);
+
+uint8_t dsp_pipeline_get_block_count(void);
+const char *dsp_pipeline_get_block_name(uint8_t block);
+// 0 or 1 for stereo blocks, 2 for blocks that run on both cores
+uint8_t dsp_pipeline_get_block_core(uint8_t block);
+void dsp_pipeline_get_block_stats(uint8_t block, struct dsp_block_stats *stats);
+void dsp_pipeline_clear_peaks(void);
+
+#endif /* FOXDAC_DSP_DSP_PIPELINE_H_ */
@@ -0,0 +1,66 @@
+/*
+ * halfband.h
+ *
+ *  Half-band lowpass FIRs for decimating by 2, one sample at a time. Every other tap of a
+ *  half-band filter is zero and the centre one is 1/2, so 4K - 1 taps take K multiplies:
+ *    y = x[c] / 2 + sum over k of h[k] * (x[c - 2k - 1] + x[c + 2k + 1])
+ *  Least squares designs (weighted to equiripple) for the analyser ahead of its FFT:
+ *    HALFBAND_NARROW  19 taps, flat to 0.1875 fs (+-0.04dB), -46dB from 0.3125 fs: 96k to 48k,
+ *                     so nothing from 30k up folds below 18k
+ *    HALFBAND_WIDE     7 taps, flat to 0.104 fs, -46dB from 0.396 fs: 192k to 96k, ahead of
+ *                     the narrow one
+ *  Coefficients are Q15, samples q15; the output is rounded and can overshoot q15 a little.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HALFBAND_H_
+#define FOXDAC_DSP_HALFBAND_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HALFBAND_NARROW_PAIRS 5
+#define HALFBAND_WIDE_PAIRS 2
+#define HALFBAND_MAX_TAPS (4 * HALFBAND_NARROW_PAIRS - 1)
+
+static const int32_t halfband_narrow[HALFBAND_NARROW_PAIRS] = { 10266, -3006, 1374, -627, 263 };
+static const int32_t halfband_wide[HALFBAND_WIDE_PAIRS] = { 9535, -1425 };
+
+struct halfband {
+    // every sample twice, taps apart, so the last taps of them are always in one piece
+    int32_t x[2 * HALFBAND_MAX_TAPS];
+    uint8_t pos;
+    bool odd;
+};
+
+static inline void halfband_reset(struct halfband *f) {
+    for(int i = 0; i < 2 * HALFBAND_MAX_TAPS; i++) {
+        f->x[i] = 0;
+    }
+    f->pos = 0;
+    f->odd = false;
+}
+
+// Takes one input sample, true with an output in *y for every second one. Inline with
+// constant pairs and h, so each filter unrolls into its own code.
+static inline bool halfband_push(struct halfband *f, const int32_t *h, int pairs, int32_t in, int32_t *y) {
+    int taps = 4 * pairs - 1;
+    f->x[f->pos] = f->x[f->pos + taps] = in;
+    if(++f->pos == taps) f->pos = 0;
+    f->odd = !f->odd;
+    if(f->odd) return false;
+
+    // oldest first, the centre tap in the middle
+    const int32_t *x = &f->x[f->pos];
+    int c = 2 * pairs - 1;
+    int32_t acc = (x[c] << 14) + (1 << 14);
+    for(int k = 0; k < pairs; k++) {
+        acc += h[k] * (x[c - 2 * k - 1] + x[c + 2 * k + 1]);
+    }
+    *y = acc >> 15;
+    return true;
+}
+
+#endif /* FOXDAC_DSP_HALFBAND_H_ */
@@ -0,0 +1,137 @@
+/*
+ * asrc_test.c
+ *
+ *  THD+N, passband ripple and alias rejection of the ASRC from every planned rate to
+ *  ASRC_OUT_FREQ, packet by packet as the firmware runs it:
+ *    asrc_test
+ *    THD+N   -1dBFS sine at 1k and 10k, the output clock 50ppm off, least squares fit of the
+ *            sine at its output frequency, the rest counted as noise and distortion
+ *    ripple  gain from 20Hz to 20k (or 0.36 of the lower rate) against the mean, peak to peak
+ *    alias   above ASRC_OUT_FREQ only, what is left of a -6dBFS tone at 60k (which would
+ *            alias to 36k)
+ *  Exits 1 if THD+N is over ASRC_TEST_MAX_THDN, ripple over ASRC_TEST_MAX_RIPPLE or an alias
+ *  over ASRC_TEST_MAX_ALIAS.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "asrc.h"
+#include "clock_plan.h"
+
+#define ASRC_TEST_MAX_THDN -80.0
+#define ASRC_TEST_MAX_RIPPLE 0.01
+#define ASRC_TEST_MAX_ALIAS -60.0
+
+#define LIST_RATE(freq, code) freq,
+static const uint32_t rates[] = { CLOCK_PLAN_RATES(LIST_RATE) };
+
+static int32_t out_buf[2 * 2 * (ASRC_OUT_FREQ + ASRC_OUT_FREQ / 10)];
+
+// seconds of a sine at f into the ASRC, left channel; returns output frames, and in *f_norm
+// the sine's frequency in cycles per output frame at the step the ASRC works out
+static uint32_t run(uint32_t fs, double f, double amp, double ppm, int secs, double *f_norm) {
+    uint32_t rate_q16 = (uint32_t) lrint(ASRC_OUT_FREQ / 1000.0 * 65536.0 * (1 + ppm * 1e-6));
+    asrc_reset(fs);
+    asrc_set_out_rate(rate_q16);
+    uint32_t step_q24 = (uint32_t) (((uint64_t) fs << 40) / ((uint64_t) rate_q16 * 1000u));
+    *f_norm = f / fs * step_q24 / 16777216.0;
+
+    static int32_t in[2 * ASRC_MAX_IN_FRAMES];
+    uint32_t out_frames = 0, t = 0, phase = 0;
+    for(int ms = 0; ms < 1000 * secs; ms++) {
+        // 44/45 frame packets at 44.1k, as the host sends them
+        uint32_t frames = (phase + fs) / 1000 - phase / 1000;
+        phase = (phase + fs) % 1000000u;
+        for(uint32_t i = 0; i < frames; i++, t++) {
+            int32_t s = (int32_t) lrint(amp * sin(2 * M_PI * f * t / fs) * 8388607.0) * 256;
+            in[2 * i] = s;
+            in[2 * i + 1] = -s;
+        }
+
+        uint32_t n = asrc_begin(in, frames, &out_buf[2 * out_frames], ASRC_MAX_OUT_FRAMES);
+        asrc_run_part(0);
+        asrc_run_part(1);
+        asrc_end();
+        out_frames += n;
+    }
+    return out_frames;
+}
+
+// fits a sine at f_norm cycles per output frame over the last 3/4; returns THD+N in dB
+static double fit(uint32_t frames, double f_norm, double *amp) {
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for(uint32_t i = frames / 4; i < frames; i++) {
+        double y = out_buf[2 * i] / 2147483648.0;
+        double a = sin(2 * M_PI * f_norm * i), b = cos(2 * M_PI * f_norm * i);
+        ss += a * a;
+        cc += b * b;
+        sc += a * b;
+        ys += y * a;
+        yc += y * b;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+
+    double err = 0, sig = 0;
+    for(uint32_t i = frames / 4; i < frames; i++) {
+        double y = out_buf[2 * i] / 2147483648.0;
+        double m = a * sin(2 * M_PI * f_norm * i) + b * cos(2 * M_PI * f_norm * i);
+        err += (y - m) * (y - m);
+        sig += m * m;
+    }
+    *amp = sqrt(a * a + b * b);
+    return 10 * log10(err / sig);
+}
+
+int main(void) {
+    asrc_init(rates, sizeof(rates) / sizeof(rates[0]));
+
+    int failed = 0;
+    printf("    rate   THD+N 1k  THD+N 10k   ripple dB      to   alias 60k\n");
+    for(uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        uint32_t fs = rates[r];
+        double amp, f_norm;
+
+        uint32_t n = run(fs, 1000, 0.891, 50, 2, &f_norm);
+        double thdn_1k = fit(n, f_norm, &amp);
+        n = run(fs, 10000, 0.891, 50, 2, &f_norm);
+        double thdn_10k = fit(n, f_norm, &amp);
+
+        double lower = fs < ASRC_OUT_FREQ ? fs : ASRC_OUT_FREQ;
+        double top = 0.36 * lower < 20000 ? 0.36 * lower : 20000;
+        double lo = 1e9, hi = -1e9;
+        for(double f = 20; f <= top; f *= 1.25) {
+            n = run(fs, f, 0.5, 0, 1, &f_norm);
+            fit(n, f_norm, &amp);
+            double g = 20 * log10(amp / 0.5);
+            if(g < lo) lo = g;
+            if(g > hi) hi = g;
+        }
+
+        double alias = -INFINITY;
+        if(fs > ASRC_OUT_FREQ) {
+            n = run(fs, 60000, 0.5, 0, 1, &f_norm);
+            double rms = 0;
+            for(uint32_t i = n / 4; i < n; i++) {
+                double y = out_buf[2 * i] / 2147483648.0;
+                rms += y * y;
+            }
+            alias = 20 * log10(sqrt(rms / (n - n / 4)) * sqrt(2) / 0.5);
+        }
+
+        int ok = thdn_1k < ASRC_TEST_MAX_THDN && thdn_10k < ASRC_TEST_MAX_THDN &&
+                hi - lo < ASRC_TEST_MAX_RIPPLE && alias < ASRC_TEST_MAX_ALIAS;
+        printf("  %6u  %9.1f  %9.1f  %10.4f  %6.0f  ", fs, thdn_1k, thdn_10k, hi - lo, top);
+        if(fs > ASRC_OUT_FREQ) {
+            printf("%10.1f  %s\n", alias, ok ? "" : "FAIL");
+        } else {
+            printf("%10s  %s\n", "-", ok ? "" : "FAIL");
+        }
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
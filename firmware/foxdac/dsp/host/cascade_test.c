@@ -0,0 +1,184 @@
+/*
+ * cascade_test.c
+ *
+ *  The C cascade kernel against stored outputs, bit for bit:
+ *    cascade_test       compares, exits 1 on a mismatch
+ *    cascade_test -g    prints cascade_vectors.h from the kernel as it is
+ *    cascade_test -d    prints every case as m0_kernel_test.py runs it on the M0+ kernel: the
+ *                       block before, each packet in and out, the block after
+ *  Regenerate only after changing the kernel on purpose; m0_kernel_test holds the M0+ kernel to
+ *  the C one. Cases: random coefficients as large as the kernel takes (under 2, b0 b1 b2 shifted
+ *  down) on full range samples (saturation), an 8 band EQ at 48k, two low bands at 96k on a
+ *  low level input (the low frequency mode), and +20dB shelves whose b0 b1 b2 only fit shifted
+ *  down, at a low level and at full scale (stage outputs saturating).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "biquad_cascade.h"
+#include "cascade_vectors.h"
+
+// biquad_eq_design_band peaking, Q 0.707: 64Hz to 8k at +12 -6 +3 -12 +6 -3 +9 -9dB, 48k
+static const int32_t eq48_coeffs[] = {
+        273148602, -533690134, 260560260, 533690134, -265273407,
+        265413804, -524685291, 259341732, 524685291, -256320080,
+        270939951, -524448062, 253789057, 524448062, -256293552,
+        237177670, -452413772, 216206832, 452413772, -184949047,
+        291013162, -487295693, 200487386, 487295693, -223065092,
+        252329769, -412043163, 174248702, 412043163, -158143015,
+        395948110, -343485164, 674394, 343485164, -128187048,
+        158773751, -98466484, 38159218, 98466484, 71502486,
+};
+
+// 64Hz +12dB and 125Hz -6dB at 96k, both in the low frequency mode
+static const int32_t lf96_coeffs[] = {
+        270799010, -535280508, 264486193, 535280508, -266849748,
+        266907337, -530726128, 263836552, 530726128, -262308434,
+};
+
+// +20dB high shelf at 100Hz, +20dB low shelf at 20k, +20dB peaking at 1k and +12dB high shelf
+// at 2k, Q 0.707, 48k: b0 b1 b2 shifted down by 3, 2, 0 and 1
+static const int32_t shelf48_coeffs[] = {
+        333427063, -664901928, 331480561, 531901034, -263511152,
+        521326427, 918492419, 410450326, -343485164, -128187048,
+        472602090, -487295693, 18898458, 487295693, -223065092,
+        487330609, -884061632, 404462556, 438343023, -185370635,
+};
+static const uint8_t shelf48_shifts[] = { 3, 2, 0, 1 };
+
+static const uint8_t random_shifts[] = { 2, 0, 1 };
+
+static const struct {
+    const char *name;
+    const int32_t *coeffs;          // NULL for random ones, under 2
+    const uint8_t *shifts;          // of b0 b1 b2, NULL for none
+    uint32_t stages, frames, packets;
+    uint32_t shift;                 // of the random samples
+} cases[] = {
+        { "random", NULL, random_shifts, 3, 45, 3, 0 },
+        { "eq48", eq48_coeffs, NULL, 8, 48, 4, 3 },
+        { "lf96", lf96_coeffs, NULL, 2, 96, 3, 12 },
+        { "shelf48", shelf48_coeffs, shelf48_shifts, 4, 48, 3, 6 },
+        { "shelf48hot", shelf48_coeffs, shelf48_shifts, 4, 48, 3, 0 },
+};
+
+static const struct {
+    const char *name;
+    void (*process)(int32_t *samples, uint32_t frames, int32_t *block, uint32_t stages);
+    const int32_t *expected;
+    uint32_t count;
+} kernels[] = {
+        { "exact", biquad_cascade_exact_ref, cascade_exact_out, sizeof(cascade_exact_out) / sizeof(cascade_exact_out[0]) },
+};
+
+// 32 bit LCG, the same sequence on any host
+static uint32_t lcg;
+
+// right channel samples a kernel wrote
+static uint32_t stray;
+
+// -d output, NULL without
+static FILE *dump;
+
+static void dump_words(const char *tag, const int32_t *w, uint32_t n) {
+    fprintf(dump, "%s", tag);
+    for(uint32_t i = 0; i < n; i++) {
+        fprintf(dump, " %d", w[i]);
+    }
+    fprintf(dump, "\n");
+}
+
+static int32_t next_rand(void) {
+    lcg = lcg * 1664525u + 1013904223u;
+    return (int32_t) lcg;
+}
+
+// runs every case through a kernel, left channel outputs into out; returns how many
+static uint32_t run(uint32_t k, int32_t *out) {
+    static int32_t block[BIQUAD_CASCADE_WORDS(8)];
+    static int32_t samples[2 * 96];
+    uint32_t count = 0;
+
+    for(uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        int32_t coeffs[5 * 8];
+        lcg = c + 1;
+        for(uint32_t i = 0; i < 5 * cases[c].stages; i++) {
+            coeffs[i] = cases[c].coeffs ? cases[c].coeffs[i] : next_rand() >> 2;
+        }
+        biquad_cascade_reset(block, cases[c].stages);
+        biquad_cascade_set_coeffs(block, coeffs, cases[c].shifts, cases[c].stages);
+        uint32_t words = BIQUAD_CASCADE_WORDS(cases[c].stages);
+        if(dump) {
+            fprintf(dump, "case %s %s %u %u\n", cases[c].name, kernels[k].name, cases[c].stages, cases[c].frames);
+            dump_words("block", block, words);
+        }
+
+        for(uint32_t p = 0; p < cases[c].packets; p++) {
+            for(uint32_t i = 0; i < 2 * cases[c].frames; i++) {
+                samples[i] = next_rand() >> cases[c].shift;
+            }
+            if(dump) dump_words("in", samples, 2 * cases[c].frames);
+            int32_t right = samples[1];
+            kernels[k].process(samples, cases[c].frames, block, cases[c].stages);
+            if(samples[1] != right) stray++;
+            if(dump) dump_words("out", samples, 2 * cases[c].frames);
+            for(uint32_t i = 0; i < cases[c].frames; i++) {
+                out[count++] = samples[2 * i];
+            }
+        }
+        if(dump) dump_words("end", block, words);
+    }
+    return count;
+}
+
+static void generate(void) {
+    static int32_t out[1024];
+    printf("/*\n * cascade_vectors.h\n *\n *  Generated by cascade_test -g, see cascade_test.c\n */\n\n");
+    printf("#ifndef FOXDAC_DSP_HOST_CASCADE_VECTORS_H_\n#define FOXDAC_DSP_HOST_CASCADE_VECTORS_H_\n\n");
+    printf("#include <stdint.h>\n");
+    for(uint32_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        uint32_t n = run(k, out);
+        printf("\nstatic const int32_t cascade_%s_out[%u] = {", kernels[k].name, n);
+        for(uint32_t i = 0; i < n; i++) {
+            printf(i % 6 ? " %d," : "\n        %d,", out[i]);
+        }
+        printf("\n};\n");
+    }
+    printf("\n#endif /* FOXDAC_DSP_HOST_CASCADE_VECTORS_H_ */\n");
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && !strcmp(argv[1], "-g")) {
+        generate();
+        return 0;
+    }
+    if(argc > 1 && !strcmp(argv[1], "-d")) {
+        static int32_t out[1024];
+        dump = stdout;
+        for(uint32_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            run(k, out);
+        }
+        return 0;
+    }
+
+    int failed = 0;
+    for(uint32_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        static int32_t out[1024];
+        stray = 0;
+        uint32_t n = run(k, out);
+        uint32_t bad = 0, first = 0;
+        for(uint32_t i = 0; i < n && i < kernels[k].count; i++) {
+            if(out[i] != kernels[k].expected[i] && !bad++) first = i;
+        }
+        int ok = !bad && !stray && n == kernels[k].count;
+        printf("  %-6s %4u samples  %4u mismatched", kernels[k].name, n, bad);
+        if(bad) printf(", first at %u", first);
+        printf("  %s\n", ok ? "" : "FAIL");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,166 @@
+/*
+ * cascade_vectors.h
+ *
+ *  Generated by cascade_test -g, see cascade_test.c
+ */
+
+#ifndef FOXDAC_DSP_HOST_CASCADE_VECTORS_H_
+#define FOXDAC_DSP_HOST_CASCADE_VECTORS_H_
+
+#include <stdint.h>
+
+static const int32_t cascade_exact_out[903] = {
+        -57607472, 932881264, -162156324, -2147483648, 365873848, 2147483644,
+        -2147483648, -2147483648, 2147483644, 2147483644, -2147483648, -2147483648,
+        2147483644, 2147483644, -2147483648, -2147483648, 1909266512, 2147483644,
+        -2147483648, -2147483648, 1909266512, 2147483644, -2147483648, -2147483648,
+        1909266512, 2147483644, -2147483648, -2147483648, 1909266512, 2147483644,
+        -2147483648, -2147483648, 2147483644, 2147483644, -1203041488, -2147483648,
+        -85480544, 2147483644, -2147483648, -2147483648, 2147483644, 2147483644,
+        -2147483648, -2147483648, 1909266512, 2147483644, -2147483648, -2147483648,
+        -30847968, 2147483644, -2147483648, -2147483648, -395473144, 2147483644,
+        -2147483648, -2147483648, 2147483644, 2147483644, -2147483648, -2147483648,
+        1909266512, 2147483644, -70845260, -2147483648, -1485196296, 2147483644,
+        -2147483648, -2147483648, -425819412, 2147483644, -2147483648, -2147483648,
+        1909266512, 2147483644, -2147483648, -2147483648, 932525416, 2147483644,
+        784036980, -2147483648, -2147483648, 2147483644, 2147483644, 2147483644,
+        -2147483648, -676301780, -53637516, 2147483644, -2147483648, -2147483648,
+        2147483644, 2147483644, -2147483648, -2147483648, 1909266512, 2147483644,
+        -2147483648, -2147483648, 1909266512, 2147483644, -2147483648, -2147483648,
+        1188020716, 2147483644, 2147483644, -2147483648, -2147483648, 2147483644,
+        2147483644, -2147483648, -2147483648, 2147483644, 2147483644, -2075474452,
+        -2147483648, 2147483644, 2147483644, -1909266576, -2147483648, 2147483644,
+        2147483644, -1909266576, -2147483648, 2147483644, 2147483644, -1909266576,
+        -2147483648, 2147483644, 2147483644, -1909266576, -2147483648, 2147483644,
+        2147483644, 801426152, -2147483648, 6339560, 5118408, -5937164,
+        6681460, -14821536, -7437760, -15638072, 9872224, -2465744,
+        3764876, -327712, -4854248, 7118424, 3859808, 3964160,
+        -11222788, 8771456, -9059348, 9992704, -7762272, -6004088,
+        -9194368, 5727380, -4990408, -593588, -12425672, 451216,
+        -12482576, 10011292, -10721496, 16054544, 3378144, 7880800,
+        -5084160, -4886956, 922400, -2195772, -534252, -3669520,
+        -2621372, 9646388, -9687908, -2645992, -10179480, 8600436,
+        10402604, -10665472, 1024160, -8514160, 6306848, 3217564,
+        12394724, -11329760, -7704592, 8432508, -2970424, -10104672,
+        10324588, -14867808, 1991592, -15612644, -7064060, -12526216,
+        10401328, -7004224, -3707968, 12648572, 297200, 6174356,
+        4658328, 9302704, -11498368, -3380740, -10827036, -58396,
+        -8545200, -2113084, -489428, -12706868, 5409604, -2362964,
+        8056076, -1414304, -7722888, -13906076, -11770172, -8704020,
+        -15671892, -80916, -7488616, 1863448, -7896284, -11076340,
+        11146848, -6559164, 11736952, -8204920, 8604812, -9902140,
+        5187004, 8275996, -4793924, -9397920, -9412512, 4426824,
+        -17197876, 9069452, 6745644, 5418972, -9506808, 11521580,
+        -11865764, 13123936, -6869252, -12425004, -8015616, 5646772,
+        -12228224, 7520708, -8938952, 10358632, -3030608, -1482040,
+        447444, -13357772, -13730524, 3561976, -81252, 12723880,
+        -8039288, -5265432, -811524, -4617836, -3504592, -10924880,
+        -1773836, -778140, 7646984, 4573532, 3909672, -12080516,
+        1060740, -13232956, 2027292, -3538120, -5091960, 6440364,
+        -10314904, 11543876, -10416632, -3751848, -16426760, -4689256,
+        -15682140, 3230936, -3501580, 14364040, 7709272, -72412,
+        -1235816, -1293316, -10519216, -6274344, -15618072, -4885204,
+        -12565596, -7602872, 2420980, -11168216, 90000, -10774648,
+        -8471428, -6081996, -7688032, 3450268, 8942716, -7111888,
+        -3965912, -8178948, -701788, -10875632, 394624, -8006092,
+        -10271436, 6581492, 8934232, -283456, 10723184, -1118240,
+        -3711832, 3380664, 5541820, 15592, -8212, 25248,
+        -23680, 2276, 10444, -29824, -20324, 10808,
+        18276, -26420, 26852, 23972, -14212, -7652,
+        6980, 17196, 12212, 12016, -21260, 27960,
+        18360, -6524, 19208, 12860, -18132, 3884,
+        27896, 21300, -2088, 7556, 10412, 29996,
+        31552, -28756, -11836, 25656, 18408, 23916,
+        -4100, 11800, -12456, 14428, 32012, 852,
+        5280, -26244, 31660, -3672, 10372, -25212,
+        -10320, 27168, -2536, -18928, -26268, -27024,
+        23124, 9984, 26616, 33740, -27292, 22512,
+        23436, 3772, -2196, -5412, 7488, -19616,
+        -2340, -20184, 24184, 8912, -30280, 27632,
+        -25932, -23132, -13652, 21280, 9592, 22440,
+        -1220, 32076, -27776, 10228, -15488, 400,
+        25752, -19504, -10572, 952, 3816, -5040,
+        -9876, 31300, 19948, -29044, -25380, -12720,
+        -16352, 25568, -22672, 19708, -6756, 25428,
+        5152, 25524, 22048, -29428, -19008, -21812,
+        21844, -23724, -27008, -13196, -16692, -18484,
+        -15588, 11732, 12528, 32432, 26212, 29124,
+        -28412, 28560, 10688, -17628, -10356, -16644,
+        -1832, -9688, 15932, 10960, 3940, 14240,
+        -21128, -30364, 18524, -30180, 31132, 13432,
+        -11452, 29216, 32956, 15772, 10240, -13004,
+        32688, 29408, 20816, -5856, -12552, 14532,
+        -30308, 32912, 24596, 12540, 10740, -28408,
+        4836, -21380, -10200, -5096, 22036, -1912,
+        8440, -19272, 7208, 28608, 17772, -28300,
+        6856, 25224, 27392, -16176, 24276, -12920,
+        5556, -2552, 11508, -8512, -3384, 2496,
+        14492, 20468, -3156, 30672, 9276, -30412,
+        -19204, -22392, 19940, -26952, 15748, 6612,
+        -132, -2320, 2160, 17380, -11388, 9948,
+        23496, 23688, 32620, 4132, -2380, -7356,
+        -8244, 14048, 1888, 244, 25504, -12996,
+        32272, -18172, -18676, 32224, -25008, -7840,
+        -13900, 6248, -4324, -1836, 8508, 2176,
+        30100, -16160, 31348, -26476, 14900, -21988,
+        -18076, 2132, 10192, 6124, 13188, 31504,
+        14476, 28336, 15240, -23832, -6448, -5712,
+        144, 19524, 428, 22272, -12624, -18100,
+        -15744, -30280, 32892, -16408, 14716, -19480,
+        24836, -14452, 1720, 31384, 17004, -30144,
+        25944, -5684, -3092, -21472, 33732, 12716,
+        2264, 9872, 13248, 13980, -6820, 30644,
+        -8688, -4972, 8996, -21304, -12216, -30844,
+        17224, 14736, -9512, 32236, -18828, -24988,
+        13672, 19940, 9156, 491800140, -386506236, -733812424,
+        101940544, -1011205372, -1792738692, -2049625264, -1657592844, 161951036,
+        -177055952, 329851732, 1461148504, 1976076032, 2147483644, 136383304,
+        -1662806848, -1245494236, -2086128568, -2147483648, -2110899988, -1742622932,
+        -948441608, 114894572, 208147160, 615076172, 1120578336, 488025800,
+        1077955100, 1363707740, 1410392132, 453991648, -73177092, -334039852,
+        -548328676, 540046656, 1179678688, 257411756, -1558639800, -1862919328,
+        -1509262240, -1337669924, -1028510296, -1532638628, -701005836, -627373580,
+        -1577724196, -1366505600, -716596424, 261968916, 618969364, 744243588,
+        1440335200, 2025037832, 2147483644, 1401974308, 925764200, -192060120,
+        -258279176, -322300256, -1429087220, 17829844, 1190458092, 628485300,
+        737224716, 1089964012, 990567140, 1128675924, 986510696, 746820584,
+        -252735840, -991148872, -530351432, 36759132, 490094048, -675375588,
+        -484020380, 633532652, -1057179672, -1319583668, -547920736, -1563415596,
+        -2093353412, -1495870884, 129460036, 93856408, -780186908, 5692496,
+        660232552, 1311238776, 845613072, 196789364, 1151041084, 1558324136,
+        1378774220, 999250180, 856614760, 1235022496, 494877604, -616750492,
+        -255173436, 332743472, 762776108, 275698968, -579667172, 88876860,
+        -957125148, -878075440, 257061972, -720923724, -1258996776, -1531931604,
+        -1559127536, -1712851552, -986842744, -130713376, -1026724696, -894968104,
+        -662294524, -420489480, -684832848, -1598095920, -1241469848, -645506772,
+        16886284, 1008504008, 680864600, 643738156, 2044676004, 1852264000,
+        1626693884, 1457564428, 1394022016, 1955676976, 1359512548, 51787640,
+        76390180, 9765924, -255786612, -424088780, -1235847320, -1422929928,
+        -2147483648, -1610890308, -993470476, 2147483644, -2147483648, -2147483648,
+        -2147483648, 2147483644, 2147483644, 2147483644, 2147483644, 2147483644,
+        2147483644, -2147483648, 2147483644, 2147483644, 1900074572, 1496066688,
+        1007190656, 2147483644, -2147483648, -2147483648, 2147483644, -2147483648,
+        -2147483648, -1900074576, -1496066692, -2147483648, 2147483644, 2147483644,
+        -2147483648, -2147483648, -2147483648, 2147483644, 2147483644, -2147483648,
+        -2147483648, 2147483644, 2147483644, -2147483648, -2147483648, 2147483644,
+        2147483644, -2147483648, 2147483644, 2147483644, 2147483644, -2147483648,
+        -2147483648, -2147483648, 2147483644, 2147483644, 2147483644, 2147483644,
+        -2147483648, -2124211948, 2147483644, 2147483644, 1900074572, 1496066688,
+        1007190656, 2147483644, -2147483648, -2147483648, -1900074576, -2147483648,
+        -189037336, 2147483644, 2147483644, 2147483644, -2147483648, -2147483648,
+        2147483644, 2147483644, 2147483644, -2147483648, 2147483644, 2147483644,
+        2147483644, -2147483648, -2147483648, -1900074576, -2147483648, 2147483644,
+        2147483644, -2147483648, -2147483648, 2147483644, -2147483648, -2147483648,
+        -1900074576, -2147483648, -2147483648, 2147483644, 2147483644, 1900074572,
+        1496066688, 1007190656, 487869544, 2147483644, -2147483648, -2147483648,
+        -2147483648, 2147483644, -2147483648, -2147483648, -2147483648, 2147483644,
+        -2147483648, -2147483648, -1900074576, -1496066692, -1007190660, -2147483648,
+        2147483644, 2147483644, 1900602100, 2147483644, -2147483648, 2147483644,
+        2147483644, -2147483648, 2147483644, 2147483644, 1928427164, 2147483644,
+        -2147483648, -2147483648, -1900074576, -1496066692, -1007190660, -487869548,
+        -2147483648, 2147483644, 2147483644, 1900074572, 1496066688, 2147483644,
+        -2147483648, -2147483648, -1900074576, -1496066692, -1007190660, -2147483648,
+        2147483644, 2147483644, -2147483648,
+};
+
+#endif /* FOXDAC_DSP_HOST_CASCADE_VECTORS_H_ */
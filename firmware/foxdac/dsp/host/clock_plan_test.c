@@ -0,0 +1,47 @@
+/*
+ * clock_plan_test.c
+ *
+ *  Prints the clock plan of every rate and checks it:
+ *    clock_plan_test
+ *  VCO and system clock inside their limits, the rate the PIO divider actually gives worked
+ *  out again in double precision, matching error_ppb and within CLOCK_PLAN_TEST_MAX_PPB of
+ *  the nominal rate (the crystal taken as exact). Exits 1 if any rate fails.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "clock_plan.h"
+
+// the worst the planner found is 44.1k's family at -0.909ppm
+#define CLOCK_PLAN_TEST_MAX_PPB 1000
+
+int main(void) {
+    clock_plan_init();
+
+    int failed = 0;
+    printf("    rate   VCO / pd1 / pd2   = sys          PIO divider     error ppm  achieved Hz\n");
+    for(uint32_t i = 0; i < CLOCK_PLAN_RATE_COUNT; i++) {
+        const struct clock_plan *plan = clock_plan_get_index(i);
+        uint32_t pd = plan->post_div1 * plan->post_div2;
+
+        // 256 PIO cycles per S/PDIF frame
+        double achieved = (double) plan->vco_freq / pd / (plan->pio_div_q8 / 256.0) / 256.0;
+        double error_ppb = (achieved / plan->sample_freq - 1) * 1e9;
+
+        int ok = plan->sys_freq != 0 && clock_plan_get(plan->sample_freq) == plan &&
+                plan->vco_freq >= CLOCK_PLAN_VCO_MIN_HZ && plan->vco_freq <= CLOCK_PLAN_VCO_MAX_HZ &&
+                plan->post_div2 <= plan->post_div1 && plan->sys_freq == plan->vco_freq / pd &&
+                plan->sys_freq >= CLOCK_PLAN_SYS_MIN_HZ && plan->sys_freq <= CLOCK_PLAN_SYS_MAX_HZ &&
+                plan->pio_div_q8 >= 0x100 &&
+                fabs(error_ppb - plan->error_ppb) <= 1 && fabs(error_ppb) <= CLOCK_PLAN_TEST_MAX_PPB;
+        printf("  %6u  %4uMHz / %u / %u = %7.3fMHz  %3u + %3u/256  %+9.3f  %.4f  %s\n", plan->sample_freq,
+                plan->vco_freq / 1000000, plan->post_div1, plan->post_div2, plan->sys_freq / 1e6,
+                plan->pio_div_q8 >> 8, plan->pio_div_q8 & 0xff, error_ppb / 1000, achieved, ok ? "" : "FAIL");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,173 @@
+/*
+ * dither_test.c
+ *
+ *  Noise floor and distortion of every dither mode, from an FFT of its output:
+ *    dither_test
+ *  A -90dBFS 1500Hz sine (fs/32, on a bin) at 48k with all 32 bits of detail, rounded to 24 bits packet by
+ *  packet as the firmware does it. Averaged Hann windowed FFTs give the noise per bin from
+ *  20Hz to 4k and from 4k to 20k, and the worst of the 2nd to 9th harmonics above the noise
+ *  next to it (truncation leaves them, dither should bury them). Exits 1 unless:
+ *    off           a harmonic over DITHER_TEST_MIN_SPUR_DB, so the test can see distortion
+ *    TPDF, shaped  every harmonic under DITHER_TEST_MAX_SPUR_DB
+ *    shaped        the 20Hz..4k floor DITHER_TEST_MIN_GAIN_DB (first order) and twice that
+ *                  (second order) under TPDF's
+ *  and a 24 bit input comes out as it went in.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+
+#include "dither.h"
+
+#define DITHER_TEST_MIN_SPUR_DB 20.0
+#define DITHER_TEST_MAX_SPUR_DB 10.0
+#define DITHER_TEST_MIN_GAIN_DB 3.0
+
+#define FS 48000
+#define TONE 1500.0
+#define FFT_BITS 15
+#define FFT_LEN (1 << FFT_BITS)
+#define SEGMENTS 16
+
+static const char *mode_names[DITHER_MODE_COUNT] = { "off", "TPDF", "shaped 1", "shaped 2" };
+
+static double complex buf[FFT_LEN];
+static double power[FFT_LEN / 2];
+static int32_t out[2 * FFT_LEN * SEGMENTS];
+
+static void fft(double complex *a, uint32_t n) {
+    for(uint32_t i = 1, j = 0; i < n; i++) {
+        uint32_t bit = n >> 1;
+        for(; j & bit; bit >>= 1) j ^= bit;
+        j |= bit;
+        if(i < j) {
+            double complex t = a[i];
+            a[i] = a[j];
+            a[j] = t;
+        }
+    }
+    for(uint32_t len = 2; len <= n; len <<= 1) {
+        double complex w = cexp(-2 * M_PI * I / len);
+        for(uint32_t i = 0; i < n; i += len) {
+            double complex u = 1;
+            for(uint32_t k = 0; k < len / 2; k++) {
+                double complex x = a[i + k], y = a[i + k + len / 2] * u;
+                a[i + k] = x + y;
+                a[i + k + len / 2] = x - y;
+                u *= w;
+            }
+        }
+    }
+}
+
+// the sine through the dither in 48 frame packets, both channels
+static void run(uint8_t mode, double amp, bool round_input) {
+    dither_set_mode(mode);
+    for(uint32_t n = 0; n < FFT_LEN * SEGMENTS; n++) {
+        double v = amp * sin(2 * M_PI * TONE * n / FS) * 2147483648.0;
+        int32_t s = round_input ? (int32_t) lrint(v / 256) * 256 : (int32_t) lrint(v);
+        out[2 * n] = out[2 * n + 1] = s;
+    }
+    for(uint32_t pos = 0; pos < FFT_LEN * SEGMENTS; pos += FS / 1000) {
+        uint32_t frames = FFT_LEN * SEGMENTS - pos < FS / 1000 ? FFT_LEN * SEGMENTS - pos : FS / 1000;
+        dither_process_channel(&out[2 * pos], frames, 0);
+        dither_process_channel(&out[2 * pos], frames, 1);
+    }
+
+    // and the encoder's shift to 24 bits, which is all there is with the dither off
+    for(uint32_t i = 0; i < 2 * FFT_LEN * SEGMENTS; i++) {
+        out[i] &= ~((1 << DITHER_DROP_BITS) - 1);
+    }
+}
+
+// mean power per bin over [lo, hi) Hz, leaving out the tone, dB against a full scale sine
+static double floor_db(double lo, double hi, uint32_t tone_bin) {
+    double df = (double) FS / FFT_LEN, sum = 0;
+    uint32_t count = 0;
+    for(uint32_t b = (uint32_t) (lo / df); b < (uint32_t) (hi / df); b++) {
+        if(b + 4 >= tone_bin && b <= tone_bin + 4) continue;
+        sum += power[b];
+        count++;
+    }
+    return 10 * log10(sum / count);
+}
+
+static void analyse(double *floor_lo, double *floor_hi, double *spur) {
+    memset(power, 0, sizeof(power));
+    for(uint32_t seg = 0; seg < SEGMENTS; seg++) {
+        for(uint32_t k = 0; k < FFT_LEN; k++) {
+            double w = 0.5 - 0.5 * cos(2 * M_PI * k / FFT_LEN);
+            buf[k] = w * out[2 * (seg * FFT_LEN + k)] / 2147483648.0;
+        }
+        fft(buf, FFT_LEN);
+        // a full scale sine's bin at 0dB (Hann coherent gain 1/2)
+        double norm = (FFT_LEN / 4.0) * (FFT_LEN / 4.0) * SEGMENTS;
+        for(uint32_t b = 0; b < FFT_LEN / 2; b++) {
+            power[b] += creal(buf[b] * conj(buf[b])) / norm;
+        }
+    }
+
+    uint32_t tone_bin = (uint32_t) lrint(TONE * FFT_LEN / FS);
+    *floor_lo = floor_db(20, 4000, tone_bin);
+    *floor_hi = floor_db(4000, 20000, tone_bin);
+
+    // each harmonic against the noise either side of it, which shaping tilts
+    *spur = -INFINITY;
+    for(uint32_t h = 2; h <= 9; h++) {
+        uint32_t b = h * tone_bin;
+        double peak = 0, near = 0;
+        for(uint32_t i = b - 2; i <= b + 2; i++) {
+            if(power[i] > peak) peak = power[i];
+        }
+        for(uint32_t i = 8; i < 72; i++) {
+            near += power[b - i] + power[b + i];
+        }
+        // truncation's harmonics have nothing next to them, so no less than -200dB there
+        double db = 10 * log10(peak / fmax(near / 128, 1e-20));
+        if(db > *spur) *spur = db;
+    }
+}
+
+int main(void) {
+    double amp = pow(10, -90 / 20.0);
+    double floor_lo[DITHER_MODE_COUNT], floor_hi[DITHER_MODE_COUNT], spur[DITHER_MODE_COUNT];
+    int failed = 0;
+
+    printf("  mode       20Hz-4k dB  4k-20k dB  harmonic dB\n");
+    for(uint8_t m = 0; m < DITHER_MODE_COUNT; m++) {
+        run(m, amp, false);
+        analyse(&floor_lo[m], &floor_hi[m], &spur[m]);
+
+        int ok;
+        if(m == DITHER_OFF) {
+            ok = spur[m] > DITHER_TEST_MIN_SPUR_DB;
+        } else {
+            ok = spur[m] < DITHER_TEST_MAX_SPUR_DB;
+        }
+        if(m == DITHER_SHAPED_1) ok = ok && floor_lo[m] < floor_lo[DITHER_TPDF] - DITHER_TEST_MIN_GAIN_DB;
+        if(m == DITHER_SHAPED_2) ok = ok && floor_lo[m] < floor_lo[DITHER_TPDF] - 2 * DITHER_TEST_MIN_GAIN_DB;
+
+        printf("  %-9s  %10.1f  %9.1f  %11.1f  %s\n", mode_names[m], floor_lo[m], floor_hi[m], spur[m], ok ? "" : "FAIL");
+        if(!ok) failed = 1;
+    }
+
+    // already 24 bit: nothing to round, in every mode
+    for(uint8_t m = 0; m < DITHER_MODE_COUNT; m++) {
+        run(m, amp * 1000, true);
+        for(uint32_t n = 0; n < FFT_LEN * SEGMENTS; n++) {
+            double v = amp * 1000 * sin(2 * M_PI * TONE * n / FS) * 2147483648.0;
+            if(out[2 * n] != (int32_t) lrint(v / 256) * 256) {
+                printf("  %s changed a 24 bit input  FAIL\n", mode_names[m]);
+                failed = 1;
+                break;
+            }
+        }
+    }
+    return failed;
+}
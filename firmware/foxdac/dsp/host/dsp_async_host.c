@@ -0,0 +1,33 @@
+/*
+ * dsp_async_host.c
+ *
+ *  dsp_async for the host build: each round runs there and then, core 0's part first.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "dsp_async.h"
+
+void dsp_async_init_core1(void) {
+}
+
+void dsp_async_init_core0(unsigned int done_irq) {
+    (void) done_irq;
+}
+
+void dsp_async_run_core0(void) {
+}
+
+void dsp_async_post(dsp_async_job_t core0_job, dsp_async_job_t core1_job) {
+    core0_job();
+    core1_job();
+}
+
+bool dsp_async_busy(void) {
+    return false;
+}
+
+uint32_t dsp_async_core1_cycles(void) {
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * dsp_host.c
+ *
+ *  Runs the firmware's DSP chain on the host over a raw file, packet by packet as USB would
+ *  deliver it:
+ *    dsp_host [-r rate] [-a] [-d dither] [-b band,type,freq,q,gain]... in.raw out.raw
+ *  Files are interleaved stereo, 32 bit little endian, MSB aligned (24 significant bits). Band
+ *  types are off, peak, lowshelf, highshelf, lowpass, highpass and notch; -a adds the ASRC
+ *  (to ASRC_OUT_FREQ at the nominal rate), -d picks the requantisation to 24 bits (off, tpdf,
+ *  shaped1, shaped2; tpdf by default). The EQ is always on, with its preamp and limiter,
+ *  so with every band flat the output is the input.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "biquad_eq.h"
+#include "asrc.h"
+#include "dsp_pipeline.h"
+#include "dither.h"
+
+static const char *type_names[BIQUAD_EQ_TYPE_COUNT] = {
+        "off", "peak", "lowshelf", "highshelf", "lowpass", "highpass", "notch",
+};
+
+static const char *dither_names[DITHER_MODE_COUNT] = {
+        "off", "tpdf", "shaped1", "shaped2",
+};
+
+static int parse_band(const char *arg) {
+    char type[16];
+    int band;
+    struct biquad_eq_band params;
+    if(sscanf(arg, "%d,%15[a-z],%f,%f,%f", &band, type, &params.freq, &params.q, &params.gain) != 5) {
+        return -1;
+    }
+    for(int t = 0; t < BIQUAD_EQ_TYPE_COUNT; t++) {
+        if(!strcmp(type, type_names[t])) {
+            params.type = t;
+            biquad_eq_set_band(band, &params);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    uint32_t rate = 48000;
+    int asrc = 0;
+    int dither = DITHER_DEFAULT_MODE;
+    int arg = 1;
+    const char *band_args[BIQUAD_EQ_BANDS];
+    int band_count = 0;
+
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(!strcmp(argv[arg], "-r") && arg + 1 < argc) {
+            rate = (uint32_t) atoi(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-a")) {
+            asrc = 1;
+        } else if(!strcmp(argv[arg], "-d") && arg + 1 < argc) {
+            arg++;
+            dither = -1;
+            for(int d = 0; d < DITHER_MODE_COUNT; d++) {
+                if(!strcmp(argv[arg], dither_names[d])) dither = d;
+            }
+        } else if(!strcmp(argv[arg], "-b") && arg + 1 < argc && band_count < BIQUAD_EQ_BANDS) {
+            band_args[band_count++] = argv[++arg];
+        } else {
+            break;
+        }
+    }
+
+    biquad_eq_init(&rate, 1);
+    int bad_band = 0;
+    for(int i = 0; i < band_count; i++) {
+        if(parse_band(band_args[i])) bad_band = 1;
+    }
+    if(bad_band || dither < 0 || argc - arg != 2 || rate < 8000 || rate > 384000) {
+        fprintf(stderr, "usage: dsp_host [-r rate] [-a] [-d dither] [-b band,type,freq,q,gain]... in.raw out.raw\n");
+        return 1;
+    }
+
+    FILE *in = fopen(argv[arg], "rb");
+    FILE *out = fopen(argv[arg + 1], "wb");
+    if(!in || !out) {
+        perror("dsp_host");
+        return 1;
+    }
+
+    biquad_eq_update_coeffs();
+    biquad_eq_set_fs(rate);
+    biquad_eq_set_enabled(1);
+
+    // same chain as core0_init
+    uint32_t max_frames = rate / 1000 + 1;
+    dsp_pipeline_add(&biquad_eq_block);
+    dsp_pipeline_add(&biquad_eq_limiter_block);
+    if(asrc) {
+        asrc_init(&rate, 1);
+        asrc_reset(rate);
+        asrc_set_out_rate((ASRC_OUT_FREQ / 1000) << 16);
+        dsp_pipeline_add(&asrc_block);
+    }
+    dither_set_mode((uint8_t) dither);
+    dsp_pipeline_add(&dither_block);
+    dsp_pipeline_plan(max_frames, 0, 0);
+
+    static int32_t samples[2 * (384000 / 1000 + 1)];
+    uint32_t phase = 0, packets = 0;
+    while(1) {
+        // 44/45 frame packets at 44.1k, as the host sends them
+        uint32_t frames = (phase + rate) / 1000 - phase / 1000;
+        phase = (phase + rate) % 1000000u;
+
+        frames = (uint32_t) fread(samples, 2 * sizeof(int32_t), frames, in);
+        if(!frames) break;
+
+        if(dsp_pipeline_begin_packet()) {
+            dsp_pipeline_start(samples, frames);
+            const struct dsp_packet *done;
+            while(!(done = dsp_pipeline_poll())) {
+            }
+            fwrite(done->samples, 2 * sizeof(int32_t), done->frames, out);
+        } else {
+            // the firmware's bypass with every band flat
+            biquad_eq_track_bypassed(samples, frames);
+            fwrite(samples, 2 * sizeof(int32_t), frames, out);
+        }
+        packets++;
+    }
+    fclose(in);
+    fclose(out);
+
+    struct dsp_pipeline_load load;
+    dsp_pipeline_get_load(&load);
+    fprintf(stderr, "%u packets, %u rounds, estimated cycles per packet: core 0 %u, core 1 %u, critical path %u\n",
+            packets, load.rounds, load.cycles[0], load.cycles[1], load.critical);
+    for(uint8_t b = 0; b < dsp_pipeline_get_block_count(); b++) {
+        struct dsp_block_stats stats;
+        dsp_pipeline_get_block_stats(b, &stats);
+        uint8_t core = dsp_pipeline_get_block_core(b);
+        fprintf(stderr, "%-6s core %s  last %u/%u ns  peak %u/%u ns\n", dsp_pipeline_get_block_name(b),
+                core == 0 ? "0" : core == 1 ? "1" : "0+1", stats.last[0], stats.last[1], stats.peak[0], stats.peak[1]);
+    }
+    return 0;
+}
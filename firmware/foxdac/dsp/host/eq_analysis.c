@@ -0,0 +1,268 @@
+/*
+ * eq_analysis.c
+ *
+ *  How close each EQ band comes to its design at every rate the DAC runs at:
+ *    eq_analysis [-t type|all] [-g gain] [-q q]
+ *  Every band at its default frequency (peaking, +12dB, Q 0.707 unless given; all runs every
+ *  type), one stage of the exact kernel, against the same filter in double precision, at every
+ *  rate the EQ runs at (up to BIQUAD_EQ_MAX_FS):
+ *    shift   what b0 b1 b2 are shifted down by to fit (biquad_eq_design_band)
+ *    coef    worst response error over 20Hz..min(20k, 0.45fs) of the Q28 coefficients, dB
+ *    gain    worst gain error the kernel measures on sines at fc / 4 .. 4 fc, dB
+ *  (both where the response is over EQ_ANALYSIS_FLOOR_DB, EQ_ANALYSIS_NOTCH_FLOOR_DB for a
+ *  notch, a stopband is only compared down to there)
+ *    noise   rms error of the kernel's output on a -20dBFS sine at fc against the same Q28
+ *            coefficients in double precision (the rounding alone), lsb24 at the DAC
+ *    idle    largest output 0.9..1s after a full scale burst stops, lsb24 (limit cycles)
+ *  Stages in the low frequency mode (LF) are run again with it off, so its effect shows. Exits 1
+ *  if a stage as the firmware runs it has coef or gain over EQ_ANALYSIS_MAX_ERROR_DB, noise
+ *  over EQ_ANALYSIS_MAX_NOISE or idle over EQ_ANALYSIS_MAX_IDLE.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "biquad_eq.h"
+#include "biquad_cascade.h"
+#include "clock_plan.h"
+
+// the rounding well under the 24 bit step the DAC gets, and no limit cycle reaching it
+#define EQ_ANALYSIS_MAX_NOISE 0.25
+#define EQ_ANALYSIS_MAX_IDLE 1.0
+
+// the response where it is over the floor within a tenth of a dB of the design (Q28 leaves the
+// lowest pass filters at the top rates up to 0.07dB off)
+#define EQ_ANALYSIS_MAX_ERROR_DB 0.1
+#define EQ_ANALYSIS_FLOOR_DB -40.0
+// Q28 puts a notch's frequency to ~2^-28 / sin(w0), 0.02Hz at 64Hz and 176.4k, which is 0.25dB
+// 40dB down its sides; its response is compared to 20dB down
+#define EQ_ANALYSIS_NOTCH_FLOOR_DB -20.0
+
+#define LIST_RATE(freq, code) freq,
+static const uint32_t rates[] = { CLOCK_PLAN_RATES(LIST_RATE) };
+
+static const char *type_names[BIQUAD_EQ_TYPE_COUNT] = {
+        "off", "peak", "lowshelf", "highshelf", "lowpass", "highpass", "notch",
+};
+
+// 1 lsb24 at the DAC in cascade units (samples >> BIQUAD_CASCADE_HEADROOM_BITS, and the limiter
+// bringing the EQ's 4 bits of headroom back up)
+#define LSB24 (1 << (8 - BIQUAD_CASCADE_HEADROOM_BITS + 4))
+
+static double floor_db(const struct biquad_eq_band *band) {
+    return band->type == BIQUAD_EQ_NOTCH ? EQ_ANALYSIS_NOTCH_FLOOR_DB : EQ_ANALYSIS_FLOOR_DB;
+}
+
+static double response_db(const double *c, double w) {
+    double complex_nr = c[0] + c[1] * cos(w) + c[2] * cos(2 * w);
+    double complex_ni = -c[1] * sin(w) - c[2] * sin(2 * w);
+    double dr = 1 - c[3] * cos(w) - c[4] * cos(2 * w);
+    double di = c[3] * sin(w) + c[4] * sin(2 * w);
+    return 10 * log10((complex_nr * complex_nr + complex_ni * complex_ni) / (dr * dr + di * di));
+}
+
+// b0 b1 b2 back up by the shift biquad_eq_design_band gave them
+static void q28_to_double(const int32_t *coeffs, uint32_t shift, double *c) {
+    for(int i = 0; i < 5; i++) {
+        c[i] = ldexp(coeffs[i], i < 3 ? (int) shift - 28 : -28);
+    }
+}
+
+struct stage {
+    int32_t block[BIQUAD_CASCADE_WORDS(1)];
+    // the same coefficients in double precision, fed the same samples
+    double c[5];
+    double x1, x2, y1, y2;
+};
+
+// lf -1 leaves the mode to biquad_cascade_set_coeffs
+static void stage_init(struct stage *st, const int32_t *coeffs, uint32_t shift, int lf) {
+    uint8_t shifts[1] = { (uint8_t) shift };
+    memset(st, 0, sizeof(*st));
+    biquad_cascade_reset(st->block, 1);
+    biquad_cascade_set_coeffs(st->block, coeffs, shifts, 1);
+    if(lf >= 0) {
+        st->block[BIQUAD_CASCADE_EF_WORD] &= ~BIQUAD_CASCADE_EF_LF;
+        st->block[BIQUAD_CASCADE_EF_WORD] |= lf ? BIQUAD_CASCADE_EF_LF : 0;
+    }
+    q28_to_double(coeffs, shift, st->c);
+}
+
+// one sample through both, returns the kernel's error in lsb24 and its output in cascade units
+static double stage_run(struct stage *st, int32_t in, double *out) {
+    int32_t s[2] = { in, 0 };
+    biquad_cascade_exact_ref(s, 1, st->block, 1);
+
+    const double *c = st->c;
+    double x = (double) in / (1 << BIQUAD_CASCADE_HEADROOM_BITS);
+    double y = c[0] * x + c[1] * st->x1 + c[2] * st->x2 + c[3] * st->y1 + c[4] * st->y2;
+    st->x2 = st->x1;
+    st->x1 = x;
+    st->y2 = st->y1;
+    st->y1 = y;
+
+    *out = s[0] / 4.0;
+    return (*out - y) / LSB24;
+}
+
+// 24 bit samples, MSB aligned like the pipeline's
+static int32_t sample24(double v) {
+    return (int32_t) lrint(v * 8388607.0) << 8;
+}
+
+static double measure_gain_db(const int32_t *coeffs, uint32_t shift, uint32_t fs, double f, int lf) {
+    struct stage st;
+    stage_init(&st, coeffs, shift, lf);
+
+    // a second to settle, then fit a * sin + b * cos over the next one
+    double sc = 0, cc = 0, ss = 0, ys = 0, yc = 0;
+    for(uint32_t n = 0; n < 2 * fs; n++) {
+        double w = 2 * M_PI * f * n / fs;
+        int32_t in = sample24(0.1 * sin(w));
+        double out;
+        stage_run(&st, in, &out);
+        if(n < fs) continue;
+        double si = sin(w), co = cos(w);
+        ss += si * si;
+        cc += co * co;
+        sc += si * co;
+        ys += out * si;
+        yc += out * co;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+    double in_amp = 0.1 * 8388607.0 * 256 / (1 << BIQUAD_CASCADE_HEADROOM_BITS);
+    return 20 * log10(sqrt(a * a + b * b) / in_amp);
+}
+
+static void analyse(const struct biquad_eq_band *band, uint32_t fs, int lf, double *gain_err, double *noise, double *idle) {
+    double ideal[5];
+    int32_t coeffs[5];
+    uint32_t shift = biquad_eq_design_band(band, fs, ideal, coeffs);
+
+    double fc = band->freq > 0.45 * fs ? 0.45 * fs : band->freq;
+    *gain_err = 0;
+    for(double f = fc / 4; f <= 4 * fc && f < 0.45 * fs; f *= 2) {
+        double want = response_db(ideal, 2 * M_PI * f / fs);
+        if(want < floor_db(band)) continue;
+        double err = fabs(measure_gain_db(coeffs, shift, fs, f, lf) - want);
+        if(err > *gain_err) *gain_err = err;
+    }
+
+    struct stage st;
+    double out, sum = 0;
+    stage_init(&st, coeffs, shift, lf);
+    for(uint32_t n = 0; n < 2 * fs; n++) {
+        double e = stage_run(&st, sample24(0.1 * sin(2 * M_PI * fc * n / fs)), &out);
+        if(n >= fs) sum += e * e;
+    }
+    *noise = sqrt(sum / fs);
+
+    // 10ms of full scale noise, then silence
+    stage_init(&st, coeffs, shift, lf);
+    srand(1);
+    *idle = 0;
+    for(uint32_t n = 0; n < fs + fs / 100; n++) {
+        int32_t in = n < fs / 100 ? sample24((rand() / (double) RAND_MAX - 0.5) * 0.9) : 0;
+        stage_run(&st, in, &out);
+        if(n >= fs / 100 + fs * 9 / 10 && fabs(out) / LSB24 > *idle) *idle = fabs(out) / LSB24;
+    }
+}
+
+// every band of one type at every rate, returns 1 if any fails
+static int analyse_type(int type, float gain, float q) {
+    struct biquad_eq_band band;
+    int failed = 0;
+
+    printf("%s %+.1fdB Q %.3f\n", type_names[type], gain, q);
+    for(uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        uint32_t fs = rates[r];
+        if(fs > BIQUAD_EQ_MAX_FS) {
+            printf("\n%u Hz, EQ bypassed\n", fs);
+            continue;
+        }
+        printf("\n%u Hz\n", fs);
+        printf("  band     fc  mode  shift   coef dB   gain dB   noise lsb24   idle lsb24\n");
+
+        for(uint8_t b = 0; b < BIQUAD_EQ_BANDS; b++) {
+            biquad_eq_get_default_band(b, &band);
+            band.type = type;
+            band.gain = gain;
+            band.q = q;
+
+            double ideal[5];
+            int32_t coeffs[5];
+            int32_t block[BIQUAD_CASCADE_WORDS(1)];
+            uint32_t shift = biquad_eq_design_band(&band, fs, ideal, coeffs);
+            biquad_cascade_set_coeffs(block, coeffs, NULL, 1);
+            bool lf = block[BIQUAD_CASCADE_EF_WORD] & BIQUAD_CASCADE_EF_LF;
+
+            double coef_err = 0;
+            double top = fs * 0.45 < 20000 ? fs * 0.45 : 20000;
+            for(double f = 20; f <= top; f *= 1.01) {
+                double q28[5];
+                q28_to_double(coeffs, shift, q28);
+                double want = response_db(ideal, 2 * M_PI * f / fs);
+                if(want < floor_db(&band)) continue;
+                double err = fabs(response_db(q28, 2 * M_PI * f / fs) - want);
+                if(err > coef_err) coef_err = err;
+            }
+
+            double gain_err, noise, idle;
+            analyse(&band, fs, -1, &gain_err, &noise, &idle);
+            int ok = coef_err < EQ_ANALYSIS_MAX_ERROR_DB && gain_err < EQ_ANALYSIS_MAX_ERROR_DB &&
+                    noise < EQ_ANALYSIS_MAX_NOISE && idle < EQ_ANALYSIS_MAX_IDLE;
+            printf("  %4u %6.0f  %-5s %5u %8.4f  %8.4f  %12.3f %12.1f  %s\n", b, band.freq, lf ? "LF" : "-",
+                    shift, coef_err, gain_err, noise, idle, ok ? "" : "FAIL");
+            if(!ok) failed = 1;
+            if(lf) {
+                analyse(&band, fs, 0, &gain_err, &noise, &idle);
+                printf("  %4s %6s  %-5s %5s %8s  %8.4f  %12.3f %12.1f\n", "", "", "plain", "", "", gain_err, noise, idle);
+            }
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    int type = BIQUAD_EQ_PEAKING;
+    float gain = 12.0f, q = 0.707f;
+
+    for(int arg = 1; arg < argc; arg++) {
+        if(!strcmp(argv[arg], "-g") && arg + 1 < argc) {
+            gain = (float) atof(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-q") && arg + 1 < argc) {
+            q = (float) atof(argv[++arg]);
+        } else if(!strcmp(argv[arg], "-t") && arg + 1 < argc) {
+            arg++;
+            type = -1;
+            for(int t = 1; t < BIQUAD_EQ_TYPE_COUNT; t++) {
+                if(!strcmp(argv[arg], type_names[t])) type = t;
+            }
+            if(!strcmp(argv[arg], "all")) type = BIQUAD_EQ_OFF;
+            if(type < 0) break;
+        } else {
+            type = -1;
+            break;
+        }
+    }
+    if(type < 0) {
+        fprintf(stderr, "usage: eq_analysis [-t type|all] [-g gain] [-q q]\n");
+        return 1;
+    }
+
+    if(type != BIQUAD_EQ_OFF) {
+        return analyse_type(type, gain, q);
+    }
+    int failed = 0;
+    for(int t = 1; t < BIQUAD_EQ_TYPE_COUNT; t++) {
+        failed |= analyse_type(t, gain, q);
+        printf("\n");
+    }
+    return failed;
+}
@@ -0,0 +1,138 @@
+/*
+ * eq_sweep_test.c
+ *
+ *  Clicks from EQ gain changes, through the EQ and its limiter packet by packet as the
+ *  firmware runs them:
+ *    eq_sweep_test
+ *  A -20dBFS sine at a band's centre while that band is swept -20dB to +20dB and back a dB
+ *  every 100ms (encoder detents), then jumped between -20dB and +20dB every second. Any sine at
+ *  the input's frequency has y[n] - 2cos(w)y[n-1] + y[n-2] = 0 whatever its level, so what is
+ *  left of that is the click; the figure is the largest of it against the output's peak. Exits
+ *  1 if a sweep is over EQ_SWEEP_MAX_DB or a jump over EQ_JUMP_MAX_DB.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "biquad_eq.h"
+#include "dsp_pipeline.h"
+#include "clock_plan.h"
+
+// a step of ~2% of the level for a detent; a 40dB jump is ramped over BIQUAD_EQ_RAMP_PACKETS,
+// each of which still moves the level by a few dB (switched straight away it's ~0dB)
+#define EQ_SWEEP_MAX_DB -35.0
+#define EQ_JUMP_MAX_DB -6.0
+
+// a second to settle before anything is measured
+#define SETTLE_SECS 2
+
+#define LIST_RATE(freq, code) freq,
+static const uint32_t rates[] = { CLOCK_PLAN_RATES(LIST_RATE) };
+
+static const struct {
+    uint32_t fs;
+    uint8_t band;
+} cases[] = {
+        { 48000, 4 }, { 48000, 0 }, { 44100, 7 }, { 96000, 0 }, { 96000, 2 },
+};
+
+struct sweep {
+    uint32_t fs;
+    double w;
+    uint64_t n;
+    double y1, y2;
+    double max_r, max_y;
+};
+
+static void run_packets(struct sweep *sw, uint32_t packets) {
+    static int32_t samples[2 * (CLOCK_PLAN_MAX_RATE / 1000 + 1)];
+    uint32_t frames = sw->fs / 1000;
+    double amp = 0.1 * 2147483648.0;
+
+    for(uint32_t p = 0; p < packets; p++) {
+        for(uint32_t i = 0; i < frames; i++) {
+            samples[2 * i] = samples[2 * i + 1] = (int32_t) lrint(amp * sin(sw->w * (double) (sw->n + i)));
+        }
+
+        const int32_t *out = samples;
+        if(dsp_pipeline_begin_packet()) {
+            dsp_pipeline_start(samples, frames);
+            const struct dsp_packet *done;
+            while(!(done = dsp_pipeline_poll())) {
+            }
+            out = done->samples;
+        } else {
+            biquad_eq_track_bypassed(samples, frames);
+        }
+
+        for(uint32_t i = 0; i < frames; i++, sw->n++) {
+            double y = out[2 * i] / 2147483648.0;
+            if(sw->n > SETTLE_SECS * sw->fs) {
+                double r = fabs(y - 2 * cos(sw->w) * sw->y1 + sw->y2);
+                if(r > sw->max_r) sw->max_r = r;
+                if(fabs(y) > sw->max_y) sw->max_y = fabs(y);
+            }
+            sw->y2 = sw->y1;
+            sw->y1 = y;
+        }
+    }
+}
+
+static void set_gain(uint8_t band, float gain) {
+    biquad_eq_set_band_gain(band, gain);
+    biquad_eq_update_coeffs();
+}
+
+// largest click in dB against the output's peak
+static double sweep(uint32_t fs, uint8_t band, bool jump) {
+    struct biquad_eq_band params;
+    biquad_eq_init(rates, sizeof(rates) / sizeof(rates[0]));
+    biquad_eq_set_fs((int) fs);
+    biquad_eq_set_enabled(1);
+    biquad_eq_get_band(band, &params);
+
+    struct sweep sw = { .fs = fs, .w = 2 * M_PI * params.freq / fs };
+    set_gain(band, -20);
+    run_packets(&sw, SETTLE_SECS * 1000);
+
+    if(jump) {
+        for(int i = 0; i < 4; i++) {
+            set_gain(band, i & 1 ? -20 : 20);
+            run_packets(&sw, 1000);
+        }
+    } else {
+        for(int g = -19; g <= 20; g++) {
+            set_gain(band, (float) g);
+            run_packets(&sw, 100);
+        }
+        for(int g = 19; g >= -20; g--) {
+            set_gain(band, (float) g);
+            run_packets(&sw, 100);
+        }
+    }
+
+    return 20 * log10(sw.max_r / sw.max_y);
+}
+
+int main(void) {
+    dsp_pipeline_add(&biquad_eq_block);
+    dsp_pipeline_add(&biquad_eq_limiter_block);
+    dsp_pipeline_plan(CLOCK_PLAN_MAX_RATE / 1000 + 1, 0, 0);
+
+    int failed = 0;
+    printf("    rate  band     fc  sweep dB  jump dB\n");
+    for(uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        struct biquad_eq_band params;
+        biquad_eq_get_default_band(cases[c].band, &params);
+        double swept = sweep(cases[c].fs, cases[c].band, false);
+        double jumped = sweep(cases[c].fs, cases[c].band, true);
+        int ok = swept < EQ_SWEEP_MAX_DB && jumped < EQ_JUMP_MAX_DB;
+        printf("  %6u  %4u  %5.0f  %+8.1f  %+7.1f  %s\n", cases[c].fs, cases[c].band, params.freq, swept, jumped,
+                ok ? "" : "FAIL");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,124 @@
+/*
+ * feedback_sim.c
+ *
+ *  Runs usb_feedback against a simulated host and S/PDIF clock for every rate, with the DAC's
+ *  clock off from the host's by up to +-1000ppm:
+ *    feedback_sim
+ *  The host reads the feedback every FEEDBACK_INTERVAL SOFs and acts on it two SOFs later,
+ *  sending whole frames a ms with the fraction carried. The S/PDIF DMA takes 192 frame blocks
+ *  from a pool of BLOCKS, silence when there are none. After the loop has settled the fill
+ *  has to stay within a block of USB_FEEDBACK_TARGET_FRAMES, with no underruns or overruns;
+ *  exits 1 if it doesn't.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "usb_feedback.h"
+#include "clock_plan.h"
+
+#define BLOCK_FRAMES 192
+#define BLOCKS 4
+#define FEEDBACK_INTERVAL 4
+
+// 10 minutes of SOFs, the first 20s left to settle
+#define SIM_SOFS 600000
+#define SETTLE_SOFS 20000
+
+#define LIST_RATE(freq, code) freq,
+static const uint32_t rates[] = { CLOCK_PLAN_RATES(LIST_RATE) };
+
+static const double offsets_ppm[] = { -1000, -300, -28, 0, 28, 300, 1000 };
+
+struct sim_result {
+    double fill_min, fill_max;
+    uint32_t underruns, overruns;
+    double feedback;
+};
+
+static void simulate(uint32_t fs, double ppm, struct sim_result *res) {
+    usb_feedback_reset(fs, fs);
+
+    // DAC frames a ms of USB time
+    double dac_rate = fs * (1 + ppm * 1e-6) / 1000.0;
+    double block_pos = 0;                   // frames into the block the DMA is sending
+    uint32_t clocked_blocks = 0, played_blocks = 0;
+    int playing = 0;                        // the block being sent came from the host
+
+    uint32_t received = 0, queued = 0, partial = 0;
+    double host_rate = fs / 1000.0, pending = host_rate, carry = 0;
+
+    res->fill_min = 1e9;
+    res->fill_max = -1e9;
+    res->underruns = res->overruns = 0;
+
+    for(uint32_t sof = 0; sof < SIM_SOFS; sof++) {
+        uint32_t pos = (uint32_t) block_pos;
+        usb_feedback_sof(clocked_blocks * BLOCK_FRAMES + pos,
+                played_blocks * BLOCK_FRAMES + (playing ? pos : 0), received);
+
+        if(sof % FEEDBACK_INTERVAL == 0) pending = usb_feedback_get_10_14() / 16384.0;
+        if(sof % FEEDBACK_INTERVAL == 2) host_rate = pending;
+
+        // the stream starts 100ms in
+        if(sof >= 100) {
+            carry += host_rate;
+            uint32_t frames = (uint32_t) carry;
+            carry -= frames;
+            received += frames;
+            partial += frames;
+            while(partial >= BLOCK_FRAMES) {
+                // one block is always with the DMA
+                if(queued + 1 >= BLOCKS) {
+                    res->overruns++;
+                } else {
+                    queued++;
+                }
+                partial -= BLOCK_FRAMES;
+            }
+        }
+
+        block_pos += dac_rate;
+        while(block_pos >= BLOCK_FRAMES) {
+            block_pos -= BLOCK_FRAMES;
+            clocked_blocks++;
+            if(playing) played_blocks++;
+            playing = queued > 0;
+            if(playing) {
+                queued--;
+            } else if(sof > SETTLE_SOFS) {
+                res->underruns++;
+            }
+        }
+
+        double fill = queued * BLOCK_FRAMES + partial + (playing ? BLOCK_FRAMES - block_pos : 0);
+        if(sof > SETTLE_SOFS) {
+            if(fill < res->fill_min) res->fill_min = fill;
+            if(fill > res->fill_max) res->fill_max = fill;
+        }
+    }
+    res->feedback = usb_feedback_get_10_14() / 16384.0;
+}
+
+int main(void) {
+    int failed = 0;
+    printf("    rate     ppm   fill min  fill max  under  over  feedback frames/ms\n");
+    for(uint32_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        for(uint32_t p = 0; p < sizeof(offsets_ppm) / sizeof(offsets_ppm[0]); p++) {
+            struct sim_result res;
+            simulate(rates[r], offsets_ppm[p], &res);
+            double expected = rates[r] * (1 + offsets_ppm[p] * 1e-6) / 1000.0;
+            int ok = !res.underruns && !res.overruns &&
+                    res.fill_min > USB_FEEDBACK_TARGET_FRAMES - BLOCK_FRAMES &&
+                    res.fill_max < USB_FEEDBACK_TARGET_FRAMES + BLOCK_FRAMES &&
+                    fabs(res.feedback - expected) < expected * 1e-3;
+            printf("  %6u  %+6.0f  %9.1f %9.1f  %5u %5u  %9.4f  %s\n", rates[r], offsets_ppm[p],
+                    res.fill_min, res.fill_max, res.underruns, res.overruns, res.feedback, ok ? "" : "FAIL");
+            if(!ok) failed = 1;
+        }
+    }
+    return failed;
+}
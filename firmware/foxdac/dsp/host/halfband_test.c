@@ -0,0 +1,81 @@
+/*
+ * halfband_test.c
+ *
+ *  The analyser's half-band decimators (halfband.h) against the response claimed there, run
+ *  through halfband_push in integer as core 1 runs them:
+ *    halfband_test
+ *  A -6dBFS q15 sine every 0.001 fs from 0.001 fs to 0.499 fs into each filter, a least
+ *  squares fit of the sine at the output (aliased where it folds) giving the gain. Exits 1 if
+ *  the gain strays over HALFBAND_TEST_MAX_RIPPLE_DB from 0dB up to the passband edge, or is
+ *  over -HALFBAND_TEST_MIN_REJECT_DB from the stopband edge up.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "halfband.h"
+
+#define HALFBAND_TEST_MAX_RIPPLE_DB 0.05
+#define HALFBAND_TEST_MIN_REJECT_DB 46.0
+
+// input samples a tone, the first quarter left to settle
+#define TONE_SAMPLES 8192
+
+static const struct {
+    const char *name;
+    const int32_t *h;
+    int pairs;
+    double pass, stop;          // edges as fractions of the input rate
+} filters[] = {
+        { "narrow", halfband_narrow, HALFBAND_NARROW_PAIRS, 0.1875, 0.3125 },
+        { "wide", halfband_wide, HALFBAND_WIDE_PAIRS, 0.104, 0.396 },
+};
+
+// gain in dB of a sine at f (of the input rate) through a filter
+static double gain_db(uint32_t fi, double f) {
+    static struct halfband hb;
+    double amp = 16384, ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    halfband_reset(&hb);
+
+    // the outputs come at half the rate, where the sine is at 2f (folded if over 1/2)
+    double w = 2 * M_PI * 2 * f;
+    uint32_t m = 0;
+    for(uint32_t n = 0; n < TONE_SAMPLES; n++) {
+        int32_t y;
+        if(!halfband_push(&hb, filters[fi].h, filters[fi].pairs, (int32_t) lrint(amp * sin(2 * M_PI * f * n)), &y)) continue;
+        if(m++ < TONE_SAMPLES / 8) continue;
+        double si = sin(w * m), co = cos(w * m);
+        ss += si * si;
+        cc += co * co;
+        sc += si * co;
+        ys += y * si;
+        yc += y * co;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+    return 20 * log10(sqrt(a * a + b * b) / amp);
+}
+
+int main(void) {
+    int failed = 0;
+    printf("  filter   pass edge  ripple dB   stop edge  rejection dB\n");
+    for(uint32_t fi = 0; fi < sizeof(filters) / sizeof(filters[0]); fi++) {
+        double ripple = 0, reject = INFINITY;
+        for(uint32_t k = 1; k < 500; k++) {
+            // fs / 4 comes out at the output's Nyquist, all zeros, and is in both transitions
+            if(k == 250) continue;
+            double f = k * 0.001;
+            double g = gain_db(fi, f);
+            if(f <= filters[fi].pass && fabs(g) > ripple) ripple = fabs(g);
+            if(f >= filters[fi].stop && -g < reject) reject = -g;
+        }
+        int ok = ripple <= HALFBAND_TEST_MAX_RIPPLE_DB && reject >= HALFBAND_TEST_MIN_REJECT_DB;
+        printf("  %-6s  %9.4f  %9.3f  %10.4f  %12.2f  %s\n", filters[fi].name, filters[fi].pass, ripple,
+                filters[fi].stop, reject, ok ? "" : "FAIL");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
@@ -0,0 +1,29 @@
+/*
+ * arm_math.h
+ *
+ *  The CMSIS-DSP bits the dsp sources use, for the host build (the real one needs the CMSIS
+ *  core headers from the SDK).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_ARM_MATH_H_
+#define FOXDAC_DSP_HOST_ARM_MATH_H_
+
+#include <stdint.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+
+// as CMSIS-DSP's none.h
+static inline q31_t clip_q63_to_q31(q63_t x) {
+    return ((q31_t) (x >> 32) != ((q31_t) x >> 31)) ? ((0x7FFFFFFF ^ ((q31_t) (x >> 63)))) : (q31_t) x;
+}
+
+#endif /* FOXDAC_DSP_HOST_ARM_MATH_H_ */
@@ -0,0 +1,13 @@
+/*
+ * irq.h
+ *
+ *  Empty for the host build.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_HARDWARE_IRQ_H_
+#define FOXDAC_DSP_HOST_HARDWARE_IRQ_H_
+
+#endif /* FOXDAC_DSP_HOST_HARDWARE_IRQ_H_ */
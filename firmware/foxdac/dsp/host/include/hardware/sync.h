@@ -0,0 +1,22 @@
+/*
+ * sync.h
+ *
+ *  Memory barriers from hardware/sync.h for the host build, as GCC atomic fences so they hold
+ *  between threads (from C or C++).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_HARDWARE_SYNC_H_
+#define FOXDAC_DSP_HOST_HARDWARE_SYNC_H_
+
+#define __mem_fence_release() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define __mem_fence_acquire() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+// a full fence, so tests that run the two cores' sides as threads see the same ordering
+static inline void __dmb(void) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif /* FOXDAC_DSP_HOST_HARDWARE_SYNC_H_ */
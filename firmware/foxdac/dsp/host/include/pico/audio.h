@@ -0,0 +1,20 @@
+/*
+ * audio.h
+ *
+ *  What pico_audio_spdif's sample_encoding.h uses from pico/audio.h, for the host build.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_PICO_AUDIO_H_
+#define FOXDAC_DSP_HOST_PICO_AUDIO_H_
+
+#include <stdint.h>
+
+typedef struct audio_connection audio_connection_t;
+typedef struct audio_buffer audio_buffer_t;
+
+#define __mul_instruction(a, b) ((a) * (b))
+
+#endif /* FOXDAC_DSP_HOST_PICO_AUDIO_H_ */
@@ -0,0 +1,13 @@
+/*
+ * multicore.h
+ *
+ *  Empty for the host build, dsp_async_host.c stands in for the cores.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_PICO_MULTICORE_H_
+#define FOXDAC_DSP_HOST_PICO_MULTICORE_H_
+
+#endif /* FOXDAC_DSP_HOST_PICO_MULTICORE_H_ */
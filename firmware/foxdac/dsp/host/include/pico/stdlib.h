@@ -0,0 +1,24 @@
+/*
+ * stdlib.h
+ *
+ *  What the dsp sources use from pico/stdlib.h, for the host build.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_HOST_PICO_STDLIB_H_
+#define FOXDAC_DSP_HOST_PICO_STDLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#endif /* FOXDAC_DSP_HOST_PICO_STDLIB_H_ */
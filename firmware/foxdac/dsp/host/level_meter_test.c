@@ -0,0 +1,161 @@
+/*
+ * level_meter_test.c
+ *
+ *  The level meter's passes, and its publish and read between two threads:
+ *    level_meter_test
+ *  passes   random packets of 0..LEVEL_METER_MAX_FRAMES frames through level_meter_add_s16 and
+ *           level_meter_add_s24 at the first 8 frame offsets into a word aligned packet, and through
+ *           level_meter_add_samples from pcm_format.c's decoders; peaks and sums against a
+ *           reference on the decoded samples
+ *  reads    one thread publishes PUBLISHES one frame packets as the encoder IRQ does, another
+ *           reads whenever it likes as core 1 does. The left peaks go up packet by packet and
+ *           the right ones down, so each read's peaks give the first and last packet it covers;
+ *           those must follow on from the read before with none left out and none twice
+ *  Exits 1 on any mismatch.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "level_meter.h"
+#include "pcm_format.h"
+
+#define PASS_ROUNDS 200
+#define PUBLISHES 2000000u
+
+// xorshift32, the same sequence on any host
+static uint32_t rand_state = 2463534242u;
+
+static uint32_t next_rand(void) {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+static void ref_add(struct level_meter_packet *p, const int32_t *samples, uint32_t frames) {
+    for(uint32_t i = 0; i < 2 * frames; i++) {
+        int64_t x = samples[i] >> 16;
+        uint32_t sq = (uint32_t) (x * x);
+        if(sq > p->peak_sq[i & 1]) p->peak_sq[i & 1] = sq;
+        p->sum_sq[i & 1] += sq >> 6;
+    }
+}
+
+static bool same(const struct level_meter_packet *a, const struct level_meter_packet *b) {
+    return a->peak_sq[0] == b->peak_sq[0] && a->peak_sq[1] == b->peak_sq[1] &&
+            a->sum_sq[0] == b->sum_sq[0] && a->sum_sq[1] == b->sum_sq[1];
+}
+
+static int check_passes(void) {
+    static uint32_t packet[(6 * 2 * LEVEL_METER_MAX_FRAMES) / 4 + 1];
+    static int32_t samples[2 * LEVEL_METER_MAX_FRAMES];
+    uint32_t runs = 0, bad = 0;
+
+    for(uint32_t round = 0; round < PASS_ROUNDS; round++) {
+        // full scale now and then, so -32768 squared and the sums' top bits come up
+        uint32_t shift = next_rand() % 4 ? next_rand() % 16 : 0;
+        for(uint32_t i = 0; i < sizeof(packet) / sizeof(packet[0]); i++) {
+            packet[i] = next_rand() >> shift;
+            if(next_rand() & 1) packet[i] = ~packet[i];
+        }
+        if(!(round & 7)) {
+            for(uint32_t i = 0; i < sizeof(packet) / sizeof(packet[0]); i++) {
+                packet[i] = i & 1 ? 0x80008000u : 0x7fff7fffu;
+            }
+        }
+
+        uint32_t frames = next_rand() % (LEVEL_METER_MAX_FRAMES + 1);
+        for(uint32_t s24 = 0; s24 < 2; s24++) {
+            for(uint32_t offset = 0; offset < 8; offset++, runs++) {
+                const uint8_t *in = (const uint8_t *) packet + offset * (s24 ? 6 : 4);
+                struct level_meter_packet got, from_samples, want;
+                level_meter_packet_init(&got);
+                level_meter_packet_init(&from_samples);
+                level_meter_packet_init(&want);
+
+                if(s24) {
+                    pcm_decode_s24(samples, in, frames);
+                    level_meter_add_s24(&got, in, frames);
+                } else {
+                    pcm_decode_s16(samples, in, frames);
+                    level_meter_add_s16(&got, in, frames);
+                }
+                level_meter_add_samples(&from_samples, samples, frames);
+                ref_add(&want, samples, frames);
+
+                if(!same(&got, &want) || !same(&from_samples, &want)) {
+                    if(!bad) printf("  first mismatch: %s, %u frames at frame %u\n", s24 ? "s24" : "s16", frames, offset);
+                    bad++;
+                }
+            }
+        }
+    }
+    printf("  passes  %u packets, %u mismatched  %s\n", runs, bad, bad ? "FAIL" : "");
+    return bad != 0;
+}
+
+static volatile bool publishing;
+
+static void *publisher(void *arg) {
+    (void) arg;
+    for(uint32_t i = 0; i < PUBLISHES; i++) {
+        struct level_meter_packet p = { { i + 1, PUBLISHES - i }, { 0, 0 } };
+        level_meter_publish(&p, 1);
+        // uneven gaps, so reads land anywhere in and between publishes
+        for(volatile uint32_t d = (i * 2654435761u) >> 25; d; d--) {
+        }
+        // and with one CPU, hand it over now and then rather than only when the slice runs out
+        if(!(i & 15)) sched_yield();
+    }
+    __atomic_store_n(&publishing, false, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int check_reads(void) {
+    struct level_meter_snapshot s;
+    uint32_t next = 0, reads = 0, empty = 0, bad = 0;
+
+    // from a clean start
+    level_meter_read(&s);
+    uint32_t base = s.frames;
+
+    pthread_t thread;
+    publishing = true;
+    pthread_create(&thread, NULL, publisher, NULL);
+    bool last = false;
+    while(!last) {
+        last = !__atomic_load_n(&publishing, __ATOMIC_ACQUIRE);
+        level_meter_read(&s);
+        reads++;
+        sched_yield();
+        if(!s.peak_sq[0] && !s.peak_sq[1]) {
+            empty++;
+            continue;
+        }
+        // the first packet is the right channel's largest, the last the left's
+        uint32_t first = PUBLISHES - s.peak_sq[1], end = s.peak_sq[0];
+        if(first != next || end <= first) {
+            if(!bad) printf("  read %u covers packets %u..%u, next was %u\n", reads, first, end - 1, next);
+            bad++;
+        }
+        next = end;
+    }
+    pthread_join(thread, NULL);
+
+    bool ok = !bad && next == PUBLISHES && s.frames - base == PUBLISHES;
+    printf("  reads   %u packets, %u reads (%u empty), %u out of turn, %u covered  %s\n", PUBLISHES, reads, empty,
+            bad, next, ok ? "" : "FAIL");
+    return !ok;
+}
+
+int main(void) {
+    int failed = check_passes();
+    failed |= check_reads();
+    return failed;
+}
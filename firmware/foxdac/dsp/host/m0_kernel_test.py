@@ -0,0 +1,198 @@
+#
+# m0_kernel_test.py
+#
+#  The hand written M0+ code itself, assembled and run on m0_model.py:
+#    m0_kernel_test.py --cascade-test <cascade_test> [--cc cc] [--mc llvm-mc] [--objdump llvm-objdump]
+#  The kernel in biquad_cascade_m0.S against the C one bit for bit, on every case cascade_test
+#  has (cascade_test -d: each packet's samples, both channels, and the block's state after), and
+#  the sequences of mulhs.h (the inline asm and the asm macros) against exact products on the
+#  awkward halves and random operands, the macros' within the bounds they take. Prints the cycles
+#  each takes, which is where the figures in biquad_cascade.h, biquad_eq.c and mulhs.h come from.
+#  Exits 1 on any mismatch.
+#
+#  Created on: 17 Oct 2026
+#      Author: alex
+#
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+# runs from the source tree, leave no __pycache__ in it
+sys.dont_write_bytecode = True
+from m0_model import Model, M, s32
+
+DSP_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+# the kernel each of cascade_test's kernels is the C version of
+KERNELS = {'exact': 'biquad_cascade_exact_m0'}
+
+SAMPLES = 0x20000000
+BLOCK = 0x20010000
+
+# mulhs.h's inline asm operands, and the function each sequence goes in
+OPERANDS = {'%Q[acc]': 'r0', '%R[acc]': 'r1', '%[a]': 'r2', '%[b]': 'r3',
+            '%[t0]': 'r4', '%[t1]': 'r5', '%[t2]': 'r6'}
+INLINE = ['mulhs_exact', 'mulhs_round', 'mac64']
+
+# hi:lo from lo hi ch cl v in r0..r4 (mul64_split's v in r1)
+MACROS = '''
+#include "mulhs.h"
+.syntax unified
+.cpu cortex-m0plus
+.thumb
+.section .text.mulhs
+.thumb_func
+empty:
+    push    {r4, r5, r6, r7, lr}
+    pop     {r4, r5, r6, r7, pc}
+.thumb_func
+mac64_split:
+    push    {r4, r5, r6, r7, lr}
+    mac64_split r0, r1, r2, r3, r4, r5, r6
+    pop     {r4, r5, r6, r7, pc}
+.thumb_func
+mul64_split:
+    push    {r4, r5, r6, r7, lr}
+    mul64_split r0, r1, r2, r3, r5, r6
+    pop     {r4, r5, r6, r7, pc}
+'''
+
+
+def assemble(args, src, tmp, name):
+    s = os.path.join(tmp, name + '.S')
+    i = os.path.join(tmp, name + '.s')
+    o = os.path.join(tmp, name + '.o')
+    with open(s, 'w') as f:
+        f.write(src)
+    subprocess.run([args.cc, '-E', '-P', '-x', 'assembler-with-cpp', '-D__ASSEMBLER__', '-I', DSP_DIR, s, '-o', i],
+                   check=True)
+    subprocess.run([args.mc, '-triple=thumbv6m-none-eabi', '-mcpu=cortex-m0plus', '-filetype=obj', i, '-o', o],
+                   check=True)
+    return o
+
+
+def inline_sequences():
+    src = open(os.path.join(DSP_DIR, 'mulhs.h')).read()
+    arm = src[src.index('#if defined(__ARM_ARCH_6M__)'):src.index('#else')]
+    out = ''
+    for name in INLINE:
+        body = arm[re.search(r'\b' + name + r'\(', arm).start():]
+        body = body[body.index('__asm__'):body.index('\n            :')]
+        lines = [l for l in re.findall(r'"([^"]*)\\n"', body) if l.strip() != '.syntax unified']
+        out += '.thumb_func\n%s:\n    push    {r4, r5, r6, r7, lr}\n' % name
+        for l in lines:
+            for k, v in OPERANDS.items():
+                l = l.replace(k, v)
+            out += '    ' + l + '\n'
+        out += '    pop     {r4, r5, r6, r7, pc}\n'
+    return out
+
+
+def check_cascades(args, model):
+    dump = subprocess.run([args.cascade_test, '-d'], capture_output=True, text=True, check=True).stdout
+    failed = 0
+    case = None
+    print('  kernel                    case       stages frames  cycles/sample  /stage  ')
+    for line in dump.splitlines() + ['case']:
+        tag, *rest = line.split(' ')
+        if tag == 'case' and case:
+            name, kernel, stages, frames, bad, cycles, packets = case
+            per = cycles / (packets * frames)
+            print('  %-25s %-10s %6d %6d  %13.1f  %6.1f  %s' % (KERNELS[kernel], name, stages, frames, per,
+                                                               per / stages, 'FAIL' if bad else ''))
+            failed |= bool(bad)
+        if tag == 'case' and rest:
+            case = [rest[0], rest[1], int(rest[2]), int(rest[3]), 0, 0, 0]
+        elif tag == 'block':
+            for i, w in enumerate(rest):
+                model.st(BLOCK + 4 * i, int(w))
+        elif tag == 'in':
+            for i, w in enumerate(rest):
+                model.st(SAMPLES + 4 * i, int(w))
+            _, cycles = model.call(KERNELS[case[1]], [SAMPLES, case[3], BLOCK, case[2]])
+            case[5] += cycles
+            case[6] += 1
+        elif tag in ('out', 'end'):
+            base = SAMPLES if tag == 'out' else BLOCK
+            got = [s32(model.ld(base + 4 * i)) for i in range(len(rest))]
+            case[4] += sum(g != int(w) for g, w in zip(got, rest))
+    return failed
+
+
+def operands(split=False):
+    halves = [0x0000, 0x0001, 0x7fff, 0x8000, 0x8001, 0xfffe, 0xffff, 0x5a5a]
+    rnd = random.Random(1)
+    if not split:
+        words = [(h << 16) | l for h in halves for l in halves]
+        pairs = [(a, b) for a in words for b in words]
+        pairs += [(rnd.getrandbits(32), rnd.getrandbits(32)) for _ in range(2000)]
+        return pairs
+    # mac64_split's bounds: coefficients with |ch| <= 2^14, samples with |v| <= 2^29
+    tops = [0x0000, 0x0001, 0x3fff, 0x4000, 0x1a5a, -0x4000, -0x3fff, -0x0001]
+    coeffs = [((h << 16) | l) & M for h in tops for l in halves]
+    samples = [((h << 16) | l) & M for h in [0x0000, 0x0001, 0x1fff, -0x2000, -0x0001, 0x0a5a] for l in halves]
+    samples += [0x20000000]
+    pairs = [(a, b) for a in coeffs for b in samples]
+    pairs += [(rnd.getrandbits(31) - (1 << 30), rnd.getrandbits(30) - (1 << 29)) for _ in range(2000)]
+    return [(a & M, b & M) for a, b in pairs]
+
+
+def check_sequences(model):
+    failed = 0
+    _, overhead = model.call('empty', [])
+    acc = 0x123456789abcdef1
+    print('\n  sequence        operands  mismatched  cycles')
+    for name in INLINE + ['mac64_split', 'mul64_split']:
+        bad = 0
+        cycles = 0
+        pairs = operands(name in ('mac64_split', 'mul64_split'))
+        for a, b in pairs:
+            p = s32(a) * s32(b)
+            if name in ('mulhs_exact', 'mulhs_round'):
+                want = ((p + (1 << 31 if name == 'mulhs_round' else 0)) >> 32) & M
+                _, cycles = model.call(name, [0, 0, a, b])
+                got = model.r[2]
+            else:
+                lo = acc & M if name != 'mul64_split' else 0
+                hi = acc >> 32 if name != 'mul64_split' else 0
+                want = (lo + (hi << 32) + p) & ((1 << 64) - 1)
+                if name == 'mac64':
+                    got, cycles = model.call(name, [lo, hi, a, b])
+                else:
+                    # a split into the signed top and unsigned bottom halves, as biquad_cascade_set_coeffs does
+                    ch = (s32(a) >> 16) & M
+                    args = [lo, hi, ch, a & 0xffff, b] if name == 'mac64_split' else [0, b, ch, a & 0xffff]
+                    got, cycles = model.call(name, args)
+                got |= model.r[1] << 32
+            bad += got != want
+        cycles -= overhead
+        print('  %-14s %9d  %10d  %6d  %s' % (name, len(pairs), bad, cycles, 'FAIL' if bad else ''))
+        failed |= bool(bad)
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--cascade-test', required=True)
+    parser.add_argument('--cc', default='cc')
+    parser.add_argument('--mc', default='llvm-mc')
+    parser.add_argument('--objdump', default='llvm-objdump')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        kernels = assemble(args, open(os.path.join(DSP_DIR, 'biquad_cascade_m0.S')).read(), tmp, 'kernels')
+        model = Model(kernels, ['.time_critical.' + k for k in KERNELS.values()], args.objdump)
+        failed = check_cascades(args, model)
+
+        seqs = assemble(args, MACROS + inline_sequences(), tmp, 'mulhs')
+        failed |= check_sequences(Model(seqs, ['.text.mulhs'], args.objdump))
+    return failed
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,239 @@
+#
+# m0_model.py
+#
+#  Instruction level model of the Cortex-M0+ for the hand written kernels, with its cycle
+#  counts: runs what llvm-objdump disassembles of a Thumb object. Only the instructions the
+#  kernels use, anything else raises. Cycles as the M0+ TRM gives them for zero wait state
+#  memory and the single cycle multiplier the RP2040 has: 1 a data processing instruction, 2 a
+#  load or store, 1 + N a load or store multiple (+ 2 popping pc), 2 a branch taken and 1 not.
+#
+#  Created on: 17 Oct 2026
+#      Author: alex
+#
+
+import re
+import subprocess
+
+M = 0xffffffff
+
+REGS = {'sp': 13, 'lr': 14, 'pc': 15, 'ip': 12, 'r12': 12}
+
+
+def s32(x):
+    x &= M
+    return x - (1 << 32) if x & 0x80000000 else x
+
+
+def reg(s):
+    return int(s[1:]) if re.match(r'r\d+$', s) else REGS[s]
+
+
+def reglist(s):
+    return sorted(reg(x.strip()) for x in s.strip('{}').split(','))
+
+
+class Model:
+    def __init__(self, obj, sections, objdump='llvm-objdump'):
+        self.code = {}
+        self.ins = {}
+        self.sym = {}
+        # each section of the relocatable object starts at 0, so they go 1MB apart
+        for k, section in enumerate(sections):
+            base = k << 20
+            out = subprocess.run([objdump, '-d', '--triple=thumbv6m-none-eabi', '-j', section, obj],
+                                 capture_output=True, text=True, check=True).stdout
+            for line in out.splitlines():
+                m = re.match(r'^([0-9a-f]+) <([^>]+)>:', line)
+                if m:
+                    self.sym[m.group(2)] = base + int(m.group(1), 16)
+                    continue
+                m = re.match(r'^\s+([0-9a-f]+):\s+((?:[0-9a-f]{2}[ \t])+)\s*(\S+)\s*([^@]*)', line)
+                if not m:
+                    continue
+                addr = base + int(m.group(1), 16)
+                raw = bytes.fromhex(re.sub(r'\s', '', m.group(2)))
+                for i, b in enumerate(raw):
+                    self.code[addr + i] = b
+                self.ins[addr] = (m.group(3), m.group(4).strip(), len(raw), base)
+        self.decoded = {}
+        self.mem = {}
+
+    # data memory, words only
+    def ld(self, a):
+        assert a % 4 == 0, hex(a)
+        return self.mem.get(a, 0)
+
+    def st(self, a, v):
+        assert a % 4 == 0, hex(a)
+        self.mem[a] = v & M
+
+    def literal(self, a):
+        return sum(self.code[a + i] << (8 * i) for i in range(4))
+
+    def decode(self, pc):
+        op, ops, size, base = self.ins[pc]
+        o = [x.strip() for x in re.split(r',(?![^{\[]*[}\]])', ops)] if ops else []
+        if op in ('push', 'pop'):
+            args = (reglist(o[0]),)
+        elif op in ('ldm', 'stm'):
+            args = (reg(o[0].rstrip('!')), o[0].endswith('!'), reglist(o[1]))
+        elif op in ('ldr', 'str'):
+            m = re.match(r'\[(\w+)(?:, (#?-?\w+))?\]', o[1])
+            if m.group(1) == 'pc':
+                args = (reg(o[0]), None, self.literal(((pc + 4) & ~3) + int(m.group(2)[1:], 0)))
+            else:
+                off = m.group(2)
+                args = (reg(o[0]), reg(m.group(1)), off and (('#', int(off[1:], 0)) if off[0] == '#' else ('r', reg(off))))
+        elif op[0] == 'b' and op not in ('bics', 'bx', 'bl'):
+            args = (op[1:], base + int(o[0].split()[0], 16))
+        else:
+            # register or immediate operands, two operand forms made three operand
+            ops3 = []
+            for x in o:
+                ops3.append(('#', int(x[1:], 0) & M) if x.startswith('#') else ('r', reg(x)))
+            if op in ('adds', 'subs', 'adcs', 'add', 'asrs', 'lsls', 'lsrs', 'eors', 'ands', 'orrs', 'bics', 'muls') \
+                    and len(ops3) == 2:
+                ops3 = [ops3[0]] + ops3
+            args = tuple(ops3)
+        if op in ('mov', 'add') and o and o[0] == 'pc':
+            raise Exception('pc write at %x' % pc)
+        d = (op, args, pc + size)
+        self.decoded[pc] = d
+        return d
+
+    # runs a function until it returns, r0..r3 from args; returns r0 and the cycles it took
+    def call(self, name, args, sp=0x20040000):
+        r = [0] * 16
+        r[13] = sp
+        r[14] = 0xfffffffe
+        for i, a in enumerate(args):
+            r[i] = a & M
+        pc = self.sym[name]
+        cycles = 0
+        n = z = c = v = 0
+
+        def val(x):
+            return x[1] if x[0] == '#' else r[x[1]]
+
+        while pc != 0xfffffffe:
+            d = self.decoded.get(pc) or self.decode(pc)
+            op, a, npc = d
+            cyc = 1
+            if op == 'push':
+                regs = a[0]
+                r[13] -= 4 * len(regs)
+                for i, rr in enumerate(regs):
+                    self.st(r[13] + 4 * i, r[rr])
+                cyc = 1 + len(regs)
+            elif op == 'pop':
+                regs = a[0]
+                cyc = 1 + len(regs)
+                for i, rr in enumerate(regs):
+                    x = self.ld(r[13] + 4 * i)
+                    if rr == 15:
+                        npc = x & ~1
+                        cyc += 2
+                    else:
+                        r[rr] = x
+                r[13] += 4 * len(regs)
+            elif op in ('ldm', 'stm'):
+                base, wb, regs = a
+                addr = r[base]
+                for i, rr in enumerate(regs):
+                    if op == 'ldm':
+                        r[rr] = self.ld(addr + 4 * i)
+                    else:
+                        self.st(addr + 4 * i, r[rr])
+                if wb and not (op == 'ldm' and base in regs):
+                    r[base] = (addr + 4 * len(regs)) & M
+                cyc = 1 + len(regs)
+            elif op in ('ldr', 'str'):
+                rt, base, off = a
+                if base is None:
+                    r[rt] = off
+                else:
+                    addr = (r[base] + (val(off) if off else 0)) & M
+                    if op == 'ldr':
+                        r[rt] = self.ld(addr)
+                    else:
+                        self.st(addr, r[rt])
+                cyc = 2
+            elif op[0] == 'b' and op not in ('bics', 'bx'):
+                cond, target = a
+                take = {'': True, 'eq': z, 'ne': not z, 'lt': n != v, 'ge': n == v,
+                        'gt': not z and n == v, 'le': z or n != v, 'hs': c, 'lo': not c,
+                        'mi': n, 'pl': not n, 'hi': c and not z, 'ls': not c or z}[cond]
+                if take:
+                    npc = target
+                    cyc = 2
+            elif op == 'bx':
+                npc = r[a[0][1]] & ~1
+                cyc = 2
+            else:
+                d = a[0][1]
+                flags = None
+                if op == 'mov':
+                    r[d] = val(a[1])
+                elif op == 'movs':
+                    res = r[d] = val(a[1])
+                    flags = res
+                elif op in ('adds', 'subs', 'adcs', 'cmp', 'rsbs', 'negs'):
+                    if op == 'cmp':
+                        x, y, ci = r[d], (~val(a[1])) & M, 1
+                    elif op in ('rsbs', 'negs'):
+                        x, y, ci = 0, (~val(a[1])) & M, 1
+                    else:
+                        x, y = val(a[1]), val(a[2])
+                        ci = c if op == 'adcs' else 0
+                        if op == 'subs':
+                            y, ci = (~y) & M, 1
+                    res = x + y + ci
+                    c = int(res > M)
+                    v = ((x ^ res) & (y ^ res)) >> 31 & 1
+                    res &= M
+                    if op != 'cmp':
+                        r[d] = res
+                    flags = res
+                elif op == 'add':
+                    r[d] = (val(a[1]) + val(a[2])) & M
+                elif op == 'muls':
+                    res = r[d] = (val(a[1]) * val(a[2])) & M
+                    flags = res
+                elif op in ('lsls', 'lsrs', 'asrs'):
+                    x = val(a[1])
+                    sh = val(a[2]) & 0xff
+                    imm = a[2][0] == '#'
+                    if op == 'lsls':
+                        res = (x << sh) & M if sh < 32 else 0
+                        if sh:
+                            c = (x >> (32 - sh)) & 1 if sh <= 32 else 0
+                    else:
+                        if imm and sh == 0:
+                            sh = 32
+                        if op == 'lsrs':
+                            res = x >> sh if sh < 32 else 0
+                            if sh:
+                                c = (x >> (sh - 1)) & 1 if sh <= 32 else 0
+                        else:
+                            res = (s32(x) >> min(sh, 31)) & M
+                            if sh:
+                                c = (s32(x) >> min(sh - 1, 31)) & 1
+                    r[d] = res
+                    flags = res
+                elif op in ('eors', 'ands', 'orrs', 'bics'):
+                    x, y = val(a[1]), val(a[2])
+                    res = r[d] = {'eors': x ^ y, 'ands': x & y, 'orrs': x | y, 'bics': x & ~y & M}[op]
+                    flags = res
+                elif op == 'uxth':
+                    r[d] = val(a[1]) & 0xffff
+                elif op == 'sxth':
+                    r[d] = (s32(val(a[1]) << 16) >> 16) & M
+                else:
+                    raise Exception('unhandled %s at %x' % (op, pc))
+                if flags is not None:
+                    n = flags >> 31
+                    z = int(flags == 0)
+            pc = npc
+            cycles += cyc
+        self.r = r
+        return r[0], cycles
@@ -0,0 +1,131 @@
+/*
+ * mulhs_test.c
+ *
+ *  mulhs_exact, mulhs_round and mac64 against int64_t arithmetic:
+ *    mulhs_test
+ *  Both the C versions the host build gets from mulhs.h and the M0+ sequences there modelled
+ *  step by step in C (MULS keeping the low word of each 16 x 16 partial product, ADDS/ADCS
+ *  carrying out of bit 31), on every pair of operands made of the awkward 16 bit halves and on
+ *  random ones. Exits 1 on any mismatch.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "mulhs.h"
+
+#define RANDOM_PAIRS (1u << 24)
+
+// 16 bit halves around every carry and sign boundary
+static const uint16_t halves[] = { 0x0000, 0x0001, 0x0002, 0x7ffe, 0x7fff, 0x8000, 0x8001, 0xfffe, 0xffff, 0x5555, 0xaaaa };
+#define HALF_COUNT (sizeof(halves) / sizeof(halves[0]))
+
+static int64_t ref_mul(int32_t a, int32_t b) {
+    return (int64_t) a * b;
+}
+
+// lo:hi += l:h as an ADDS then an ADCS
+static void adds_adcs(uint32_t *lo, uint32_t *hi, uint32_t l, uint32_t h) {
+    uint32_t carry = *lo + l < *lo;
+    *lo += l;
+    *hi += h + carry;
+}
+
+// the four partial products as the M0+ sequences leave them in registers
+struct partials {
+    uint32_t ll, lh, hl, hh;
+};
+
+static struct partials m0_partials(int32_t a, int32_t b) {
+    uint32_t al = (uint32_t) a & 0xffff, bl = (uint32_t) b & 0xffff;
+    uint32_t ah = (uint32_t) (a >> 16), bh = (uint32_t) (b >> 16);
+    struct partials p = { al * bl, al * bh, ah * bl, ah * bh };
+    return p;
+}
+
+// lsls/asrs of a middle term: its bottom half into the low word, its sign extended top into the high
+static uint32_t mid_lo(uint32_t m) {
+    return m << 16;
+}
+
+static uint32_t mid_hi(uint32_t m) {
+    return (uint32_t) ((int32_t) m >> 16);
+}
+
+static int32_t m0_mulhs_exact(int32_t a, int32_t b) {
+    struct partials p = m0_partials(a, b);
+    uint32_t lo = p.ll, hi = p.hh;
+    adds_adcs(&lo, &hi, mid_lo(p.lh), mid_hi(p.lh));
+    adds_adcs(&lo, &hi, mid_lo(p.hl), mid_hi(p.hl));
+    return (int32_t) hi;
+}
+
+static int32_t m0_mulhs_round(int32_t a, int32_t b) {
+    struct partials p = m0_partials(a, b);
+    uint32_t lo = p.ll, hi = p.hh;
+    adds_adcs(&lo, &hi, mid_lo(p.lh), mid_hi(p.lh));
+    adds_adcs(&lo, &hi, mid_lo(p.hl), mid_hi(p.hl));
+    return (int32_t) (hi + (lo >> 31));
+}
+
+static int64_t m0_mac64(int64_t acc, int32_t a, int32_t b) {
+    struct partials p = m0_partials(a, b);
+    uint32_t lo = (uint32_t) acc, hi = (uint32_t) ((uint64_t) acc >> 32);
+    adds_adcs(&lo, &hi, p.ll, mid_hi(p.lh));
+    adds_adcs(&lo, &hi, mid_lo(p.lh), mid_hi(p.hl));
+    adds_adcs(&lo, &hi, mid_lo(p.hl), p.hh);
+    return (int64_t) (((uint64_t) hi << 32) | lo);
+}
+
+static uint64_t failures;
+
+static void check(int32_t a, int32_t b, int64_t acc) {
+    int64_t prod = ref_mul(a, b);
+    int32_t exact = (int32_t) (prod >> 32);
+    int32_t round = (int32_t) ((prod + 0x80000000ll) >> 32);
+    int64_t sum = (int64_t) ((uint64_t) acc + (uint64_t) prod);
+
+    if(mulhs_exact(a, b) != exact || m0_mulhs_exact(a, b) != exact ||
+            mulhs_round(a, b) != round || m0_mulhs_round(a, b) != round ||
+            mac64(acc, a, b) != sum || m0_mac64(acc, a, b) != sum) {
+        if(!failures) printf("  first mismatch: a %08x b %08x acc %016llx\n", (unsigned) a, (unsigned) b, (unsigned long long) acc);
+        failures++;
+    }
+}
+
+// xorshift64, the same sequence on any host
+static uint64_t rand_state = 88172645463325252ull;
+
+static uint64_t next_rand(void) {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+int main(void) {
+    uint64_t pairs = 0;
+
+    // accumulators next to the wrap of each word as well as random ones
+    static const int64_t accs[] = { 0, -1, INT64_MAX, INT64_MIN, 0xffffffffll, 0x80000000ll };
+    for(uint32_t i = 0; i < HALF_COUNT * HALF_COUNT; i++) {
+        int32_t a = (int32_t) ((uint32_t) halves[i / HALF_COUNT] << 16 | halves[i % HALF_COUNT]);
+        for(uint32_t j = 0; j < HALF_COUNT * HALF_COUNT; j++, pairs++) {
+            int32_t b = (int32_t) ((uint32_t) halves[j / HALF_COUNT] << 16 | halves[j % HALF_COUNT]);
+            check(a, b, accs[pairs % (sizeof(accs) / sizeof(accs[0]))]);
+            check(a, b, (int64_t) next_rand());
+        }
+    }
+
+    for(uint32_t i = 0; i < RANDOM_PAIRS; i++, pairs++) {
+        uint64_t r = next_rand();
+        check((int32_t) r, (int32_t) (r >> 32), (int64_t) next_rand());
+    }
+
+    printf("  %llu operand pairs, %llu mismatched  %s\n", (unsigned long long) pairs,
+            (unsigned long long) failures, failures ? "FAIL" : "");
+    return failures != 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * pcm_format_test.c
+ *
+ *  pcm_decode_s16 and pcm_decode_s24 against the halfword and byte loops they replaced, bit
+ *  for bit:
+ *    pcm_format_test
+ *  Random packets of 0..PCM_TEST_MAX_FRAMES frames at every frame offset into a word aligned
+ *  packet (a packet split over two S/PDIF blocks starts mid packet, and an odd 24 bit frame
+ *  mid word), with a guard frame either side that must be left alone. Exits 1 on any
+ *  mismatch.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pcm_format.h"
+
+#define PCM_TEST_MAX_FRAMES 99
+#define PCM_TEST_ROUNDS 200
+
+#define GUARD 0x5a5a5a5a
+
+// the loops decode_usb_frames had
+static void old_decode_s16(int32_t *dst, const uint8_t *in, uint32_t frames) {
+    const int16_t *in16 = (const int16_t *) in;
+    for(uint32_t i = 0; i < frames * 2; i++) {
+        dst[i] = ((int32_t) in16[i]) << 16u;
+    }
+}
+
+static void old_decode_s24(int32_t *dst, const uint8_t *in, uint32_t frames) {
+    for(uint32_t i = 0; i < frames * 2; i++, in += 3) {
+        dst[i] = (int32_t) ((in[0] << 8u) | (in[1] << 16u) | ((uint32_t) in[2] << 24u));
+    }
+}
+
+static const struct {
+    const char *name;
+    uint32_t frame_bytes;
+    void (*decode)(int32_t *dst, const uint8_t *in, uint32_t frames);
+    void (*old_decode)(int32_t *dst, const uint8_t *in, uint32_t frames);
+} formats[] = {
+        { "s16", 4, pcm_decode_s16, old_decode_s16 },
+        { "s24", 6, pcm_decode_s24, old_decode_s24 },
+};
+
+// xorshift32, the same sequence on any host
+static uint32_t rand_state = 2463534242u;
+
+static uint32_t next_rand(void) {
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+int main(void) {
+    static uint32_t packet[(6 * (2 * PCM_TEST_MAX_FRAMES + 1)) / 4 + 1];
+    static int32_t got[2 * (PCM_TEST_MAX_FRAMES + 2)], want[2 * (PCM_TEST_MAX_FRAMES + 2)];
+    int failed = 0;
+
+    for(uint32_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        uint32_t runs = 0, bad = 0;
+        for(uint32_t round = 0; round < PCM_TEST_ROUNDS; round++) {
+            for(uint32_t i = 0; i < sizeof(packet) / sizeof(packet[0]); i++) {
+                packet[i] = next_rand();
+            }
+            for(uint32_t frames = 0; frames <= PCM_TEST_MAX_FRAMES; frames++) {
+                for(uint32_t offset = 0; offset <= PCM_TEST_MAX_FRAMES; offset++, runs++) {
+                    const uint8_t *in = (const uint8_t *) packet + offset * formats[f].frame_bytes;
+                    for(uint32_t i = 0; i < 2 * (frames + 2); i++) {
+                        got[i] = want[i] = GUARD;
+                    }
+                    formats[f].decode(&got[2], in, frames);
+                    formats[f].old_decode(&want[2], in, frames);
+                    if(memcmp(got, want, sizeof(int32_t) * 2 * (frames + 2))) {
+                        if(!bad) printf("  %s first mismatch: %u frames at frame %u\n", formats[f].name, frames, offset);
+                        bad++;
+                    }
+                }
+            }
+        }
+        printf("  %s  %u runs, %u mismatched  %s\n", formats[f].name, runs, bad, bad ? "FAIL" : "");
+        if(bad) failed = 1;
+    }
+    return failed;
+}
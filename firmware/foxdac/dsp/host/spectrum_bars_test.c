@@ -0,0 +1,84 @@
+/*
+ * spectrum_bars_test.c
+ *
+ *  The spectrum's integer bar heights (ui/spectrum_bars.h) against the float chain they
+ *  replaced, worked in double:
+ *    spectrum_bars_test       compares, exits 1 on a mismatch
+ *    spectrum_bars_test -g    prints ui/spectrum_bar_steps.h for the BAR_ constants as they are
+ *  Built once for the q15 transform and once for the q31 one (SPECTRUM_FFT_Q31). Checks the
+ *  table against the formula in spectrum_bars.h, then bar_height against
+ *    ceil(BAR_HEIGHT * clamp((20 log10(level) - BAR_MIN_DB) / (BAR_MAX_DB - BAR_MIN_DB), 0, 1))
+ *  for every level up to twice the top step. The old code worked that in float, which rounds
+ *  the other way at a handful of levels a hair over a step.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// the table's own checks would stop -g building after a BAR_ constant changes
+#define SPECTRUM_BARS_TEST
+#include "ui/spectrum_bars.h"
+
+// a q31 level carries 8 more bits
+static uint32_t step_of(uint32_t h, int min_db, uint32_t scale) {
+    return (uint32_t) floor(pow(10, (min_db + h * (double) (BAR_MAX_DB - min_db) / BAR_HEIGHT) / 20) * scale);
+}
+
+static uint32_t ref_height(uint32_t level) {
+    double db = 20 * log10(level / (SPECTRUM_FFT_Q31 ? 256.0 : 1.0));
+    double p = (db - BAR_MIN_DB) / (BAR_MAX_DB - BAR_MIN_DB);
+    p = p < 0 ? 0 : p > 1 ? 1 : p;
+    return (uint32_t) ceil(BAR_HEIGHT * p);
+}
+
+static void print_steps(int min_db, uint32_t scale) {
+    printf("static const uint32_t bar_steps[BAR_HEIGHT] = {");
+    for(uint32_t h = 0; h < BAR_HEIGHT; h++) {
+        printf(h % 8 ? " %u," : "\n        %u,", step_of(h, min_db, scale));
+    }
+    printf("\n};\n");
+}
+
+static void generate(void) {
+    printf("/*\n * spectrum_bar_steps.h\n *\n *  Generated by spectrum_bars_test -g, see ui/spectrum_bars.h\n */\n\n");
+    printf("#ifndef FOXDAC_UI_SPECTRUM_BAR_STEPS_H_\n#define FOXDAC_UI_SPECTRUM_BAR_STEPS_H_\n\n");
+    printf("#if SPECTRUM_FFT_Q31\n");
+    print_steps(BAR_MIN_DB_Q31, 256);
+    printf("#ifndef SPECTRUM_BARS_TEST\n_Static_assert(BAR_MIN_DB == %d && BAR_MAX_DB == %d && BAR_HEIGHT == %d, \"regenerate bar_steps: spectrum_bars_test -g\");\n",
+            BAR_MIN_DB_Q31, BAR_MAX_DB, BAR_HEIGHT);
+    printf("#endif\n#else\n");
+    print_steps(BAR_MIN_DB_Q15, 1);
+    printf("#ifndef SPECTRUM_BARS_TEST\n_Static_assert(BAR_MIN_DB == %d && BAR_MAX_DB == %d && BAR_HEIGHT == %d, \"regenerate bar_steps: spectrum_bars_test -g\");\n",
+            BAR_MIN_DB_Q15, BAR_MAX_DB, BAR_HEIGHT);
+    printf("#endif\n#endif\n\n#endif /* FOXDAC_UI_SPECTRUM_BAR_STEPS_H_ */\n");
+}
+
+int main(int argc, char **argv) {
+    if(argc > 1 && !strcmp(argv[1], "-g")) {
+        generate();
+        return 0;
+    }
+
+    uint32_t scale = SPECTRUM_FFT_Q31 ? 256 : 1;
+    uint32_t bad_steps = 0;
+    for(uint32_t h = 0; h < BAR_HEIGHT; h++) {
+        if(bar_steps[h] != step_of(h, BAR_MIN_DB, scale)) bad_steps++;
+    }
+
+    uint32_t levels = 2 * bar_steps[BAR_HEIGHT - 1], bad = 0, first = 0;
+    for(uint32_t level = 0; level <= levels; level++) {
+        if(bar_height(level) != ref_height(level) && !bad++) first = level;
+    }
+
+    int failed = bad_steps || bad;
+    if(bad_steps) printf("  bar_steps is out of date, spectrum_bars_test -g > ui/spectrum_bar_steps.h\n");
+    printf("  %s  %u steps off the formula, %u of %u levels mismatched", SPECTRUM_FFT_Q31 ? "q31" : "q15",
+            bad_steps, bad, levels + 1);
+    if(bad) printf(", first at %u", first);
+    printf("  %s\n", failed ? "FAIL" : "");
+    return failed;
+}
@@ -0,0 +1,153 @@
+/*
+ * level_meter.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+
+#include "level_meter.h"
+
+// odd while the IRQ is writing the snapshot
+static volatile uint32_t meter_seq = 0;
+static struct level_meter_state {
+    struct level_meter_snapshot snapshot;   // its peaks are of the packets since peak_epoch began
+    uint32_t peak_epoch;
+    // the peaks of the epoch before, whole, kept for a read that began it
+    uint32_t prev_peak_sq[2];
+    uint32_t prev_epoch;
+} meter;
+
+// Bumped by core 1 as it starts each read: packets the IRQ publishes after that start new peaks,
+// the ones before it all go to that read
+static volatile uint32_t meter_epoch = 0;
+
+// one sample, the top 16 bits of it already in x; inline, so the packet stays in registers
+static inline void add_sample(int32_t x, uint32_t *peak_sq, uint32_t *sum_sq) {
+    uint32_t sq = (uint32_t) (x * x);
+    if(sq > *peak_sq) *peak_sq = sq;
+    *sum_sq += sq >> 6;
+}
+
+void level_meter_add_samples(struct level_meter_packet *p, const int32_t *samples, uint32_t frames) {
+#if LEVEL_METER
+    uint32_t peak_l = p->peak_sq[0], peak_r = p->peak_sq[1], sum_l = p->sum_sq[0], sum_r = p->sum_sq[1];
+    for(const int32_t *end = samples + 2 * frames; samples != end; samples += 2) {
+        add_sample(samples[0] >> 16, &peak_l, &sum_l);
+        add_sample(samples[1] >> 16, &peak_r, &sum_r);
+    }
+    p->peak_sq[0] = peak_l;
+    p->peak_sq[1] = peak_r;
+    p->sum_sq[0] = sum_l;
+    p->sum_sq[1] = sum_r;
+#endif
+}
+
+void level_meter_add_s16(struct level_meter_packet *p, const uint8_t *in, uint32_t frames) {
+#if LEVEL_METER
+    uint32_t peak_l = p->peak_sq[0], peak_r = p->peak_sq[1], sum_l = p->sum_sq[0], sum_r = p->sum_sq[1];
+    const uint32_t *w = (const uint32_t *) in;
+    for(const uint32_t *end = w + frames; w != end; w++) {
+        add_sample((int16_t) *w, &peak_l, &sum_l);
+        add_sample((int32_t) *w >> 16, &peak_r, &sum_r);
+    }
+    p->peak_sq[0] = peak_l;
+    p->peak_sq[1] = peak_r;
+    p->sum_sq[0] = sum_l;
+    p->sum_sq[1] = sum_r;
+#endif
+}
+
+void level_meter_add_s24(struct level_meter_packet *p, const uint8_t *in, uint32_t frames) {
+#if LEVEL_METER
+    uint32_t peak_l = p->peak_sq[0], peak_r = p->peak_sq[1], sum_l = p->sum_sq[0], sum_r = p->sum_sq[1];
+
+    // the top two bytes of each 3 byte sample; a run half way into a word does a frame bytewise
+    if(frames && ((uintptr_t) in & 3)) {
+        add_sample((int16_t) (in[1] | in[2] << 8), &peak_l, &sum_l);
+        add_sample((int16_t) (in[4] | in[5] << 8), &peak_r, &sum_r);
+        in += 6;
+        frames--;
+    }
+
+    // two frames in three words, bytes l0 l0 l0 r0 | r0 r0 l1 l1 | l1 r1 r1 r1
+    const uint32_t *w = (const uint32_t *) in;
+    for(; frames >= 2; frames -= 2, w += 3) {
+        uint32_t w0 = w[0], w1 = w[1], w2 = w[2];
+        add_sample((int32_t) (w0 << 8) >> 16, &peak_l, &sum_l);
+        add_sample((int16_t) w1, &peak_r, &sum_r);
+        add_sample((int32_t) ((w2 << 24) | (w1 >> 8)) >> 16, &peak_l, &sum_l);
+        add_sample((int32_t) w2 >> 16, &peak_r, &sum_r);
+    }
+    if(frames) {
+        in = (const uint8_t *) w;
+        add_sample((int16_t) (in[1] | in[2] << 8), &peak_l, &sum_l);
+        add_sample((int16_t) (in[4] | in[5] << 8), &peak_r, &sum_r);
+    }
+
+    p->peak_sq[0] = peak_l;
+    p->peak_sq[1] = peak_r;
+    p->sum_sq[0] = sum_l;
+    p->sum_sq[1] = sum_r;
+#endif
+}
+
+void level_meter_publish(const struct level_meter_packet *p, uint32_t frames) {
+    if(!frames) return;
+
+    uint32_t seq = meter_seq;
+    meter_seq = seq + 1;
+    __dmb();
+
+    // only once the count is odd, so a read that began its epoch before this waits for the packet
+    uint32_t epoch = meter_epoch;
+    bool fresh = epoch != meter.peak_epoch;
+    if(fresh) {
+        meter.prev_peak_sq[0] = meter.snapshot.peak_sq[0];
+        meter.prev_peak_sq[1] = meter.snapshot.peak_sq[1];
+        meter.prev_epoch = meter.peak_epoch;
+        meter.peak_epoch = epoch;
+    }
+
+    for(int ch = 0; ch < 2; ch++) {
+        if(fresh || p->peak_sq[ch] > meter.snapshot.peak_sq[ch]) meter.snapshot.peak_sq[ch] = p->peak_sq[ch];
+        if(p->peak_sq[ch] >= LEVEL_METER_OVER_SQ) meter.snapshot.overs[ch]++;
+        meter.snapshot.sum_sq[ch] += p->sum_sq[ch];
+    }
+    meter.snapshot.frames += frames;
+
+    __dmb();
+    meter_seq = seq + 2;
+}
+
+void level_meter_read(struct level_meter_snapshot *snapshot) {
+    // only core 1 writes it
+    uint32_t epoch = meter_epoch + 1;
+    meter_epoch = epoch;
+    __dmb();
+
+    struct level_meter_state state;
+    uint32_t seq;
+    do {
+        seq = meter_seq;
+        __dmb();
+        state = meter;
+        __dmb();
+    } while((seq & 1) || meter_seq != seq);
+
+    // the peaks of the epoch this read closes: still current if the IRQ hasn't published since,
+    // else moved to prev_peak_sq; if neither, nothing came in it
+    *snapshot = state.snapshot;
+    for(int ch = 0; ch < 2; ch++) {
+        if(state.peak_epoch == epoch - 1) {
+            snapshot->peak_sq[ch] = state.snapshot.peak_sq[ch];
+        } else if(state.prev_epoch == epoch - 1) {
+            snapshot->peak_sq[ch] = state.prev_peak_sq[ch];
+        } else {
+            snapshot->peak_sq[ch] = 0;
+        }
+    }
+}
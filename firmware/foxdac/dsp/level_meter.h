@@ -0,0 +1,78 @@
+/*
+ * level_meter.h
+ *
+ *  Per channel peak, RMS and overs of what goes out over S/PDIF. A pass of its own over each
+ *  packet once it is encoded (the decoded samples, or the USB bytes when they went straight
+ *  through) adds it up into a level_meter_packet with everything in registers, which is
+ *  published once a packet under a sequence count; core 1 reads a consistent snapshot of it
+ *  whenever it likes.
+ *
+ *  Peaks and squares are of the top 16 bits of each sample, one multiply serving both. Always
+ *  on, so overs are counted whatever the screen shows; LEVEL_METER 0 takes it out.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_LEVEL_METER_H_
+#define FOXDAC_DSP_LEVEL_METER_H_
+
+#include <stdint.h>
+
+#ifndef LEVEL_METER
+#define LEVEL_METER 1
+#endif
+
+// Cycle budget (estimated from the inner loop, M0+ timings):
+//   a sample is a load (2), a shift, the multiply, a compare and branch (2), a shift and an add,
+//   9 with the four sums and the peaks in r0-r7 beside the pointer and the end; ~22 a frame with
+//   the loop, ~2.1k cycles a 96 frame packet, ~1.1% of core 0 at 192MHz (counted in the core 0
+//   reserve usb_spdif.c plans the DSP with)
+//   Fused into the encoder loops it would save the load and the loop, ~8 a frame, but only if
+//   the four sums sat in r8-r11: those loops already have the pointers, the lookup table, the
+//   0xfff mask and the subframe words in r0-r7, and gcc's Thumb-1 allocator spills the sums to
+//   the stack instead, a load and a store each sample (~+12 a frame), a net loss. It would also
+//   be copied into all four encoder loops, and level_meter_test couldn't check it on its own.
+#define LEVEL_METER_CYCLES_PER_FRAME 22
+
+// squares of the top 16 bits of a sample (x = s >> 16 of the MSB aligned 32 bit one); a packet
+// with a peak reaching LEVEL_METER_OVER_SQ counts as an over (16 bit full scale, either way)
+#define LEVEL_METER_FULL_SCALE_SQ (1u << 30)
+#define LEVEL_METER_OVER_SQ (0x7fffu * 0x7fffu)
+
+// What one packet adds up to. Squares go into the sums >> 6, so LEVEL_METER_MAX_FRAMES of
+// them (255 x 2^24) fit in 32 bits.
+#define LEVEL_METER_MAX_FRAMES 255
+
+struct level_meter_packet {
+    uint32_t peak_sq[2];
+    uint32_t sum_sq[2];
+};
+
+struct level_meter_snapshot {
+    uint32_t peak_sq[2];    // largest x^2 since core 1 last read one, of LEVEL_METER_FULL_SCALE_SQ
+    uint32_t overs[2];      // packets with a peak at LEVEL_METER_OVER_SQ or over, since boot
+    uint64_t sum_sq[2];     // sum of (x^2 >> 6) since boot
+    uint32_t frames;        // frames since boot (wraps, take differences)
+};
+
+static inline void level_meter_packet_init(struct level_meter_packet *p) {
+    p->peak_sq[0] = p->peak_sq[1] = 0;
+    p->sum_sq[0] = p->sum_sq[1] = 0;
+}
+
+// frames of interleaved MSB aligned 32 bit samples
+void level_meter_add_samples(struct level_meter_packet *p, const int32_t *samples, uint32_t frames);
+
+// frames of USB PCM as it comes, word aligned packets (see pcm_format.h)
+void level_meter_add_s16(struct level_meter_packet *p, const uint8_t *in, uint32_t frames);
+void level_meter_add_s24(struct level_meter_packet *p, const uint8_t *in, uint32_t frames);
+
+// the packet's frames into the snapshot, from the IRQ encoding them
+void level_meter_publish(const struct level_meter_packet *p, uint32_t frames);
+
+// a consistent snapshot, from core 1; the peaks are of the packets since the last read, each
+// packet's in exactly one read
+void level_meter_read(struct level_meter_snapshot *snapshot);
+
+#endif /* FOXDAC_DSP_LEVEL_METER_H_ */
@@ -0,0 +1,97 @@
+/*
+ * limiter.c
+ *
+ *  Block based peak limiter with a fixed cap on top (the EQ's preamp). The packet is its own
+ *  delay line: all of it is there before any of it is played, so the gain can be brought down
+ *  ahead of a peak without holding samples back across packets (no added latency, and a packet
+ *  that skips the limiter stays in step with the ones that don't).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "limiter.h"
+#include "mulhs.h"
+
+// gain at the end of the last frame, and the cap it was held under
+static int32_t gain = LIMITER_UNITY;
+static int32_t curr_cap = LIMITER_UNITY;
+
+void limiter_reset(void) {
+    gain = LIMITER_UNITY;
+    curr_cap = LIMITER_UNITY;
+}
+
+bool limiter_is_unity(void) {
+    return gain == LIMITER_UNITY && curr_cap == LIMITER_UNITY;
+}
+
+// highest gain (up to cap) that keeps every sample of the block under the ceiling
+static int32_t block_limit(const int32_t *samples, uint32_t frames, int32_t cap, uint32_t shift) {
+    uint32_t peak = 0;
+    for(uint32_t i = 0; i < 2 * frames; i++) {
+        int32_t s = samples[i];
+        uint32_t a = s < 0 ? -(uint32_t) s : (uint32_t) s;
+        if(a > peak) peak = a;
+    }
+
+    // out = in * gain >> (30 - shift)
+    uint64_t ceiling = (uint64_t) LIMITER_CEILING << (30 - shift);
+    if((uint64_t) peak * (uint32_t) cap <= ceiling) return cap;
+    return (int32_t) (ceiling / peak);
+}
+
+// gain ramps from g0 (exclusive) to g1 over a whole block, a short last block stops part way
+static int32_t apply_ramp(int32_t *samples, uint32_t frames, int32_t g0, int32_t g1, uint32_t shift) {
+    if(g0 == LIMITER_UNITY && g1 == LIMITER_UNITY) {
+        for(uint32_t i = 0; i < 2 * frames; i++) {
+            samples[i] <<= shift;
+        }
+        return g1;
+    }
+
+    // rounded down, so a ramp up stays under g1 and a ramp down gets there a little early
+    int32_t step = (g1 - g0) >> LIMITER_BLOCK_BITS;
+    int32_t g = g0;
+    for(uint32_t i = 0; i < frames; i++) {
+        g += step;
+        samples[0] = mulhs_exact(samples[0], g) << (2 + shift);
+        samples[1] = mulhs_exact(samples[1], g) << (2 + shift);
+        samples += 2;
+    }
+    return g;
+}
+
+void limiter_process(int32_t *samples, uint32_t frames, int32_t cap, uint32_t shift) {
+    if(!frames) return;
+
+    uint32_t n = frames < LIMITER_BLOCK_FRAMES ? frames : LIMITER_BLOCK_FRAMES;
+    uint32_t blocks = (frames + LIMITER_BLOCK_FRAMES - 1) >> LIMITER_BLOCK_BITS;
+    int32_t limit = block_limit(samples, n, curr_cap, shift);
+
+    // the first block's limit has to hold from its first frame
+    int32_t g = gain < limit ? gain : limit;
+
+    for(uint32_t pos = 0; pos < frames; pos += LIMITER_BLOCK_FRAMES) {
+        n = frames - pos < LIMITER_BLOCK_FRAMES ? frames - pos : LIMITER_BLOCK_FRAMES;
+
+        // a new cap is ramped in across the packet, anything over it meanwhile is limited like
+        // any other peak
+        curr_cap += (cap - curr_cap) / (int32_t) blocks--;
+
+        // each end of the ramp under this block's limit and the next one's, so every frame is
+        int32_t end = g + LIMITER_RELEASE;
+        if(end > limit) end = limit;
+        if(end > curr_cap) end = curr_cap;
+        uint32_t next_pos = pos + LIMITER_BLOCK_FRAMES;
+        if(next_pos < frames) {
+            uint32_t next_n = frames - next_pos < LIMITER_BLOCK_FRAMES ? frames - next_pos : LIMITER_BLOCK_FRAMES;
+            limit = block_limit(samples + 2 * next_pos, next_n, curr_cap, shift);
+            if(end > limit) end = limit;
+        }
+
+        g = apply_ramp(samples + 2 * pos, n, g, end, shift);
+    }
+
+    gain = g;
+}
@@ -0,0 +1,48 @@
+/*
+ * limiter.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_LIMITER_H_
+#define FOXDAC_DSP_LIMITER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Q30 gains
+#define LIMITER_UNITY (1 << 30)
+
+// gain is worked out per block of frames and ramped linearly across each
+#define LIMITER_BLOCK_BITS 4
+#define LIMITER_BLOCK_FRAMES (1 << LIMITER_BLOCK_BITS)
+
+// highest output sample, ~-0.07dBFS
+#define LIMITER_CEILING 0x7f000000
+
+// release per block, up from any depth to unity in 256 blocks (~85ms at 48k, ~43ms at 96k)
+#define LIMITER_RELEASE (LIMITER_UNITY >> 8)
+
+// Cycle budget (estimated from the inner loops, both channels, not measured; the dsp_pipeline
+// counters give the real figure):
+//   peak detection ~16 per frame, ~50 per block
+//   at unity gain ~8 per frame (a shift), ramping or limiting ~46 per frame (two exact mulhs)
+//   plus a 64 by 32 bit division for each block over the ceiling (~200)
+//   at 96k (96 frame packets, 6 blocks): ~2.6k cycles per packet at unity, ~7.5k worst case,
+//   so ~1.4% to 3.9% of one core at 192MHz
+#define LIMITER_CYCLES_PER_FRAME 80
+
+void limiter_reset(void);
+
+// Interleaved stereo in place, both channels getting the same gain. out = in * gain << shift,
+// gain never above cap (Q30) and low enough that out stays under LIMITER_CEILING. The gain for
+// each block is known before it is played, the lookahead being the rest of the packet; only a
+// peak in the first block of a packet can need a step down instead of a ramp. A change of cap is
+// ramped in across the packet, so a larger one should be spread over several by the caller.
+void limiter_process(int32_t *samples, uint32_t frames, int32_t cap, uint32_t shift);
+
+// true once the gain and the cap are both back at unity, out = in << shift
+bool limiter_is_unity(void);
+
+#endif /* FOXDAC_DSP_LIMITER_H_ */
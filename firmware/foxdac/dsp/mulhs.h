@@ -0,0 +1,176 @@
+/*
+ * mulhs.h
+ *
+ *  32 x 32 bit multiplies for the M0+, whose MULS only gives the low 32 bits of a product.
+ *  Each product is built from all four 16 x 16 partial products with the carries between
+ *  them propagated, so (unlike leaving out low * low and the middle carry) every result is
+ *  exact, with the rounding below:
+ *
+ *    mulhs_exact(a, b)   high word of a * b, rounded down ((int64_t) a * b >> 32)
+ *    mulhs_round(a, b)   high word of a * b + 2^31, rounded to nearest with halves going up
+ *    mac64(acc, a, b)    acc + a * b in full, wrapping like uint64_t
+ *
+ *  Anything but the M0+ (the host tests) gets the same results from int64_t C.
+ *
+ *  Cycles on the M0+ (single cycle multiplier, as host/m0_kernel_test.py measures the sequences
+ *  below assembled and run on an instruction level model), operands already in registers:
+ *    mulhs_exact 17, mulhs_round 19, mac64 19
+ *    mac64_split 14, mul64_split 12 (asm only, coefficient already split into halves, operands
+ *    bounded as they say)
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_MULHS_H_
+#define FOXDAC_DSP_MULHS_H_
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_6M__)
+
+static inline int32_t mulhs_exact(int32_t a, int32_t b) {
+    int32_t t0, t1, t2;
+    __asm__ (
+            " .syntax unified\n"
+            "uxth   %[t0], %[a]\n"          // al
+            "asrs   %[a], %[a], #16\n"      // ah
+            "uxth   %[t1], %[b]\n"          // bl
+            "asrs   %[b], %[b], #16\n"      // bh
+            "mov    %[t2], %[t0]\n"
+            "muls   %[t2], %[t1]\n"         // al * bl, low word
+            "muls   %[t0], %[b]\n"          // al * bh
+            "muls   %[t1], %[a]\n"          // ah * bl
+            "muls   %[a], %[b]\n"           // ah * bh, high word
+            "lsls   %[b], %[t0], #16\n"     // add the middle terms in across both words
+            "asrs   %[t0], %[t0], #16\n"
+            "adds   %[t2], %[b]\n"
+            "adcs   %[a], %[t0]\n"
+            "lsls   %[b], %[t1], #16\n"
+            "asrs   %[t1], %[t1], #16\n"
+            "adds   %[t2], %[b]\n"
+            "adcs   %[a], %[t1]\n"
+            : [a] "+l" (a), [b] "+l" (b), [t0] "=&l" (t0), [t1] "=&l" (t1), [t2] "=&l" (t2)
+            :
+            : "cc");
+    return a;
+}
+
+static inline int32_t mulhs_round(int32_t a, int32_t b) {
+    int32_t t0, t1, t2;
+    __asm__ (
+            " .syntax unified\n"
+            "uxth   %[t0], %[a]\n"
+            "asrs   %[a], %[a], #16\n"
+            "uxth   %[t1], %[b]\n"
+            "asrs   %[b], %[b], #16\n"
+            "mov    %[t2], %[t0]\n"
+            "muls   %[t2], %[t1]\n"
+            "muls   %[t0], %[b]\n"
+            "muls   %[t1], %[a]\n"
+            "muls   %[a], %[b]\n"
+            "lsls   %[b], %[t0], #16\n"
+            "asrs   %[t0], %[t0], #16\n"
+            "adds   %[t2], %[b]\n"
+            "adcs   %[a], %[t0]\n"
+            "lsls   %[b], %[t1], #16\n"
+            "asrs   %[t1], %[t1], #16\n"
+            "adds   %[t2], %[b]\n"
+            "adcs   %[a], %[t1]\n"
+            "lsrs   %[t2], %[t2], #31\n"    // adding 2^31 to the low word carries iff its top bit is set
+            "adds   %[a], %[t2]\n"
+            : [a] "+l" (a), [b] "+l" (b), [t0] "=&l" (t0), [t1] "=&l" (t1), [t2] "=&l" (t2)
+            :
+            : "cc");
+    return a;
+}
+
+static inline int64_t mac64(int64_t acc, int32_t a, int32_t b) {
+    int32_t t0, t1, t2;
+    __asm__ (
+            " .syntax unified\n"
+            "uxth   %[t0], %[a]\n"
+            "asrs   %[a], %[a], #16\n"
+            "uxth   %[t1], %[b]\n"
+            "asrs   %[b], %[b], #16\n"
+            "mov    %[t2], %[t0]\n"
+            "muls   %[t2], %[t1]\n"         // al * bl
+            "muls   %[t0], %[b]\n"          // al * bh
+            "muls   %[t1], %[a]\n"          // ah * bl
+            "muls   %[a], %[b]\n"           // ah * bh
+            "lsls   %[b], %[t0], #16\n"
+            "asrs   %[t0], %[t0], #16\n"
+            "adds   %Q[acc], %[t2]\n"
+            "adcs   %R[acc], %[t0]\n"
+            "lsls   %[t2], %[t1], #16\n"
+            "asrs   %[t1], %[t1], #16\n"
+            "adds   %Q[acc], %[b]\n"
+            "adcs   %R[acc], %[t1]\n"
+            "adds   %Q[acc], %[t2]\n"
+            "adcs   %R[acc], %[a]\n"
+            : [acc] "+l" (acc), [a] "+l" (a), [b] "+l" (b), [t0] "=&l" (t0), [t1] "=&l" (t1), [t2] "=&l" (t2)
+            :
+            : "cc");
+    return acc;
+}
+
+#else
+
+static inline int32_t mulhs_exact(int32_t a, int32_t b) {
+    return (int32_t) (((int64_t) a * b) >> 32);
+}
+
+static inline int32_t mulhs_round(int32_t a, int32_t b) {
+    return (int32_t) (((int64_t) a * b + 0x80000000ll) >> 32);
+}
+
+static inline int64_t mac64(int64_t acc, int32_t a, int32_t b) {
+    return (int64_t) ((uint64_t) acc + (uint64_t) ((int64_t) a * b));
+}
+
+#endif
+
+#else
+
+// hi:lo += (ch:cl) * v, with ch the signed top and cl the unsigned bottom half of a coefficient.
+// The two middle terms are added together before they go in across both words, which needs
+// |ch * vl + cl * vh| < 2^31: |ch| <= 2^14 and |v| <= 2^29 (coefficients under 4 in Q28 on
+// samples saturated to 30 bits) are enough. Destroys ch cl v vl t.
+.macro mac64_split lo, hi, ch, cl, v, vl, t
+    uxth    \vl, \v
+    asrs    \v, \v, #16
+    mov     \t, \cl
+    muls    \t, \vl             // cl * vl
+    muls    \cl, \v             // cl * vh
+    muls    \vl, \ch            // ch * vl
+    muls    \v, \ch             // ch * vh
+    adds    \cl, \vl            // the middle terms
+    lsls    \vl, \cl, #16
+    asrs    \cl, \cl, #16
+    adds    \lo, \t
+    adcs    \hi, \v
+    adds    \lo, \vl
+    adcs    \hi, \cl
+.endm
+
+// hi:lo = (ch:cl) * hi, the first term of a sum, on the same operands. Destroys ch cl vl t.
+.macro mul64_split lo, hi, ch, cl, vl, t
+    uxth    \vl, \hi
+    asrs    \hi, \hi, #16
+    mov     \lo, \cl
+    muls    \lo, \vl            // cl * vl
+    muls    \cl, \hi            // cl * vh
+    muls    \vl, \ch            // ch * vl
+    muls    \hi, \ch            // ch * vh
+    adds    \cl, \vl
+    lsls    \t, \cl, #16
+    asrs    \cl, \cl, #16
+    adds    \lo, \t
+    adcs    \hi, \cl
+.endm
+
+#endif
+
+#endif /* FOXDAC_DSP_MULHS_H_ */
@@ -0,0 +1,53 @@
+/*
+ * pcm_format.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stddef.h>
+
+#include "pcm_format.h"
+
+void pcm_decode_s16(int32_t *dst, const uint8_t *in, uint32_t frames) {
+    const uint32_t *w = (const uint32_t *) in;
+    for(; frames >= 4; frames -= 4, w += 4, dst += 8) {
+        uint32_t w0 = w[0], w1 = w[1], w2 = w[2], w3 = w[3];
+        dst[0] = pcm_s16_left(w0);
+        dst[1] = pcm_s16_right(w0);
+        dst[2] = pcm_s16_left(w1);
+        dst[3] = pcm_s16_right(w1);
+        dst[4] = pcm_s16_left(w2);
+        dst[5] = pcm_s16_right(w2);
+        dst[6] = pcm_s16_left(w3);
+        dst[7] = pcm_s16_right(w3);
+    }
+    for(; frames; frames--, w++, dst += 2) {
+        dst[0] = pcm_s16_left(*w);
+        dst[1] = pcm_s16_right(*w);
+    }
+}
+
+void pcm_decode_s24(int32_t *dst, const uint8_t *in, uint32_t frames) {
+    // 6 byte frames: one frame realigns a run that starts half way into a word
+    for(; frames && ((uintptr_t) in & 3); frames--, in += 6, dst += 2) {
+        dst[0] = pcm_s24_sample(in);
+        dst[1] = pcm_s24_sample(in + 3);
+    }
+
+    const uint32_t *w = (const uint32_t *) in;
+    for(; frames >= 4; frames -= 4, w += 6, dst += 8) {
+        pcm_s24_unpack2(w, dst);
+        pcm_s24_unpack2(w + 3, dst + 4);
+    }
+    if(frames >= 2) {
+        pcm_s24_unpack2(w, dst);
+        frames -= 2;
+        w += 3;
+        dst += 4;
+    }
+    if(frames) {
+        dst[0] = pcm_s24_sample((const uint8_t *) w);
+        dst[1] = pcm_s24_sample((const uint8_t *) w + 3);
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * pcm_format.h
+ *
+ *  USB PCM to the pipeline's MSB aligned 32 bit samples, a word at a time: a 16 bit frame is
+ *  one word (left in the low half), two 24 bit frames are three. The loops take 4 frames a
+ *  round, which 44, 48 and 96 frame packets fill exactly (45 leaves one). Word loads need the
+ *  packet 4 byte aligned, which packet_slots are; a 24 bit run starting mid word (an odd frame
+ *  into an aligned packet) does its first frame a byte at a time. Against loading a halfword or
+ *  three bytes a sample that is a third of the loads, and no byte assembly for 16 bit.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_DSP_PCM_FORMAT_H_
+#define FOXDAC_DSP_PCM_FORMAT_H_
+
+#include <stdint.h>
+
+// one 16 bit frame
+static inline int32_t pcm_s16_left(uint32_t w) {
+    return (int32_t) (w << 16);
+}
+
+static inline int32_t pcm_s16_right(uint32_t w) {
+    return (int32_t) (w & 0xffff0000u);
+}
+
+// two 24 bit frames, bytes l0 l0 l0 r0 | r0 r0 l1 l1 | l1 r1 r1 r1
+static inline void pcm_s24_unpack2(const uint32_t *in, int32_t *s) {
+    uint32_t w0 = in[0], w1 = in[1], w2 = in[2];
+    s[0] = (int32_t) (w0 << 8);
+    s[1] = (int32_t) (((w0 >> 24) << 8) | (w1 << 16));
+    s[2] = (int32_t) (((w1 >> 16) << 8) | (w2 << 24));
+    s[3] = (int32_t) ((w2 >> 8) << 8);
+}
+
+// one 24 bit sample, any alignment
+static inline int32_t pcm_s24_sample(const uint8_t *in) {
+    return (int32_t) ((in[0] << 8u) | (in[1] << 16u) | ((uint32_t) in[2] << 24u));
+}
+
+void pcm_decode_s16(int32_t *dst, const uint8_t *in, uint32_t frames);
+void pcm_decode_s24(int32_t *dst, const uint8_t *in, uint32_t frames);
+
+#endif /* FOXDAC_DSP_PCM_FORMAT_H_ */
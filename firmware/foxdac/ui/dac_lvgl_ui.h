@@ -20,6 +20,9 @@ extern lv_obj_t * Logo;
 extern lv_obj_t * LogoImg;
 
 extern lv_obj_t * EqCurve;
+extern lv_obj_t * LevelMeters;
+extern lv_obj_t * UsbStats;
+extern lv_obj_t * DspStats;
 
 LV_IMG_DECLARE(img_speaker_png);   // assets/speaker.png
 LV_IMG_DECLARE(img_usb_png);   // assets/usb.png
@@ -40,6 +43,22 @@ void eq_curve_start(void);
 void eq_curve_stop(void);
 void eq_curve_next_band();
 
+void level_meters_init(void);
+void level_meters_start(void);
+void level_meters_stop(void);
+void level_meters_reset(void);
+
+void usb_stats_init(void);
+void usb_stats_start(void);
+void usb_stats_stop(void);
+void usb_stats_next_policy(void);
+
+void dsp_stats_init(void);
+void dsp_stats_start(void);
+void dsp_stats_stop(void);
+void dsp_stats_clear_peaks(void);
+void dsp_stats_next_dither(void);
+
 #ifdef __cplusplus
 } /*extern "C"*/
 #endif
@@ -0,0 +1,105 @@
+/*
+ * dsp_stats.c
+ *
+ *  How much of a packet's time the DSP chain takes: what dsp_pipeline_plan expects for the
+ *  current rate (the whole chain with core 0's IRQs, and each core), whether it fits, and the
+ *  peak each block has measured on each core, all as % of the cycles a packet has. The encoder
+ *  button clears the peaks. OK steps through the dither modes, the one picked is kept across
+ *  reboots.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "pico/stdlib.h"
+#include "stdint.h"
+
+#include "lvgl/lvgl.h"
+
+#include "../dsp/dsp_pipeline.h"
+#include "../dsp/dither.h"
+
+#include "dac_lvgl_ui.h"
+#include "persistent_storage.h"
+
+#define STATS_UPDATE_MS 250
+
+lv_obj_t * DspStats;
+
+static lv_obj_t * stats_lbl;
+static lv_timer_t * stats_timer;
+
+static const char *dither_names[DITHER_MODE_COUNT] = {
+        "off", "tpdf", "shaped 1", "shaped 2",
+};
+
+static uint32_t percent(uint32_t cycles, uint32_t budget) {
+    return budget ? (uint32_t) (((uint64_t) cycles * 100 + budget / 2) / budget) : 0;
+}
+
+static void stats_update(lv_timer_t * timer) {
+    struct dsp_pipeline_load load;
+    dsp_pipeline_get_load(&load);
+
+    char buf[160];
+    int len = lv_snprintf(buf, sizeof(buf), "plan %3u%% %s\ncores %3u%% %3u%%\ndither %9s",
+            (unsigned) percent(load.critical + load.reserve, load.budget), load.fits ? "ok" : "OVER",
+            (unsigned) percent(load.cycles[0], load.budget), (unsigned) percent(load.cycles[1], load.budget),
+            dither_names[dither_get_mode()]);
+
+    for(uint8_t b = 0; b < dsp_pipeline_get_block_count(); b++) {
+        struct dsp_block_stats stats;
+        dsp_pipeline_get_block_stats(b, &stats);
+        uint8_t core = dsp_pipeline_get_block_core(b);
+
+        // a stereo block only runs on the core it was planned on
+        char on[2][5];
+        for(int c = 0; c < 2; c++) {
+            if(core == 2 || core == c) {
+                lv_snprintf(on[c], sizeof(on[c]), "%3u%%", (unsigned) percent(stats.peak[c], load.budget));
+            } else {
+                lv_snprintf(on[c], sizeof(on[c]), "%4s", "-");
+            }
+        }
+        len += lv_snprintf(buf + len, sizeof(buf) - len, "\n%-6.6s%4s %4s", dsp_pipeline_get_block_name(b), on[0], on[1]);
+    }
+
+    lv_label_set_text(stats_lbl, buf);
+}
+
+void dsp_stats_init(void) {
+    DspStats = lv_obj_create(NULL);
+
+    stats_lbl = lv_label_create(DspStats);
+    lv_obj_set_pos(stats_lbl, 0, 0);
+    lv_label_set_text(stats_lbl, "");
+
+    stats_timer = lv_timer_create(stats_update, STATS_UPDATE_MS, NULL);
+    lv_timer_pause(stats_timer);
+
+    dither_set_mode(persist_read_byte(&dither_mode_file, DITHER_DEFAULT_MODE));
+}
+
+// the OK button on the DSP screen
+void dsp_stats_next_dither(void) {
+    uint8_t mode = (dither_get_mode() + 1) % DITHER_MODE_COUNT;
+    dither_set_mode(mode);
+    persist_write_byte(&dither_mode_file, mode);
+    stats_update(stats_timer);
+}
+
+// the encoder button on the DSP screen
+void dsp_stats_clear_peaks(void) {
+    dsp_pipeline_clear_peaks();
+    stats_update(stats_timer);
+}
+
+void dsp_stats_start(void) {
+    lv_scr_load_anim(DspStats, LV_SCR_LOAD_ANIM_NONE, 0, 0, false);
+    stats_update(stats_timer);
+    lv_timer_resume(stats_timer);
+}
+
+void dsp_stats_stop(void) {
+    lv_timer_pause(stats_timer);
+}
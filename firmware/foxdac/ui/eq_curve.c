@@ -7,6 +7,8 @@
 
 #include "pico/stdlib.h"
 #include "stdint.h"
+#include "string.h"
+#include "math.h"
 
 #include "lvgl/lvgl.h"
 
@@ -16,22 +18,32 @@
 #include "dac_lvgl_ui.h"
 #include "persistent_storage.h"
 
-#define NUM_BANDS 8
-#define MAX_RANGE 40
+#define NUM_BANDS BIQUAD_EQ_BANDS
+// chart points, 0..MAX_RANGE is -BIQUAD_EQ_MAX_GAIN..+BIQUAD_EQ_MAX_GAIN in 1dB steps
+#define MAX_RANGE (2 * BIQUAD_EQ_MAX_GAIN)
+
+// "eqb": EQ_STORE_VERSION, then for each band its type (1 byte) and freq, q and gain as little
+// endian IEEE 754 floats (4 bytes each), whatever the compiler does with the struct. The version
+// isn't a band type, so the raw structs an earlier build stored don't pass for it.
+#define EQ_STORE_VERSION 0x81
+#define EQ_STORE_BAND_BYTES 13
+#define EQ_STORE_BYTES (1 + NUM_BANDS * EQ_STORE_BAND_BYTES)
 
 lv_obj_t * EqCurve;
 
 static lv_obj_t * chart;
 static lv_chart_series_t * ser;
 static lv_chart_cursor_t * cursor;
+static lv_obj_t * state_lbl;
 static lv_coord_t value_array[NUM_BANDS];
 static lv_timer_t * eq_timer;
 
-static uint8_t value_array_default[NUM_BANDS];
-static uint8_t value_array_persist[NUM_BANDS];
 
 static uint8_t current_band = 0;
 
+// what state_lbl shows: 0 running, 1 off, 2 off at this rate, 3 + n only n bands running
+static int8_t shown_state = -1;
+
 // set to 1 to stop lvgl from polling the encoder for volume
 extern uint8_t lv_indev_pause_encoder;
 
@@ -41,29 +53,127 @@ static float mapRange(float a1, float a2, float b1, float b2, float s) {
     return b1 + (s - a1) * (b2 - b1) / (a2 - a1);
 }
 
+static float chart_to_gain(int32_t v) {
+    return mapRange(0.0f, MAX_RANGE, -BIQUAD_EQ_MAX_GAIN, BIQUAD_EQ_MAX_GAIN, (float) v);
+}
+
+static lv_coord_t gain_to_chart(float gain) {
+    int32_t v = lroundf(mapRange(-BIQUAD_EQ_MAX_GAIN, BIQUAD_EQ_MAX_GAIN, 0.0f, MAX_RANGE, gain));
+    if(v < 0) v = 0;
+    if(v > MAX_RANGE) v = MAX_RANGE;
+    return v;
+}
+
+static void put_float(uint8_t *p, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static float get_float(const uint8_t *p) {
+    uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+// every band parameter, not just what the chart shows
 static void eq_store(void) {
+    uint8_t buf[EQ_STORE_BYTES];
+    buf[0] = EQ_STORE_VERSION;
     for(int i = 0; i < NUM_BANDS; i++) {
-        value_array_persist[i] = value_array[i];
+        struct biquad_eq_band band;
+        biquad_eq_get_band(i, &band);
+
+        uint8_t *p = &buf[1 + i * EQ_STORE_BAND_BYTES];
+        p[0] = band.type;
+        put_float(p + 1, band.freq);
+        put_float(p + 5, band.q);
+        put_float(p + 9, band.gain);
     }
 
-    persist_write(&eq_curve_file, value_array_persist, sizeof(value_array_persist));
+    persist_write(&eq_band_file, buf, sizeof(buf));
 }
 
-static void eq_load(void) {
-    persist_read(&eq_curve_file, value_array_persist, value_array_default, sizeof(value_array_persist));
+// false if what was stored can't be a band, which then keeps its default; a gain out of range
+// is clamped to it
+static bool decode_band(const uint8_t *p, struct biquad_eq_band *band) {
+    struct biquad_eq_band b = {
+        .type = p[0], .freq = get_float(p + 1), .q = get_float(p + 5), .gain = get_float(p + 9),
+    };
+    if(b.type >= BIQUAD_EQ_TYPE_COUNT || !isfinite(b.freq) || !isfinite(b.q) || !isfinite(b.gain)) {
+        return false;
+    }
+    if(b.gain > BIQUAD_EQ_MAX_GAIN) b.gain = BIQUAD_EQ_MAX_GAIN;
+    if(b.gain < -BIQUAD_EQ_MAX_GAIN) b.gain = -BIQUAD_EQ_MAX_GAIN;
+    *band = b;
+    return true;
+}
 
+static void eq_load(void) {
+    struct biquad_eq_band bands[NUM_BANDS];
     for(int i = 0; i < NUM_BANDS; i++) {
-        value_array[i] = value_array_persist[i];
+        biquad_eq_get_default_band(i, &bands[i]);
+    }
 
-        biquad_eq_set_stage_gain(i, mapRange(0.0f, MAX_RANGE, -20.0f, 20.0f, (float) value_array[i]));
+    uint8_t buf[EQ_STORE_BYTES], none[EQ_STORE_BYTES] = { 0 };
+    bool migrated = false;
+    if(persist_read(&eq_band_file, buf, none, sizeof(buf)) && buf[0] == EQ_STORE_VERSION) {
+        for(int i = 0; i < NUM_BANDS; i++) {
+            decode_band(&buf[1 + i * EQ_STORE_BAND_BYTES], &bands[i]);
+        }
+    } else {
+        // nothing stored yet, keep the gains from when only the chart was stored ("eqc")
+        uint8_t chart_persist[NUM_BANDS];
+        if(persist_read_old("eqc", chart_persist, sizeof(chart_persist))) {
+            for(int i = 0; i < NUM_BANDS; i++) {
+                bands[i].gain = chart_to_gain(chart_persist[i]);
+            }
+            migrated = true;
+        }
+    }
+
+    for(int i = 0; i < NUM_BANDS; i++) {
+        biquad_eq_set_band(i, &bands[i]);
+        value_array[i] = gain_to_chart(bands[i].gain);
     }
 
     biquad_eq_update_coeffs();
 
+    if(migrated) {
+        // on flash in the new format before the old one goes
+        eq_store();
+        persist_flush_all();
+        persist_remove("eqc");
+    }
+
     lv_chart_refresh(chart);
 }
 
+// the EQ passes audio through when it's off, and at rates over BIQUAD_EQ_MAX_FS; at the top
+// rates only as many bands run as the DSP plan found time for
+static void show_state(void) {
+    uint8_t stages = biquad_eq_get_max_stages();
+    int8_t state = !biquad_eq_get_enabled() ? 1 : !biquad_eq_rate_supported() ? 2 :
+            stages < BIQUAD_EQ_BANDS ? 3 + stages : 0;
+    if(state == shown_state) return;
+
+    if(state == 2) {
+        lv_label_set_text_fmt(state_lbl, "off >%dk", BIQUAD_EQ_MAX_FS / 1000);
+    } else if(state >= 3) {
+        lv_label_set_text_fmt(state_lbl, "%d/%d bands", stages, BIQUAD_EQ_BANDS);
+    } else {
+        lv_label_set_text(state_lbl, state ? "off" : "");
+    }
+    shown_state = state;
+}
+
 static void eq_update(lv_timer_t * timer) {
+    show_state();
+
     int32_t enc_delta = encoder_get_delta();
     if(enc_delta != 0) {
         int32_t curr = value_array[current_band];
@@ -77,7 +187,7 @@ static void eq_update(lv_timer_t * timer) {
 
         value_array[current_band] = curr;
 
-        biquad_eq_set_stage_gain(current_band, mapRange(0.0f, MAX_RANGE, -20.0f, 20.0f, (float) curr));
+        biquad_eq_set_band_gain(current_band, chart_to_gain(curr));
         biquad_eq_update_coeffs();
 
         lv_chart_refresh(chart);
@@ -115,13 +225,16 @@ void eq_curve_init(void) {
 
     for(int i = 0; i < NUM_BANDS; i++) {
         ser_array[i] = MAX_RANGE / 2;
-        value_array_default[i] = MAX_RANGE / 2;
     }
 
     lv_chart_refresh(chart);
 
     lv_chart_set_cursor_point(chart, cursor, ser, current_band);
 
+    state_lbl = lv_label_create(EqCurve);
+    lv_obj_align(state_lbl, LV_ALIGN_TOP_RIGHT, -2, 2);
+    lv_label_set_text(state_lbl, "");
+
     eq_timer = lv_timer_create(eq_update, 100, NULL);
     lv_timer_pause(eq_timer);
 
@@ -0,0 +1,144 @@
+/*
+ * level_meters.c
+ *
+ *  Peak and RMS of each channel going out over S/PDIF, with a peak hold and the overs since the
+ *  last reset (OK button). RMS is over the frames since the previous update.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "pico/stdlib.h"
+#include "stdint.h"
+#include "math.h"
+
+#include "lvgl/lvgl.h"
+
+#include "../dsp/level_meter.h"
+
+#include "dac_lvgl_ui.h"
+
+#define METER_UPDATE_MS 50
+// peak hold lasts this many updates, then falls back to the current peak
+#define METER_HOLD_UPDATES 30
+// bars span -METER_RANGE_DB..0dBFS; readouts stop at -99.9
+#define METER_RANGE_DB 60
+#define METER_FLOOR_DB10 (-999)
+
+lv_obj_t * LevelMeters;
+
+static lv_obj_t * level_lbl[2];
+static lv_obj_t * level_bar[2];
+static lv_obj_t * hold_lbl;
+static lv_obj_t * overs_lbl;
+static lv_timer_t * meter_timer;
+
+static struct level_meter_snapshot last;
+static uint32_t hold_peak[2];
+static uint32_t hold_age[2];
+static uint32_t overs_base[2];
+
+// tenths of a dB of v against full_scale
+static int32_t to_db10(float v, float full_scale) {
+    if(v <= 0.0f) return METER_FLOOR_DB10;
+    int32_t db10 = lroundf(200.0f * log10f(v / full_scale));
+    return db10 < METER_FLOOR_DB10 ? METER_FLOOR_DB10 : db10;
+}
+
+// "-12.3", or "  -" at the floor
+static void format_db10(char *buf, int32_t db10) {
+    if(db10 <= METER_FLOOR_DB10) {
+        lv_snprintf(buf, 8, "%5s", "-");
+    } else {
+        int32_t a = db10 < 0 ? -db10 : db10;
+        lv_snprintf(buf, 8, "%s%d.%d", db10 < 0 ? "-" : "", a / 10, a % 10);
+    }
+}
+
+static void meter_update(lv_timer_t * timer) {
+    struct level_meter_snapshot now;
+    level_meter_read(&now);
+
+    uint32_t frames = now.frames - last.frames;
+    char rms_txt[8], peak_txt[8], hold_txt[2][8];
+    static const char *names[2] = { "L", "R" };
+
+    for(int ch = 0; ch < 2; ch++) {
+        // sum_sq is of 16 bit samples squared >> 6; a full scale sine reads -3.0
+        float rms = frames ? sqrtf((float) (now.sum_sq[ch] - last.sum_sq[ch]) / frames) : 0.0f;
+        int32_t rms_db10 = to_db10(rms, 32768.0f / 8.0f);
+        // nothing new, keep what's shown; peaks are 16 bit samples squared
+        uint32_t peak = frames ? now.peak_sq[ch] : 0;
+        int32_t peak_db10 = to_db10(sqrtf((float) peak), 32768.0f);
+
+        if(peak >= hold_peak[ch] || ++hold_age[ch] >= METER_HOLD_UPDATES) {
+            hold_peak[ch] = peak;
+            hold_age[ch] = 0;
+        }
+
+        format_db10(rms_txt, rms_db10);
+        format_db10(peak_txt, peak_db10);
+        format_db10(hold_txt[ch], to_db10(sqrtf((float) hold_peak[ch]), 32768.0f));
+        lv_label_set_text_fmt(level_lbl[ch], "%s %5s %5s", names[ch], rms_txt, peak_txt);
+
+        int32_t bar = METER_RANGE_DB + peak_db10 / 10;
+        lv_bar_set_value(level_bar[ch], bar < 0 ? 0 : bar, LV_ANIM_OFF);
+    }
+
+    lv_label_set_text_fmt(hold_lbl, "hold %5s %5s", hold_txt[0], hold_txt[1]);
+    lv_label_set_text_fmt(overs_lbl, "over %5u %5u", (unsigned) (now.overs[0] - overs_base[0]),
+            (unsigned) (now.overs[1] - overs_base[1]));
+
+    last = now;
+}
+
+void level_meters_init(void) {
+    LevelMeters = lv_obj_create(NULL);
+
+    lv_obj_t * header = lv_label_create(LevelMeters);
+    lv_obj_set_pos(header, 0, 0);
+    lv_label_set_text(header, "    rms  peak");
+
+    for(int ch = 0; ch < 2; ch++) {
+        level_lbl[ch] = lv_label_create(LevelMeters);
+        lv_obj_set_pos(level_lbl[ch], 0, 8 + ch * 16);
+        lv_label_set_text(level_lbl[ch], "");
+
+        level_bar[ch] = lv_bar_create(LevelMeters);
+        lv_obj_set_size(level_bar[ch], 127, 5);
+        lv_obj_set_pos(level_bar[ch], 0, 17 + ch * 16);
+        lv_bar_set_range(level_bar[ch], 0, METER_RANGE_DB);
+    }
+
+    hold_lbl = lv_label_create(LevelMeters);
+    lv_obj_set_pos(hold_lbl, 0, 42);
+    lv_label_set_text(hold_lbl, "");
+
+    overs_lbl = lv_label_create(LevelMeters);
+    lv_obj_set_pos(overs_lbl, 0, 52);
+    lv_label_set_text(overs_lbl, "");
+
+    meter_timer = lv_timer_create(meter_update, METER_UPDATE_MS, NULL);
+    lv_timer_pause(meter_timer);
+}
+
+// overs and peak hold start again from now
+void level_meters_reset(void) {
+    level_meter_read(&last);
+    for(int ch = 0; ch < 2; ch++) {
+        overs_base[ch] = last.overs[ch];
+        hold_peak[ch] = 0;
+        hold_age[ch] = 0;
+    }
+}
+
+void level_meters_start(void) {
+    // RMS from the frames from here on, not since the screen was last left
+    level_meter_read(&last);
+    lv_scr_load_anim(LevelMeters, LV_SCR_LOAD_ANIM_NONE, 0, 0, false);
+    lv_timer_resume(meter_timer);
+}
+
+void level_meters_stop(void) {
+    lv_timer_pause(meter_timer);
+}
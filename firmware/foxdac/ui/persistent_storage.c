@@ -13,7 +13,7 @@
 
 #include "../drivers/lfs/pico_hal.h"
 
-lfs_file_t vol_file, input_file, eq_curve_file;
+lfs_file_t vol_file, input_file, eq_band_file, overflow_policy_file, dither_mode_file;
 
 void persist_init(void) {
     if (pico_mount(false) != LFS_ERR_OK) {
@@ -28,16 +28,21 @@ void persist_init(void) {
 
     lfs_file_open(&vol_file, "vol", LFS_O_RDWR | LFS_O_CREAT);
     lfs_file_open(&input_file, "inp", LFS_O_RDWR | LFS_O_CREAT);
-    lfs_file_open(&eq_curve_file, "eqc", LFS_O_RDWR | LFS_O_CREAT);
+    lfs_file_open(&eq_band_file, "eqb", LFS_O_RDWR | LFS_O_CREAT);
+    lfs_file_open(&overflow_policy_file, "ovf", LFS_O_RDWR | LFS_O_CREAT);
+    lfs_file_open(&dither_mode_file, "dth", LFS_O_RDWR | LFS_O_CREAT);
 }
 
 void persist_flush_all(void) {
     lfs_file_sync(&vol_file);
     lfs_file_sync(&input_file);
-    lfs_file_sync(&eq_curve_file);
+    lfs_file_sync(&eq_band_file);
+    lfs_file_sync(&overflow_policy_file);
+    lfs_file_sync(&dither_mode_file);
 }
 
-void persist_read(lfs_file_t* file, uint8_t* val, uint8_t* default_val, int len) {
+// false if the default was used
+bool persist_read(lfs_file_t* file, uint8_t* val, uint8_t* default_val, int len) {
     int tmp;
 
     lfs_file_rewind(file);
@@ -46,7 +51,10 @@ void persist_read(lfs_file_t* file, uint8_t* val, uint8_t* default_val, int len)
     if(read_sz != len) {
         // file empty or wrong size, return default
         memcpy(val, default_val, len);
+        return false;
     }
+
+    return true;
 }
 
 void persist_write(lfs_file_t* file, uint8_t* val, int len) {
@@ -63,3 +71,20 @@ uint8_t persist_read_byte(lfs_file_t* file, uint8_t default_val) {
 void persist_write_byte(lfs_file_t* file, uint8_t val) {
     persist_write(file, &val, sizeof(uint8_t));
 }
+
+// a file only older firmware wrote, not kept open; false if there is none or it's the wrong size.
+// Remove it once what it held is stored again.
+bool persist_read_old(const char* path, uint8_t* val, int len) {
+    lfs_file_t file;
+    if(lfs_file_open(&file, path, LFS_O_RDONLY) < 0) {
+        return false;
+    }
+
+    lfs_ssize_t read_sz = lfs_file_read(&file, val, len);
+    lfs_file_close(&file);
+    return read_sz == len;
+}
+
+void persist_remove(const char* path) {
+    lfs_remove(path);
+}
@@ -10,13 +10,15 @@
 
 #include "../drivers/lfs/pico_hal.h"
 
-extern lfs_file_t vol_file, input_file, eq_curve_file;
+extern lfs_file_t vol_file, input_file, eq_band_file, overflow_policy_file, dither_mode_file;
 
 void persist_init(void);
 void persist_flush_all(void);
-void persist_read(lfs_file_t* file, uint8_t* val, uint8_t* default_val, int len);
+bool persist_read(lfs_file_t* file, uint8_t* val, uint8_t* default_val, int len);
 void persist_write(lfs_file_t* file, uint8_t* val, int len);
 uint8_t persist_read_byte(lfs_file_t* file, uint8_t default_val);
 void persist_write_byte(lfs_file_t* file, uint8_t val);
+bool persist_read_old(const char* path, uint8_t* val, int len);
+void persist_remove(const char* path);
 
 #endif /* FOXDAC_UI_PERSISTENT_STORAGE_H_ */
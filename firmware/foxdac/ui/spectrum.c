@@ -6,40 +6,98 @@
  */
 
 #include "pico/stdlib.h"
+#include "hardware/sync.h"
 #include "stdint.h"
 
 #include "lvgl/lvgl.h"
 
+#include "../dsp/cycles.h"
+#include "../dsp/dsp_async.h"
+#include "../dsp/halfband.h"
+
 #include "dac_lvgl_ui.h"
 #include "spectrum.h"
+#include "spectrum_bars.h"
 #include "ui.h"
 
 #include <arm_math.h>
 
-// don't forget to enable ARM_TABLE_TWIDDLECOEF_Q15_x in CMSISDSP/CommonTables/CMakeLists.txt
-#define FFT_SIZE 1024
-#define FFT_SIZE_F (1024.0f)
+// the sizes come from SPECTRUM_FFT_SIZES in CMakeLists.txt, which also picks the CMSIS twiddle
+// tables; the largest one built in sizes the buffers
+#define FFT_MAX_SIZE (SPECTRUM_FFT_SIZES >> SPECTRUM_FFT_2048 ? 2048 : SPECTRUM_FFT_SIZES >> SPECTRUM_FFT_1024 ? 1024 : \
+        SPECTRUM_FFT_SIZES >> SPECTRUM_FFT_512 ? 512 : 256)
+_Static_assert(SPECTRUM_FFT_SIZES && SPECTRUM_FFT_SIZES >> SPECTRUM_FFT_SIZE_COUNT == 0, "bad SPECTRUM_FFT_SIZES");
+_Static_assert(SPECTRUM_FFT_SIZES >> SPECTRUM_DEFAULT_FFT_SIZE & 1u, "default spectrum FFT size not built in");
 
 #define NUM_BARS 41
-#define NUM_BARS_F 41.0f
-
-#define MIN_BAR_FREQ 80.0f
-#define MAX_BAR_FREQ 20000.0f
-
-//#define FFT_BIN_SIZE (sample_rate / (FFT_SIZE * 2))
-#define FFT_BIN_SIZE (sample_rate >> 11)
 
-#define BAR_MIN_DB 35
-#define BAR_MAX_DB 90
-
-static uint8_t spectrum_running = 0;
+// everything from the FFT on is integer, the M0+ has no FPU and soft float log10f per bar
+// was most of the frame
+
+// bar edges in Hz (Q16), log scale from 80Hz to 20kHz: 80 * (20000 / 80) ^ (i / NUM_BARS)
+static const uint32_t bar_edges[NUM_BARS + 1] = {
+        5242880, 5998687, 6863452, 7852879, 8984942, 10280201,
+        11762183, 13457807, 15397870, 17617610, 20157345, 23063205,
+        26387972, 30192033, 34544483, 39524377, 45222168, 51741346,
+        59200321, 67734574, 77499116, 88671303, 101454060, 116079566,
+        132813468, 151959711, 173866055, 198930394, 227607980, 260419695,
+        297961510, 340915313, 390061288, 446292093, 510629068, 584240791,
+        668464299, 764829374, 875086333, 1001237813, 1145575150, 1310720000,
+};
+
+// the IRQ appends mono samples at the USB rate to a ring and never stops; core 1 decimates them
+// to 32..48k into a ring of two frames and takes a frame every hop (half or a quarter of the FFT
+// size) from that, so frames overlap and come at a fixed rate. The capture ring is sized for the
+// USB rate whatever the FFT sizes, 21ms at 192k
+#define CAPTURE_SIZE 4096
+#define CAPTURE_MASK (CAPTURE_SIZE - 1)
+// the IRQ publishes a packet's samples once they're all written, so it can be up to a packet
+// (193 samples at 192k) past capture_wr
+#define CAPTURE_MARGIN 256
+
+#define ANALYSIS_SIZE (FFT_MAX_SIZE * 2)
+#define ANALYSIS_MASK (ANALYSIS_SIZE - 1)
+
+static volatile uint8_t spectrum_running = 0;
+// the rate frames are analysed at, after decimation
 static uint32_t sample_rate = 48000;
 
 static int interp_step = 0;
 static const int interp_times = 1; // off temporarily
 
-static q15_t sample_buf[FFT_SIZE];
-static volatile int sample_buf_pos = 0;
+static q15_t capture_buf[CAPTURE_SIZE];
+// samples appended since boot and the rate they came at, only written by the IRQ
+static volatile uint32_t capture_wr = 0;
+static volatile uint32_t capture_rate = 48000;
+
+// core 1 only: decimation from capture_buf into analysis_buf, and where the next frame ends
+static uint32_t capture_rd;
+static uint32_t decimated_rate = 48000;
+static struct halfband decim_wide, decim_narrow;
+static q15_t analysis_buf[ANALYSIS_SIZE];
+static uint32_t analysis_wr;
+static uint32_t frame_end;
+static uint8_t overlap = SPECTRUM_DEFAULT_OVERLAP;
+static uint8_t averaging = SPECTRUM_DEFAULT_AVERAGING;
+
+static struct spectrum_stats stats;
+static uint32_t rate_start_us, rate_frames;
+
+// core 1's FFT size, and the one asked for
+static uint8_t fft_size;
+static volatile uint8_t requested_fft_size = SPECTRUM_DEFAULT_FFT_SIZE;
+
+#if SPECTRUM_FFT_Q31
+typedef q31_t fft_sample_t;
+static arm_rfft_instance_q31 fft_instance;
+#else
+typedef q15_t fft_sample_t;
+static arm_rfft_instance_q15 fft_instance;
+#endif
+static fft_sample_t sample_buf[FFT_MAX_SIZE];
+static fft_sample_t fft_output[FFT_MAX_SIZE * 2];
+
+static q31_t bar_avg[NUM_BARS];
 
 static lv_obj_t * chart;
 static lv_coord_t value_array[NUM_BARS];
@@ -49,12 +107,37 @@ static lv_coord_t old_value_array[NUM_BARS];
 
 static lv_timer_t * spectrum_timer;
 
-static arm_rfft_instance_q15 fft_instance;
-static q15_t fft_output[FFT_SIZE * 2];
-
-static q15_t window[FFT_SIZE];
-static int startbins[NUM_BARS];
-static int endbins[NUM_BARS];
+// the OK button steps through these at each FFT size built in, then on to the next size
+static const struct {
+    uint8_t overlap;
+    uint8_t averaging;
+} settings[] = {
+        { SPECTRUM_OVERLAP_50, 0 },
+        { SPECTRUM_OVERLAP_75, 2 },
+};
+static uint8_t setting = 0;
+
+// the settings and stats over the bars for a while after a press or coming to the screen
+#define STATS_UPDATE_MS 250
+#define STATS_SHOW_UPDATES 20
+static lv_obj_t * stats_lbl;
+static lv_timer_t * stats_timer;
+static uint32_t stats_updates_left = 0;
+
+// a Hann window for each size built in, one after the other
+#define WINDOW_LEN(size) ((SPECTRUM_FFT_SIZES >> (size) & 1u) * SPECTRUM_FFT_LEN(size))
+static q15_t windows[WINDOW_LEN(0) + WINDOW_LEN(1) + WINDOW_LEN(2) + WINDOW_LEN(3)];
+static const q15_t *window_of[SPECTRUM_FFT_SIZE_COUNT];
+
+// The mean over a bar's outputs x 8 is the level bar_steps are set for at 1024 points. A bar has
+// twice the outputs each time the size doubles and arm_rfft_q15/q31 scale by 1 / SPECTRUM_FFT_LEN,
+// so a tone's mean halves; the x 8 goes with the size to keep it at the same height.
+#define BAR_LEVEL_SHIFT(size) (3 + (size) - SPECTRUM_FFT_1024)
+
+// the outputs each bar averages for each size at sample_rate (re and im each count, so an output is
+// half a bin wide)
+static uint16_t startbins[SPECTRUM_FFT_SIZE_COUNT][NUM_BARS];
+static uint16_t endbins[SPECTRUM_FFT_SIZE_COUNT][NUM_BARS];
 
 lv_obj_t * Spectrum;
 
@@ -62,115 +145,274 @@ static float hanning(short in, size_t i, size_t s) {
     return in * 0.5f * (1.0f - cosf(2.0f * ((float)M_PI) * (float)(i) / (float)(s - 1.0f)));
 }
 
-static void init_tables(void) {
-    // precompute window
-    for(int i = 0; i < FFT_SIZE; i++) {
-        float wnd = hanning(1, i, FFT_SIZE);
-        window[i] = clip_q31_to_q15((q31_t) (wnd * 32768.0f));
+static void init_windows(void) {
+    // float once at boot: an integer cos an lsb out here and there would move the bars
+    q15_t *window = windows;
+    for(uint8_t size = 0; size < SPECTRUM_FFT_SIZE_COUNT; size++) {
+        if(!(SPECTRUM_FFT_SIZES >> size & 1u)) continue;
+        uint32_t len = SPECTRUM_FFT_LEN(size);
+        window_of[size] = window;
+        for(uint32_t i = 0; i < len; i++) {
+            float wnd = hanning(1, i, len);
+            *window++ = clip_q31_to_q15((q31_t) (wnd * 32768.0f));
+        }
     }
+}
 
-    // precompute log bins
-    for (int i = 0; i < NUM_BARS; i++) {
-        // log scale, bins spaced at:
-        // min * (max/min) ^ x
-        float bar_freq = MIN_BAR_FREQ * powf((MAX_BAR_FREQ / MIN_BAR_FREQ), i / NUM_BARS_F);
-        float bar_freq_next = ((i + 1) == NUM_BARS) ? MAX_BAR_FREQ
-                : (MIN_BAR_FREQ * powf((MAX_BAR_FREQ / MIN_BAR_FREQ), (i + 1) / NUM_BARS_F));
-
-        startbins[i] = floorf(bar_freq / FFT_BIN_SIZE);
-        endbins[i] = ceilf(bar_freq_next / FFT_BIN_SIZE);
+// log bins for every size, again whenever sample_rate changes
+static void map_bins(void) {
+    for(uint8_t size = 0; size < SPECTRUM_FFT_SIZE_COUNT; size++) {
+        uint32_t len = SPECTRUM_FFT_LEN(size);
+        // Hz an output in Q16, sample_rate is 48k at most
+        uint32_t bin_q16 = (sample_rate << 16) / (2 * len);
+        for (int i = 0; i < NUM_BARS; i++) {
+            // never DC, nothing past Nyquist (bars there come out empty)
+            uint32_t start = MAX(bar_edges[i] / bin_q16, 2u);
+            uint32_t end = MIN((bar_edges[i + 1] + bin_q16 - 1) / bin_q16, len);
+            startbins[size][i] = start;
+            endbins[size][i] = MAX(start, end);
+        }
     }
 }
 
+static void set_fft_size(uint8_t size) {
+    fft_size = size;
+#if SPECTRUM_FFT_Q31
+    arm_rfft_init_q31(&fft_instance, SPECTRUM_FFT_LEN(size), 0, 1);
+#else
+    arm_rfft_init_q15(&fft_instance, SPECTRUM_FFT_LEN(size), 0, 1);
+#endif
+}
+
+#if SPECTRUM_FFT_Q31
+// |x| saturated, 8 bits down so the widest bar (~230 outputs at 2048) sums in 32 bits
+static inline q31_t abs_bin(q31_t x) {
+    return (x >= 0 ? x : x == INT32_MIN ? INT32_MAX : -x) >> 8;
+}
+#else
+// |x| saturated, as arm_abs_q15
+static inline q31_t abs_bin(q15_t x) {
+    return x >= 0 ? x : x == INT16_MIN ? INT16_MAX : -x;
+}
+#endif
+
 // called from usb_spdif.c, runs in IRQ on core 0
-void spectrum_consume_samples(int16_t* samples, uint32_t sample_count, uint32_t rate) {
-    if(!spectrum_running || sample_buf_pos == FFT_SIZE || interp_step < interp_times) return;
-
-    for (int i = 0; i < sample_count * 2; i += 2) {
-        // if the sample rate is 96000, decimate by 2 to get 48000
-        // this will alias frequencies > 24k but big deal, it's not meant to be a real spectrum analyser
-        if(rate == 96000) {
-            // skip samples
-            if(i + 2 < sample_count * 2) {
-                i += 2;
-            }
-
-            // decimated down to 48k
-            sample_rate = 48000;
-        } else {
-            sample_rate = rate;
+bool spectrum_wants_samples(void) {
+    return spectrum_running;
+}
+
+void spectrum_consume_samples(int32_t* samples, uint32_t sample_count, uint32_t rate) {
+    if(!spectrum_wants_samples()) return;
+
+    // just the samples, core 1 takes them down to 48k or below; into the ring in at most two
+    // runs, so the loop doesn't wrap each index
+    capture_rate = rate;
+    uint32_t wr = capture_wr;
+    while (sample_count) {
+        uint32_t pos = wr & CAPTURE_MASK;
+        uint32_t n = MIN(sample_count, CAPTURE_SIZE - pos);
+        q15_t *dst = &capture_buf[pos];
+        for (uint32_t i = 0; i < n; i++, samples += 2) {
+            // average both channels
+            dst[i] = (q15_t) (((samples[0] >> 16) + (samples[1] >> 16)) >> 1);
         }
+        wr += n;
+        sample_count -= n;
+    }
+
+    // the samples before the count that says they are there
+    __dmb();
+    capture_wr = wr;
+}
 
-        // average both channels
-        q31_t channel_avg = (((q31_t) samples[i]) + ((q31_t) samples[i + 1])) >> 1;
+// capture_rd .. wr through the decimator into analysis_buf, factor constant in each call so
+// each rate gets its own loop
+static inline void decimate(uint32_t wr, uint8_t factor) {
+    for(; capture_rd != wr; capture_rd++) {
+        int32_t y = capture_buf[capture_rd & CAPTURE_MASK];
+        if(factor == 4 && !halfband_push(&decim_wide, halfband_wide, HALFBAND_WIDE_PAIRS, y, &y)) continue;
+        if(factor >= 2 && !halfband_push(&decim_narrow, halfband_narrow, HALFBAND_NARROW_PAIRS, y, &y)) continue;
+        analysis_buf[analysis_wr++ & ANALYSIS_MASK] = clip_q31_to_q15(y);
+    }
+}
 
-        // take only left channel
-        //q31_t channel_avg = ((q31_t) samples[i]);
+// a new start in analysis_buf: the first frame is the next frame's worth of samples
+static void restart_analysis(void) {
+    halfband_reset(&decim_wide);
+    halfband_reset(&decim_narrow);
+    frame_end = analysis_wr + SPECTRUM_FFT_LEN(fft_size);
+}
 
-        sample_buf[sample_buf_pos] = clip_q31_to_q15((((q31_t) (window[sample_buf_pos]) * (channel_avg)) >> 15));
-        sample_buf_pos++;
+static void clear_averages(void) {
+    for(int i = 0; i < NUM_BARS; i++) {
+        bar_avg[i] = 0;
+    }
+}
 
-        if(sample_buf_pos == FFT_SIZE) {
-            return;
-        }
+// everything the IRQ has captured into analysis_buf; false if some was lost (core 1 fell too
+// far behind, or the IRQ overwrote part of it meanwhile), with the analysis started again
+static bool drain_capture(void) {
+    uint32_t rate = capture_rate;
+    uint8_t factor = rate > 96000 ? 4 : rate > 48000 ? 2 : 1;
+    if(rate != decimated_rate) {
+        decimated_rate = rate;
+        sample_rate = rate / factor;
+        map_bins();
+        restart_analysis();
+    }
+
+    uint32_t wr = capture_wr;
+    __dmb();
+    if(wr - capture_rd > CAPTURE_SIZE - CAPTURE_MARGIN) {
+        capture_rd = wr;
+        restart_analysis();
+        return false;
+    }
+
+    uint32_t start = capture_rd;
+    if(factor == 4) {
+        decimate(wr, 4);
+    } else if(factor == 2) {
+        decimate(wr, 2);
+    } else {
+        decimate(wr, 1);
+    }
+
+    __dmb();
+    if(capture_wr - start > CAPTURE_SIZE - CAPTURE_MARGIN) {
+        restart_analysis();
+        return false;
+    }
+    return true;
+}
+
+// the frame ending at frame_end, windowed into sample_buf
+static void take_frame(void) {
+    uint32_t len = SPECTRUM_FFT_LEN(fft_size);
+    const q15_t *window = window_of[fft_size];
+    uint32_t start = frame_end - len;
+    for(uint32_t i = 0; i < len; i++) {
+        q31_t x = (q31_t) window[i] * analysis_buf[(start + i) & ANALYSIS_MASK];
+#if SPECTRUM_FFT_Q31
+        sample_buf[i] = x << 1;
+#else
+        sample_buf[i] = (q15_t) (x >> 15);
+#endif
     }
 }
 
 void spectrum_loop(void) {
-    if(!spectrum_running || sample_buf_pos != FFT_SIZE || interp_step < interp_times) return;
+    if(!spectrum_running) return;
+
+    // a new size takes its first frame from the samples after now, with an empty average
+    uint8_t size = requested_fft_size;
+    if(size != fft_size) {
+        set_fft_size(size);
+        frame_end = analysis_wr + SPECTRUM_FFT_LEN(size);
+        clear_averages();
+    }
+
+    if(!drain_capture()) stats.dropped++;
+
+    uint32_t len = SPECTRUM_FFT_LEN(fft_size);
+    uint32_t hop = len >> (1 + overlap);
+    if((int32_t) (analysis_wr - frame_end) < 0) return;
+
+    // decimated more than the ring holds since the last frame, go to the newest one
+    if(analysis_wr - frame_end > ANALYSIS_SIZE - len) {
+        uint32_t behind = (analysis_wr - frame_end) / hop;
+        stats.dropped += behind;
+        frame_end += behind * hop;
+    }
 
+    // core 1's dsp_async IRQ can come in anywhere here, its cycles aren't the frame's
+    uint32_t start = cycles_now();
+    uint32_t irq_start = dsp_async_core1_cycles();
+    take_frame();
+    frame_end += hop;
+
+#if SPECTRUM_FFT_Q31
+    arm_rfft_q31(&fft_instance, sample_buf, fft_output);
+#else
     arm_rfft_q15(&fft_instance, sample_buf, fft_output);
-    arm_abs_q15(fft_output, fft_output, FFT_SIZE * 2);
+#endif
 
     for (int i = 0; i < NUM_BARS; i++) {
-        // log scale, bins spaced at:
-        // min * (max/min) ^ x
-        int startbin = startbins[i];
-        int endbin = endbins[i];
+        int startbin = startbins[fft_size][i];
+        int endbin = endbins[fft_size][i];
 
-        // rebin and get amplitude for bucket
+        // rebin and get amplitude for bucket, only the bins some bar uses need their abs
         q31_t bin_power = 0;
         for(int j = startbin; j < endbin; j++) {
-            bin_power += fft_output[j];
-            //bin_power = MAX(bin_power, fft_output[j]);
+            bin_power += abs_bin(fft_output[j]);
         }
-
         bin_power /= (endbin - startbin) + 1;
-        bin_power = bin_power << 3;
-
-        float power = 20.0f * log10f((float) bin_power);
+        bin_power = bin_power << BAR_LEVEL_SHIFT(fft_size);
 
-        // clamp min
-        power -= BAR_MIN_DB;
-        power = MAX(0.0f, power);
-
-        // clamp max
-        power /= (BAR_MAX_DB - BAR_MIN_DB);
-        power = MIN(1.0f, power);
+        // exponential average over frames, 2^averaging frames long
+        bar_avg[i] += (bin_power - bar_avg[i]) >> averaging;
 
         old_value_array[i] = target_value_array[i];
-        target_value_array[i] = ceilf(64.0f * power);
+        target_value_array[i] = bar_height((uint32_t) bar_avg[i]);
     }
+    stats.frame_cycles = cycles_since(start) - (dsp_async_core1_cycles() - irq_start);
+    stats.size_cycles[fft_size] = stats.frame_cycles;
 
     interp_step = 0;
-    sample_buf_pos = 0;
+
+    // measured over whole seconds, so whatever else core 1 is doing shows up as dropped frames
+    stats.frames++;
+    rate_frames++;
+    uint32_t now = time_us_32();
+    if(now - rate_start_us >= 1000000) {
+        stats.measured_rate = (uint32_t) (((uint64_t) rate_frames * 100000000u) / (now - rate_start_us));
+        rate_start_us = now;
+        rate_frames = 0;
+    }
 
     ui_update_activity();
 }
 
-// smoothstep lerp
+void spectrum_set_overlap(uint8_t new_overlap) {
+    if(new_overlap < SPECTRUM_OVERLAP_COUNT) overlap = new_overlap;
+}
+
+uint8_t spectrum_get_overlap(void) {
+    return overlap;
+}
+
+// false if that size isn't built in (SPECTRUM_FFT_SIZES); core 1 changes over before its next frame
+bool spectrum_set_fft_size(uint8_t size) {
+    if(size >= SPECTRUM_FFT_SIZE_COUNT || !(SPECTRUM_FFT_SIZES >> size & 1u)) return false;
+    requested_fft_size = size;
+    return true;
+}
+
+uint8_t spectrum_get_fft_size(void) {
+    return requested_fft_size;
+}
+
+void spectrum_set_averaging(uint8_t shift) {
+    if(shift <= SPECTRUM_MAX_AVERAGING) averaging = shift;
+}
+
+uint8_t spectrum_get_averaging(void) {
+    return averaging;
+}
+
+void spectrum_get_stats(struct spectrum_stats *out) {
+    *out = stats;
+    out->nominal_rate = sample_rate * 100 / (SPECTRUM_FFT_LEN(fft_size) >> (1 + overlap));
+}
+
+// smoothstep lerp, old * s^2 (3t - 2s) / t^3 + new * the rest for step s of t
 static void redraw_bars(lv_timer_t * timer) {
     if(interp_step < interp_times) {
-        float fac = ((float) interp_step) / ((float) interp_times);
-        float lerp = fac * fac * (3.0f - 2.0f * fac);
+        int32_t t3 = interp_times * interp_times * interp_times;
+        int32_t lerp = interp_step * interp_step * (3 * interp_times - 2 * interp_step);
 
         for(int i = 0; i < NUM_BARS; i++) {
-            float oldval = ((float) old_value_array[i]);
-            float newval = ((float) target_value_array[i]);
-
-            float step = (oldval * lerp) + (newval * (1 - lerp));
-
-            value_array[i] = step;
+            value_array[i] = (old_value_array[i] * lerp + target_value_array[i] * (t3 - lerp)) / t3;
         }
 
         interp_step++;
@@ -179,12 +421,46 @@ static void redraw_bars(lv_timer_t * timer) {
     lv_chart_refresh(chart);
 }
 
-void spectrum_init(void) {
-    arm_rfft_init_q15(&fft_instance, FFT_SIZE, 0, 1);
-    // arm_status status
-    //printf("fft status %d\n", status);
+static void stats_update(lv_timer_t * timer) {
+    if(!stats_updates_left) return;
+    if(!--stats_updates_left) {
+        lv_obj_add_flag(stats_lbl, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
 
-    init_tables();
+    struct spectrum_stats now;
+    spectrum_get_stats(&now);
+    lv_label_set_text_fmt(stats_lbl, "%4u %s avg %u\ncyc %u\nfps %u.%02u/%u.%02u",
+            (unsigned) SPECTRUM_FFT_LEN(fft_size), overlap == SPECTRUM_OVERLAP_75 ? "75%" : "50%",
+            (unsigned) averaging, (unsigned) now.frame_cycles, (unsigned) (now.measured_rate / 100),
+            (unsigned) (now.measured_rate % 100), (unsigned) (now.nominal_rate / 100),
+            (unsigned) (now.nominal_rate % 100));
+}
+
+static void show_stats(void) {
+    stats_updates_left = STATS_SHOW_UPDATES + 1;
+    lv_obj_clear_flag(stats_lbl, LV_OBJ_FLAG_HIDDEN);
+    stats_update(stats_timer);
+}
+
+// the OK button on the Spectrum screen
+void spectrum_next_setting(void) {
+    if(++setting == sizeof(settings) / sizeof(settings[0])) {
+        setting = 0;
+        uint8_t size = requested_fft_size;
+        do {
+            size = (size + 1) % SPECTRUM_FFT_SIZE_COUNT;
+        } while(!spectrum_set_fft_size(size));
+    }
+    spectrum_set_overlap(settings[setting].overlap);
+    spectrum_set_averaging(settings[setting].averaging);
+    show_stats();
+}
+
+void spectrum_init(void) {
+    set_fft_size(requested_fft_size);
+    init_windows();
+    map_bins();
 
     Spectrum = lv_obj_create(NULL);
 
@@ -192,7 +468,7 @@ void spectrum_init(void) {
     lv_obj_set_size(chart, 127, 64);
     lv_obj_center(chart);
     lv_chart_set_type(chart, LV_CHART_TYPE_BAR);
-    lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, 64);
+    lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, 0, BAR_HEIGHT);
 
     lv_chart_set_div_line_count(chart, 0, 0);
 
@@ -208,7 +484,7 @@ void spectrum_init(void) {
     lv_chart_series_t * ser = lv_chart_add_series(chart, white, LV_CHART_AXIS_PRIMARY_Y);
 
     lv_chart_set_ext_y_array(chart, ser, value_array);
-    lv_chart_set_point_count(chart, 41);
+    lv_chart_set_point_count(chart, NUM_BARS);
 
     lv_coord_t * ser_array =  lv_chart_get_y_array(chart, ser);
 
@@ -221,18 +497,41 @@ void spectrum_init(void) {
 
     spectrum_timer = lv_timer_create(redraw_bars, 5, NULL);
     lv_timer_pause(spectrum_timer);
+
+    // black behind it, the bars go up under it
+    lv_color_t black = { .full = 0 };
+    stats_lbl = lv_label_create(Spectrum);
+    lv_obj_set_pos(stats_lbl, 0, 0);
+    lv_obj_set_style_bg_color(stats_lbl, black, LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(stats_lbl, LV_OPA_COVER, LV_PART_MAIN);
+    lv_label_set_text(stats_lbl, "");
+    lv_obj_add_flag(stats_lbl, LV_OBJ_FLAG_HIDDEN);
+
+    stats_timer = lv_timer_create(stats_update, STATS_UPDATE_MS, NULL);
+    lv_timer_pause(stats_timer);
 }
 
 void spectrum_start(void) {
-    sample_buf_pos = 0;
+    // from the next samples the IRQ captures, with an empty average
+    capture_rd = capture_wr;
+    restart_analysis();
+    clear_averages();
+    stats.frames = stats.dropped = stats.measured_rate = 0;
+    rate_start_us = time_us_32();
+    rate_frames = 0;
+
+    __dmb();
     spectrum_running = 1;
     lv_scr_load_anim(Spectrum, LV_SCR_LOAD_ANIM_NONE, 0, 0, false);
     lv_timer_resume(spectrum_timer);
+    lv_timer_resume(stats_timer);
+    show_stats();
 }
 
 void spectrum_stop(void) {
     spectrum_running = 0;
     //lv_scr_load_anim(MainUI, LV_SCR_LOAD_ANIM_NONE, 0, 0, false);
     lv_timer_pause(spectrum_timer);
+    lv_timer_pause(stats_timer);
 }
 
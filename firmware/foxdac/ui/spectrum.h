@@ -11,12 +11,72 @@
 #include "lvgl/lvgl.h"
 #include "stdint.h"
 
+enum spectrum_overlap {
+    SPECTRUM_OVERLAP_50 = 0,    // a frame every FFT_SIZE / 2 samples
+    SPECTRUM_OVERLAP_75,        // a frame every FFT_SIZE / 4 samples
+    SPECTRUM_OVERLAP_COUNT
+};
+
+#ifndef SPECTRUM_DEFAULT_OVERLAP
+#define SPECTRUM_DEFAULT_OVERLAP SPECTRUM_OVERLAP_50
+#endif
+
+enum spectrum_fft_size {
+    SPECTRUM_FFT_256 = 0,
+    SPECTRUM_FFT_512,
+    SPECTRUM_FFT_1024,
+    SPECTRUM_FFT_2048,
+    SPECTRUM_FFT_SIZE_COUNT
+};
+
+#define SPECTRUM_FFT_LEN(size) (256u << (size))
+
+// the sizes built in, a bit per spectrum_fft_size, and whether the transform is arm_rfft_q31;
+// CMakeLists.txt sets both and enables just the CMSIS twiddle tables they use
+#ifndef SPECTRUM_FFT_SIZES
+#define SPECTRUM_FFT_SIZES (1u << SPECTRUM_FFT_1024)
+#endif
+#ifndef SPECTRUM_FFT_Q31
+#define SPECTRUM_FFT_Q31 0
+#endif
+#ifndef SPECTRUM_DEFAULT_FFT_SIZE
+#define SPECTRUM_DEFAULT_FFT_SIZE SPECTRUM_FFT_1024
+#endif
+
+// bars are averaged over 2^n frames (exponentially), 0 is off
+#define SPECTRUM_MAX_AVERAGING 4
+#ifndef SPECTRUM_DEFAULT_AVERAGING
+#define SPECTRUM_DEFAULT_AVERAGING 0
+#endif
+
+struct spectrum_stats {
+    uint32_t frames;            // analysed since spectrum_start
+    uint32_t dropped;           // skipped because core 1 fell behind
+    uint32_t measured_rate;     // frames analysed a second, over the last second, x100
+    uint32_t nominal_rate;      // frames a second at the current rate and overlap, x100
+    uint32_t frame_cycles;      // core 1 cycles the last frame took, window to bar heights,
+                                // less the dsp_async IRQ's (SysTick, under 87ms at 192MHz)
+    uint32_t size_cycles[SPECTRUM_FFT_SIZE_COUNT];  // the same for the last frame at each size,
+                                                    // 0 until one has been analysed at it
+};
+
 void spectrum_loop(void);
-void spectrum_consume_samples(int16_t* samples, uint32_t sample_count, uint32_t rate);
+bool spectrum_wants_samples(void);
+void spectrum_consume_samples(int32_t* samples, uint32_t sample_count, uint32_t rate);
 void spectrum_init(void);
 void spectrum_start(void);
 void spectrum_stop(void);
 
+void spectrum_set_overlap(uint8_t overlap);
+uint8_t spectrum_get_overlap(void);
+bool spectrum_set_fft_size(uint8_t size);
+uint8_t spectrum_get_fft_size(void);
+void spectrum_set_averaging(uint8_t shift);
+uint8_t spectrum_get_averaging(void);
+void spectrum_get_stats(struct spectrum_stats *stats);
+// the next overlap and averaging, then the next FFT size built in, with the stats shown a while
+void spectrum_next_setting(void);
+
 extern lv_obj_t * Spectrum;
 
 #endif /* FOXDAC_UI_SPECTRUM_H_ */
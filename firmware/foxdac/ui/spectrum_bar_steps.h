@@ -0,0 +1,40 @@
+/*
+ * spectrum_bar_steps.h
+ *
+ *  Generated by spectrum_bars_test -g, see ui/spectrum_bars.h
+ */
+
+#ifndef FOXDAC_UI_SPECTRUM_BAR_STEPS_H_
+#define FOXDAC_UI_SPECTRUM_BAR_STEPS_H_
+
+#if SPECTRUM_FFT_Q31
+static const uint32_t bar_steps[BAR_HEIGHT] = {
+        25, 31, 38, 46, 56, 68, 83, 102,
+        124, 151, 185, 225, 275, 335, 408, 498,
+        607, 739, 901, 1099, 1339, 1632, 1990, 2425,
+        2956, 3603, 4391, 5352, 6523, 7951, 9690, 11811,
+        14395, 17545, 21385, 26064, 31768, 38719, 47191, 57517,
+        70103, 85443, 104139, 126926, 154699, 188550, 229807, 280093,
+        341381, 416080, 507124, 618091, 753338, 918179, 1119089, 1363962,
+        1662416, 2026177, 2469533, 3009902, 3668512, 4471234, 5449604, 6642054,
+};
+#ifndef SPECTRUM_BARS_TEST
+_Static_assert(BAR_MIN_DB == -20 && BAR_MAX_DB == 90 && BAR_HEIGHT == 64, "regenerate bar_steps: spectrum_bars_test -g");
+#endif
+#else
+static const uint32_t bar_steps[BAR_HEIGHT] = {
+        56, 62, 68, 75, 83, 92, 101, 112,
+        124, 136, 151, 166, 184, 203, 224, 248,
+        273, 302, 333, 368, 406, 449, 495, 547,
+        604, 667, 736, 813, 897, 991, 1094, 1207,
+        1333, 1472, 1625, 1794, 1980, 2186, 2414, 2665,
+        2942, 3248, 3586, 3959, 4371, 4826, 5327, 5882,
+        6493, 7169, 7914, 8737, 9646, 10649, 11757, 12980,
+        14330, 15820, 17465, 19282, 21287, 23501, 25945, 28643,
+};
+#ifndef SPECTRUM_BARS_TEST
+_Static_assert(BAR_MIN_DB == 35 && BAR_MAX_DB == 90 && BAR_HEIGHT == 64, "regenerate bar_steps: spectrum_bars_test -g");
+#endif
+#endif
+
+#endif /* FOXDAC_UI_SPECTRUM_BAR_STEPS_H_ */
@@ -0,0 +1,52 @@
+/*
+ * spectrum_bars.h
+ *
+ *  Spectrum bar heights from bar levels, in integer: the M0+ has no FPU and soft float
+ *  log10f per bar was most of the frame. Out of spectrum.c and free of lvgl so the host can
+ *  check it (dsp/host/spectrum_bars_test.c, which also generates spectrum_bar_steps.h).
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_UI_SPECTRUM_BARS_H_
+#define FOXDAC_UI_SPECTRUM_BARS_H_
+
+#include <stdint.h>
+
+#ifndef SPECTRUM_FFT_Q31
+#define SPECTRUM_FFT_Q31 0
+#endif
+
+#define BAR_HEIGHT 64
+
+// the q15 transform rounds away everything much under BAR_MIN_DB 35; the q31 one rounds below
+// the q15 samples it's fed, so bars go down another 55dB and dithered 16 bit silence still
+// shows none
+#define BAR_MIN_DB_Q15 35
+#define BAR_MIN_DB_Q31 (-20)
+#if SPECTRUM_FFT_Q31
+#define BAR_MIN_DB BAR_MIN_DB_Q31
+#else
+#define BAR_MIN_DB BAR_MIN_DB_Q15
+#endif
+#define BAR_MAX_DB 90
+
+// a bar is h high when 20 log10(level) - BAR_MIN_DB is over (h - 1) / BAR_HEIGHT of the range,
+// so when level > bar_steps[h - 1] = 10 ^ ((BAR_MIN_DB + (h - 1) * (BAR_MAX_DB - BAR_MIN_DB) / BAR_HEIGHT) / 20)
+// (rounded down, the level is an integer). The level is the mean |re| + |im| over the bar's
+// outputs in q15 lsbs x 8 at 1024 points, x 2 for each size up and / 2 for each size down
+// (spectrum.c); with q31 outputs it carries 8 more bits, and the steps are x 256.
+// spectrum_bars_test -g > ui/spectrum_bar_steps.h after changing any of the above.
+#include "spectrum_bar_steps.h"
+
+// height of a bar from its level, a binary search of bar_steps
+static inline uint32_t bar_height(uint32_t level) {
+    uint32_t h = 0;
+    for(uint32_t step = BAR_HEIGHT / 2; step; step >>= 1) {
+        if(level > bar_steps[h + step - 1]) h += step;
+    }
+    return h + (level > bar_steps[h]);
+}
+
+#endif /* FOXDAC_UI_SPECTRUM_BARS_H_ */
@@ -86,32 +86,59 @@ static void buttons_read(void) {
                 break;
             case 1:
 
-                // spectrum to eq
+                // spectrum to levels
 
                 spectrum_stop();
-                eq_curve_start();
+                level_meters_start();
 
                 cur_screen = 2;
                 break;
             case 2:
 
-                // eq to apple
+                // levels to eq
 
-                eq_curve_stop();
-                badapple_start();
+                level_meters_stop();
+                eq_curve_start();
 
                 cur_screen = 3;
                 break;
             case 3:
 
+                // eq to usb stats
+
+                eq_curve_stop();
+                usb_stats_start();
+
+                cur_screen = 4;
+                break;
+            case 4:
+
+                // usb stats to dsp stats
+
+                usb_stats_stop();
+                dsp_stats_start();
+
+                cur_screen = 5;
+                break;
+            case 5:
+
+                // dsp stats to apple
+
+                dsp_stats_stop();
+                badapple_start();
+
+                cur_screen = 6;
+                break;
+            case 6:
+
                 // apple to breakout
 
                 badapple_stop();
                 breakout_start();
 
-                cur_screen = 4;
+                cur_screen = 7;
                 break;
-            case 4:
+            case 7:
 
                 // breakout to main
 
@@ -139,6 +166,18 @@ static void buttons_read(void) {
             if(lv_disp_get_scr_act(NULL) == EqCurve) {
                 // use the ok button to switch through EQ bands
                 eq_curve_next_band();
+            } else if(lv_disp_get_scr_act(NULL) == LevelMeters) {
+                // clear the overs and peak hold
+                level_meters_reset();
+            } else if(lv_disp_get_scr_act(NULL) == UsbStats) {
+                // step through the overflow policies
+                usb_stats_next_policy();
+            } else if(lv_disp_get_scr_act(NULL) == DspStats) {
+                // step through the dither modes
+                dsp_stats_next_dither();
+            } else if(lv_disp_get_scr_act(NULL) == Spectrum) {
+                // step through the FFT sizes, overlaps and averaging
+                spectrum_next_setting();
             } else {
                 cur_input = (cur_input + 1) % INPUT_COUNT;
                 ui_select_input(cur_input);
@@ -162,6 +201,9 @@ static void buttons_read(void) {
         if(lv_disp_get_scr_act(NULL) == EqCurve) {
             // use the encoder button to toggle the EQ on/off
             biquad_eq_set_enabled(!biquad_eq_get_enabled());
+        } else if(lv_disp_get_scr_act(NULL) == DspStats) {
+            // the peaks start again from now
+            dsp_stats_clear_peaks();
         } else {
             uint32_t new_slider_value;
 
@@ -261,6 +303,9 @@ void ui_init(void) {
 
     persist_init();
     eq_curve_init();
+    level_meters_init();
+    usb_stats_init();
+    dsp_stats_init();
     spectrum_init();
     breakout_init();
 
@@ -0,0 +1,74 @@
+/*
+ * usb_stats.c
+ *
+ *  What the USB side has had to do to keep up since boot: packets, frames and blocks dropped,
+ *  packets stretched and S/PDIF blocks sent as silence, under the overflow policy in use, and
+ *  how long the last sample rate change held up the USB IRQ. OK steps through the policies,
+ *  the one picked is kept across reboots.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include "pico/stdlib.h"
+#include "stdint.h"
+
+#include "lvgl/lvgl.h"
+
+#include "../usb_spdif.h"
+
+#include "dac_lvgl_ui.h"
+#include "persistent_storage.h"
+
+#define STATS_UPDATE_MS 250
+
+lv_obj_t * UsbStats;
+
+static lv_obj_t * stats_lbl;
+static lv_timer_t * stats_timer;
+
+static const char *policy_names[AUDIO_OVERFLOW_POLICY_COUNT] = {
+        "drop new", "drop old", "stretch",
+};
+
+static void stats_update(lv_timer_t * timer) {
+    struct audio_overflow_counters c;
+    usb_audio_get_overflow_counters(&c);
+
+    lv_label_set_text_fmt(stats_lbl, "policy %9s\npkt drop %7u\nfrm drop %7u\nblk drop %7u\n"
+            "shorter %8u\nlonger %9u\nunderrun %7u\nrate chg %5uus", policy_names[usb_audio_get_overflow_policy()],
+            (unsigned) c.packets_dropped, (unsigned) c.frames_dropped, (unsigned) c.blocks_dropped,
+            (unsigned) c.stretch_shorter, (unsigned) c.stretch_longer, (unsigned) c.underruns,
+            (unsigned) usb_audio_get_reconfigure_us());
+}
+
+void usb_stats_init(void) {
+    UsbStats = lv_obj_create(NULL);
+
+    stats_lbl = lv_label_create(UsbStats);
+    lv_obj_set_pos(stats_lbl, 0, 0);
+    lv_label_set_text(stats_lbl, "");
+
+    stats_timer = lv_timer_create(stats_update, STATS_UPDATE_MS, NULL);
+    lv_timer_pause(stats_timer);
+
+    usb_audio_set_overflow_policy(persist_read_byte(&overflow_policy_file, AUDIO_OVERFLOW_STRETCH));
+}
+
+// the OK button on the USB screen
+void usb_stats_next_policy(void) {
+    audio_overflow_policy_t policy = (usb_audio_get_overflow_policy() + 1) % AUDIO_OVERFLOW_POLICY_COUNT;
+    usb_audio_set_overflow_policy(policy);
+    persist_write_byte(&overflow_policy_file, policy);
+    stats_update(stats_timer);
+}
+
+void usb_stats_start(void) {
+    lv_scr_load_anim(UsbStats, LV_SCR_LOAD_ANIM_NONE, 0, 0, false);
+    stats_update(stats_timer);
+    lv_timer_resume(stats_timer);
+}
+
+void usb_stats_stop(void) {
+    lv_timer_pause(stats_timer);
+}
@@ -0,0 +1,126 @@
+/*
+ * usb_feedback.c
+ *
+ *  Explicit feedback for the asynchronous USB audio OUT endpoint.
+ *
+ *  The S/PDIF PIO runs off the system clock, not the USB SOF, so the host has to be told how
+ *  many frames per ms we actually play. Every SOF we get the S/PDIF DMA frame counters and the
+ *  number of frames received over USB. From those the loop keeps:
+ *    - a low-passed estimate of the S/PDIF frame rate, silence included (feed-forward term)
+ *    - the buffer fill level (received - played), steered to USB_FEEDBACK_TARGET_FRAMES
+ *      by a PI controller
+ *  The sum is reported to the host as 10.14 frames per ms, scaled to the host's rate when an
+ *  ASRC sits between the USB stream and the S/PDIF output.
+ *
+ *  Only integer maths; runs in the SOF IRQ on core 0.
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#include <stdint.h>
+
+#include "usb_feedback.h"
+
+// SOFs without an OUT packet before we consider the stream stopped
+#define FB_IDLE_SOFS 16
+
+// rate low-pass: rate += (measured - rate) >> FB_RATE_SHIFT, ~128ms time constant
+#define FB_RATE_SHIFT 7
+
+// proportional and integral gains, Q16 frames/ms per frame of fill error
+#define FB_KP_Q16 512
+#define FB_KI_Q16 2
+
+// the correction never moves the reported rate more than nominal >> FB_LIMIT_SHIFT (~0.4%)
+#define FB_LIMIT_SHIFT 8
+
+static struct {
+    uint32_t nominal_q16;      // frames per ms, Q16
+    uint32_t feedback_q16;
+    uint32_t host_scale_q24;   // host frames per S/PDIF frame, Q24
+    int32_t rate_q16;          // low-passed S/PDIF consumption, frames per ms, Q16
+    int32_t integ;             // accumulated fill error, frames * ms
+    int32_t integ_limit;
+    int32_t fill;              // frames buffered between USB and the S/PDIF DMA
+    uint32_t last_clocked;
+    uint32_t last_received;
+    uint8_t idle_sofs;
+    uint8_t running;
+} fb;
+
+// sample_freq is the S/PDIF rate the loop runs at, host_freq the rate the host streams at
+void usb_feedback_reset(uint32_t sample_freq, uint32_t host_freq) {
+    // (freq << 16) / 1000 without overflowing 32 bits
+    fb.nominal_q16 = (sample_freq << 13u) / 125u;
+    fb.host_scale_q24 = (uint32_t) (((uint64_t) host_freq << 24u) / sample_freq);
+    fb.feedback_q16 = fb.nominal_q16;
+    fb.rate_q16 = (int32_t) fb.nominal_q16;
+    fb.integ = 0;
+    fb.integ_limit = (int32_t) (fb.nominal_q16 >> FB_LIMIT_SHIFT) / FB_KI_Q16;
+    fb.fill = 0;
+    fb.idle_sofs = FB_IDLE_SOFS;
+    fb.running = 0;
+}
+
+// frames_clocked: every frame the S/PDIF DMA sent, silence included
+// frames_played: only the frames that came from the host
+// frames_received: frames accepted from the OUT endpoint
+// all three are free-running and may wrap
+void usb_feedback_sof(uint32_t frames_clocked, uint32_t frames_played, uint32_t frames_received) {
+    int32_t clocked = (int32_t) (frames_clocked - fb.last_clocked);
+    int32_t received = (int32_t) (frames_received - fb.last_received);
+    fb.last_clocked = frames_clocked;
+    fb.last_received = frames_received;
+
+    // the DMA never stops, so the rate estimate tracks even while the host is idle
+    fb.rate_q16 += ((clocked << 16) - fb.rate_q16) >> FB_RATE_SHIFT;
+
+    fb.fill = (int32_t) (frames_received - frames_played);
+
+    if(received == 0) {
+        if(fb.idle_sofs < FB_IDLE_SOFS) {
+            fb.idle_sofs++;
+        } else {
+            // stream stopped, the buffers have drained into silence by now
+            fb.running = 0;
+            fb.integ = 0;
+            fb.feedback_q16 = fb.nominal_q16;
+        }
+    } else {
+        fb.idle_sofs = 0;
+    }
+
+    if(!fb.running) {
+        if(received == 0) return;
+        fb.running = 1;
+    }
+
+    int32_t err = USB_FEEDBACK_TARGET_FRAMES - fb.fill;
+
+    fb.integ += err;
+    if(fb.integ > fb.integ_limit) fb.integ = fb.integ_limit;
+    if(fb.integ < -fb.integ_limit) fb.integ = -fb.integ_limit;
+
+    int32_t limit = (int32_t) (fb.nominal_q16 >> FB_LIMIT_SHIFT);
+    int32_t correction = (fb.rate_q16 - (int32_t) fb.nominal_q16) + err * FB_KP_Q16 + fb.integ * FB_KI_Q16;
+
+    if(correction > limit) correction = limit;
+    if(correction < -limit) correction = -limit;
+
+    fb.feedback_q16 = fb.nominal_q16 + correction;
+}
+
+uint32_t usb_feedback_get_10_14(void) {
+    if(fb.host_scale_q24 == 1u << 24u) return fb.feedback_q16 >> 2u;
+    return (uint32_t) (((uint64_t) fb.feedback_q16 * fb.host_scale_q24) >> 26u);
+}
+
+// measured S/PDIF frames per ms of USB time, Q16
+uint32_t usb_feedback_get_rate_q16(void) {
+    return (uint32_t) fb.rate_q16;
+}
+
+int32_t usb_feedback_get_fill(void) {
+    return fb.fill;
+}
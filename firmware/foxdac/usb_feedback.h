@@ -0,0 +1,22 @@
+/*
+ * usb_feedback.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_USB_FEEDBACK_H_
+#define FOXDAC_USB_FEEDBACK_H_
+
+#include <stdint.h>
+
+// fill level the loop steers towards, in frames (two S/PDIF blocks)
+#define USB_FEEDBACK_TARGET_FRAMES (2 * 192)
+
+void usb_feedback_reset(uint32_t sample_freq, uint32_t host_freq);
+void usb_feedback_sof(uint32_t frames_clocked, uint32_t frames_played, uint32_t frames_received);
+uint32_t usb_feedback_get_10_14(void);
+uint32_t usb_feedback_get_rate_q16(void);
+int32_t usb_feedback_get_fill(void);
+
+#endif /* FOXDAC_USB_FEEDBACK_H_ */
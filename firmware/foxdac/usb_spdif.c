@@ -15,6 +15,8 @@
 #include "pico/unique_id.h"
 #include "hardware/sync.h"
 #include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/vreg.h"
 #include "hardware/structs/bus_ctrl.h"
 #include "hardware/watchdog.h"
 #include "lufa/AudioClassCommon.h"
@@ -27,9 +29,24 @@
 #include "drivers/ssd1306/ssd1306.h"
 
 #include "dsp/biquad_eq.h"
+#include "dsp/dsp_async.h"
+#include "dsp/dsp_pipeline.h"
+#include "dsp/asrc.h"
+#include "dsp/dither.h"
+#include "dsp/pcm_format.h"
+#include "dsp/level_meter.h"
+
+#include "clock_plan.h"
+#include "usb_feedback.h"
+#include "usb_spdif.h"
 
 CU_REGISTER_DEBUG_PINS(audio_timing)
 
+// convert every host rate to ASRC_OUT_FREQ instead of re-clocking the system PLL per rate
+#ifndef AUDIO_ASRC
+#define AUDIO_ASRC 0
+#endif
+
 // ---- select at most one ---
 //CU_SELECT_DEBUG_PINS(audio_timing)
 
@@ -50,7 +67,17 @@ static char *descriptor_strings[] =
 #undef AUDIO_SAMPLE_FREQ
 #define AUDIO_SAMPLE_FREQ(frq) (uint8_t)(frq), (uint8_t)((frq >> 8)), (uint8_t)((frq >> 16))
 
-#define AUDIO_MAX_PACKET_SIZE(freq) (uint8_t)(((freq + 999) / 1000) * 4)
+// one extra frame per packet, the feedback endpoint can ask the host for slightly more than nominal
+#define AUDIO_MAX_PACKET_SIZE(freq, subframe_size) ((((freq) + 999) / 1000 + 1) * 2 * (subframe_size))
+
+// descriptor frequency lists, from the clock plan
+#define AUDIO_DESCRIPTOR_FREQ(freq, code) AUDIO_SAMPLE_FREQ(freq),
+#define AUDIO_RATE(freq, code) freq,
+#define AUDIO_FREQS_24BIT (0 CLOCK_PLAN_RATES_BASE(CLOCK_PLAN_COUNT_RATE))
+#define AUDIO_FREQS_16BIT CLOCK_PLAN_RATE_COUNT
+
+#define AUDIO_ALT_16BIT 1u
+#define AUDIO_ALT_24BIT 2u
 
 #define FEATURE_MUTE_CONTROL 1u
 #define FEATURE_VOLUME_CONTROL 2u
@@ -72,7 +99,7 @@ struct audio_device_config {
         USB_Audio_StdDescriptor_Interface_AS_t streaming;
         struct __packed {
             USB_Audio_StdDescriptor_Format_t core;
-            USB_Audio_SampleFreq_t freqs[3];
+            USB_Audio_SampleFreq_t freqs[AUDIO_FREQS_16BIT];
         } format;
     } as_audio;
     struct __packed {
@@ -80,6 +107,19 @@ struct audio_device_config {
         USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
     } ep1;
     struct usb_endpoint_descriptor_long ep2;
+    struct usb_interface_descriptor as_op_interface_24;
+    struct __packed {
+        USB_Audio_StdDescriptor_Interface_AS_t streaming;
+        struct __packed {
+            USB_Audio_StdDescriptor_Format_t core;
+            USB_Audio_SampleFreq_t freqs[AUDIO_FREQS_24BIT];
+        } format;
+    } as_audio_24;
+    struct __packed {
+        struct usb_endpoint_descriptor_long core;
+        USB_Audio_StdDescriptor_StreamEndpoint_Spc_t audio;
+    } ep1_24;
+    struct usb_endpoint_descriptor_long ep2_24;
 };
 
 static const struct audio_device_config audio_device_config = {
@@ -162,7 +202,7 @@ static const struct audio_device_config audio_device_config = {
                 .bLength            = sizeof(audio_device_config.as_op_interface),
                 .bDescriptorType    = DTYPE_Interface,
                 .bInterfaceNumber   = 0x01,
-                .bAlternateSetting  = 0x01,
+                .bAlternateSetting  = AUDIO_ALT_16BIT,
                 .bNumEndpoints      = 0x02,
                 .bInterfaceClass    = AUDIO_CSCP_AudioClass,
                 .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
@@ -190,9 +230,7 @@ static const struct audio_device_config audio_device_config = {
                                 .bSampleFrequencyType = count_of(audio_device_config.as_audio.format.freqs),
                         },
                         .freqs = {
-                                AUDIO_SAMPLE_FREQ(44100),
-                                AUDIO_SAMPLE_FREQ(48000),
-                                AUDIO_SAMPLE_FREQ(96000)
+                                CLOCK_PLAN_RATES(AUDIO_DESCRIPTOR_FREQ)
                         },
                 },
         },
@@ -202,7 +240,7 @@ static const struct audio_device_config audio_device_config = {
                         .bDescriptorType  = DTYPE_Endpoint,
                         .bEndpointAddress = AUDIO_OUT_ENDPOINT,
                         .bmAttributes     = 5,
-                        .wMaxPacketSize   = 384,
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(CLOCK_PLAN_MAX_RATE, 2),
                         .bInterval        = 1,
                         .bRefresh         = 0,
                         .bSyncAddr        = AUDIO_IN_ENDPOINT,
@@ -226,6 +264,72 @@ static const struct audio_device_config audio_device_config = {
                 .bRefresh         = 2,
                 .bSyncAddr        = 0,
         },
+        .as_op_interface_24 = {
+                .bLength            = sizeof(audio_device_config.as_op_interface_24),
+                .bDescriptorType    = DTYPE_Interface,
+                .bInterfaceNumber   = 0x01,
+                .bAlternateSetting  = AUDIO_ALT_24BIT,
+                .bNumEndpoints      = 0x02,
+                .bInterfaceClass    = AUDIO_CSCP_AudioClass,
+                .bInterfaceSubClass = AUDIO_CSCP_AudioStreamingSubclass,
+                .bInterfaceProtocol = AUDIO_CSCP_ControlProtocol,
+                .iInterface         = 0x00,
+        },
+        .as_audio_24 = {
+                .streaming = {
+                        .bLength = sizeof(audio_device_config.as_audio_24.streaming),
+                        .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_General,
+                        .bTerminalLink = 1,
+                        .bDelay = 1,
+                        .wFormatTag = 1, // PCM
+                },
+                .format = {
+                        .core = {
+                                .bLength = sizeof(audio_device_config.as_audio_24.format),
+                                .bDescriptorType = AUDIO_DTYPE_CSInterface,
+                                .bDescriptorSubtype = AUDIO_DSUBTYPE_CSInterface_FormatType,
+                                .bFormatType = 1,
+                                .bNrChannels = 2,
+                                .bSubFrameSize = 3,
+                                .bBitResolution = 24,
+                                .bSampleFrequencyType = count_of(audio_device_config.as_audio_24.format.freqs),
+                        },
+                        .freqs = {
+                                CLOCK_PLAN_RATES_BASE(AUDIO_DESCRIPTOR_FREQ)
+                        },
+                },
+        },
+        .ep1_24 = {
+                .core = {
+                        .bLength          = sizeof(audio_device_config.ep1_24.core),
+                        .bDescriptorType  = DTYPE_Endpoint,
+                        .bEndpointAddress = AUDIO_OUT_ENDPOINT,
+                        .bmAttributes     = 5,
+                        .wMaxPacketSize   = AUDIO_MAX_PACKET_SIZE(96000, 3),
+                        .bInterval        = 1,
+                        .bRefresh         = 0,
+                        .bSyncAddr        = AUDIO_IN_ENDPOINT,
+                },
+                .audio = {
+                        .bLength = sizeof(audio_device_config.ep1_24.audio),
+                        .bDescriptorType = AUDIO_DTYPE_CSEndpoint,
+                        .bDescriptorSubtype = AUDIO_DSUBTYPE_CSEndpoint_General,
+                        .bmAttributes = 1,
+                        .bLockDelayUnits = 0,
+                        .wLockDelay = 0,
+                }
+        },
+        .ep2_24 = {
+                .bLength          = sizeof(audio_device_config.ep2_24),
+                .bDescriptorType  = 0x05,
+                .bEndpointAddress = AUDIO_IN_ENDPOINT,
+                .bmAttributes     = 0x11,
+                .wMaxPacketSize   = 3,
+                .bInterval        = 0x01,
+                .bRefresh         = 2,
+                .bSyncAddr        = 0,
+        },
 };
 
 static struct usb_interface ac_interface;
@@ -262,93 +366,342 @@ static struct {
     int16_t volume;
     int16_t vol_mul;
     bool mute;
+    uint8_t subframe_size; // bytes per sample on the wire, follows the alternate setting
 } audio_state = {
         .freq = 44100,
+        .subframe_size = 2,
 };
 
-static volatile uint8_t clock_176mhz = 0;
+#if AUDIO_ASRC
+// rate to restart the ASRC at, picked up by the deferred IRQ so it never resets mid-packet
+static volatile uint32_t asrc_pending_freq = 0;
+#endif
+
+// USB IRQ time taken by the last sample rate change, on the USB screen
+static volatile uint32_t reconfigure_us;
+
+uint32_t usb_audio_get_reconfigure_us(void) {
+    return reconfigure_us;
+}
+
+// PLL setting the system clock is on now
+static struct {
+    uint32_t vco_freq;
+    uint8_t post_div1;
+    uint8_t post_div2;
+} sys_pll;
 
 #define AUDIO_BUFFER_COUNT 8
 
+// only carries the format and rate to the S/PDIF side, packets are encoded straight into its blocks
 static struct audio_buffer_pool *producer_pool;
 
-volatile uint32_t pio_samples_dma = 0, pio_prev_samples_dma = 0;
-int sof_runs = 0, sof_avg = 0;
+// highest rate plus the extra frame allowed for in AUDIO_MAX_PACKET_SIZE
+#define AUDIO_MAX_FRAMES (CLOCK_PLAN_MAX_RATE / 1000 + 1)
+
+// decoded packet, only used when the EQ or the spectrum need to see the samples
+static int32_t packet_samples[2 * AUDIO_MAX_FRAMES];
+
+// core 0 cycles per frame its IRQs take (copy, decode, encode and the level meter's
+// LEVEL_METER_CYCLES_PER_FRAME, ~estimated), which the DSP blocks have to leave room for
+#define AUDIO_CORE0_CYCLES_PER_FRAME 150
+
+// set by a rate change, the deferred IRQ plans the DSP chain again between packets
+static volatile bool dsp_plan_pending = false;
+
+// Groups the DSP chain for packets at the current rate, against the system clock it now runs at,
+// with as many EQ bands as fit (all of them up to 96k). If it doesn't fit even with none, the
+// chain runs as planned and dsp_pipeline_get_load says so (the DSP screen shows it over).
+static void audio_plan_dsp(void) {
+    uint32_t rate = audio_state.freq;
+#if AUDIO_ASRC
+    // the blocks after the ASRC get its output frames
+    if (rate < ASRC_OUT_FREQ) rate = ASRC_OUT_FREQ;
+#endif
+    uint32_t frames = rate / 1000 + 1;
+    if (frames > AUDIO_MAX_FRAMES) frames = AUDIO_MAX_FRAMES;
+    uint32_t budget = clock_get_hz(clk_sys) / 1000;
+    for (int stages = BIQUAD_EQ_BANDS; stages >= 0; stages--) {
+        biquad_eq_set_max_stages(stages);
+        if (dsp_pipeline_plan(frames, budget, AUDIO_CORE0_CYCLES_PER_FRAME * frames)) break;
+    }
+}
+
+// one of the unconnected IRQs (26-31), raised by software to run the packet processing below USB priority
+#define AUDIO_DEFERRED_IRQ 31
+
+// raw packets handed from the USB IRQ to the deferred IRQ, single producer / single consumer
+#define AUDIO_PACKET_SLOTS 4
+
+static struct audio_packet_slot {
+    uint8_t data[MAX(AUDIO_MAX_PACKET_SIZE(CLOCK_PLAN_MAX_RATE, 2), AUDIO_MAX_PACKET_SIZE(96000, 3))] __aligned(4);
+    uint16_t len;
+    uint8_t subframe_size;
+} packet_slots[AUDIO_PACKET_SLOTS];
+
+// free-running, written only by the USB IRQ and the deferred IRQ respectively
+static volatile uint8_t packet_wr, packet_rd;
+
+// S/PDIF blocks that went out as silence, counted by the library
 int overruns = 0;
 
-#define SOF_AVG_BUF_SIZE 50
-#define SOF_AVG_BUF_SIZE_F 50.0f
-static volatile uint8_t sof_dma_buf[SOF_AVG_BUF_SIZE];
-static volatile uint8_t sof_dma_buf_pos = 0, sof_dma_buf_filled = 0;
+// frames the fill can be off the feedback target before AUDIO_OVERFLOW_STRETCH resamples packets
+#define AUDIO_STRETCH_MARGIN PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT
 
-volatile uint8_t usb_host_seen = 0;
+// a packet resampled a frame longer or shorter
+static int32_t stretch_samples[2 * (AUDIO_MAX_FRAMES + 1)];
 
-static volatile uint32_t rate = 48000;
+static volatile audio_overflow_policy_t overflow_policy = AUDIO_OVERFLOW_STRETCH;
+static struct audio_overflow_counters overflow_counters;
+
+void usb_audio_set_overflow_policy(audio_overflow_policy_t policy) {
+    if (policy < AUDIO_OVERFLOW_POLICY_COUNT) overflow_policy = policy;
+}
+
+audio_overflow_policy_t usb_audio_get_overflow_policy(void) {
+    return overflow_policy;
+}
+
+void usb_audio_get_overflow_counters(struct audio_overflow_counters *counters) {
+    // each counter is only written on core 0 and is read whole, good enough for display
+    *counters = overflow_counters;
+    counters->underruns = (uint32_t) overruns;
+}
+
+// frames accepted from the OUT endpoint, free-running
+static volatile uint32_t usb_frames_received = 0;
+
+volatile uint8_t usb_host_seen = 0;
 
 void __not_in_flash_func(usb_sof_irq)(void) {
-    return;
     // handle feedback sample rate calculations @ SOF to sync up with USB clock
-    uint32_t new_samples = pio_samples_dma - pio_prev_samples_dma;
-    pio_prev_samples_dma = pio_samples_dma;
+    uint32_t frames_played, frames_silence;
+    audio_spdif_get_frame_counters(&frames_played, &frames_silence);
 
-    // we're racing audio_spdif_dma_irq_handler on the other core here
-    sof_dma_buf[sof_dma_buf_pos] = new_samples;
+    usb_feedback_sof(frames_played + frames_silence, frames_played, usb_frames_received);
+}
 
-    sof_dma_buf_pos++;
-    if(sof_dma_buf_pos == SOF_AVG_BUF_SIZE) {
-        sof_dma_buf_pos = 0;
-        sof_dma_buf_filled = 1;
+// USB packet bytes straight to S/PDIF subframes in one pass, a word at a time (see dsp/pcm_format.h);
+// 16 bit goes through the 24 bit encoder too, so a block half written at one depth can be finished
+// at the other
+static void __not_in_flash_func(encode_usb_frames)(spdif_subframe_t *dst, const uint8_t *in, uint frames, uint subframe_size) {
+    if (subframe_size == 3) {
+        // a packet split over two blocks can leave the run half way into a word
+        for (; frames && ((uintptr_t) in & 3u); frames--, in += 6) {
+            spdif_update_subframe_24(dst++, pcm_s24_sample(in) >> 8u);
+            spdif_update_subframe_24(dst++, pcm_s24_sample(in + 3) >> 8u);
+        }
+        const uint32_t *w = (const uint32_t *) in;
+        for (; frames >= 2; frames -= 2, w += 3) {
+            int32_t s[4];
+            pcm_s24_unpack2(w, s);
+            for (uint i = 0; i < 4; i++) {
+                spdif_update_subframe_24(dst++, s[i] >> 8u);
+            }
+        }
+        if (frames) {
+            spdif_update_subframe_24(dst++, pcm_s24_sample((const uint8_t *) w) >> 8u);
+            spdif_update_subframe_24(dst++, pcm_s24_sample((const uint8_t *) w + 3) >> 8u);
+        }
+    } else {
+        const uint32_t *w = (const uint32_t *) in;
+        for (uint i = 0; i < frames; i++) {
+            spdif_update_subframe_24(dst++, pcm_s16_left(w[i]) >> 8u);
+            spdif_update_subframe_24(dst++, pcm_s16_right(w[i]) >> 8u);
+        }
     }
+}
 
-    if(sof_dma_buf_filled) {
-        uint32_t sof_avg = 0;
-        for(uint8_t i = 0; i < SOF_AVG_BUF_SIZE; i++) {
-            sof_avg += sof_dma_buf[i];
-        }
+// widen to MSB aligned 32 bit, the pipeline carries 24 bits all the way to S/PDIF
+static void __not_in_flash_func(decode_usb_frames)(int32_t *dst, const uint8_t *in, uint frames, uint subframe_size) {
+    if (subframe_size == 3) {
+        pcm_decode_s24(dst, in, frames);
+    } else {
+        pcm_decode_s16(dst, in, frames);
+    }
+}
 
-        rate = (uint32_t) ((((float)sof_avg) / SOF_AVG_BUF_SIZE_F) * 192.0f * 1000.0f);
+static void __not_in_flash_func(encode_samples)(spdif_subframe_t *dst, const int32_t *in, uint frames) {
+    for (uint i = 0; i < frames * 2; i++) {
+        spdif_update_subframe_24(dst++, in[i] >> 8);
     }
+}
+
+// in_frames of interleaved stereo linearly interpolated onto out_frames, the first and last
+// frames kept so packets still join up. Only every so often while the fill is off target, so
+// it isn't worth a faster loop.
+static void __not_in_flash_func(stretch_packet)(int32_t *out, const int32_t *in, uint in_frames, uint out_frames) {
+    for (uint i = 0; i < out_frames; i++) {
+        // where frame i falls in the input, Q16 (193 x 192 << 16 still fits)
+        uint32_t pos = ((i * (in_frames - 1)) << 16) / (out_frames - 1);
+        uint j = pos >> 16;
+        int32_t frac = (int32_t) (pos & 0xffffu);
+        const int32_t *a = in + 2 * j;
+        const int32_t *b = j + 1 < in_frames ? a + 2 : a;
+        for (uint ch = 0; ch < 2; ch++) {
+            out[2 * i + ch] = a[ch] + (int32_t) ((((int64_t) b[ch] - a[ch]) * frac) >> 16);
+        }
+    }
+}
 
-    //        // 0.230 for 44.1k, 0.250 for 48k, 0.500 for 96k
-    //        // multiply by 192 (spdif frame size) to get rate
+// into the S/PDIF blocks from decoded samples, or with samples NULL straight from the USB bytes
+static void __not_in_flash_func(audio_encode_packet)(const int32_t *samples, const uint8_t *data, uint frame_count, uint subframe_size) {
+    // well ahead of the DMA or well behind it: a frame fewer or more now, rather than a whole
+    // packet dropped or a block of silence later
+    if (overflow_policy == AUDIO_OVERFLOW_STRETCH && frame_count > 2) {
+        int32_t fill = usb_feedback_get_fill();
+        uint out_frames = frame_count;
+        if (fill > USB_FEEDBACK_TARGET_FRAMES + AUDIO_STRETCH_MARGIN) {
+            out_frames--;
+            overflow_counters.stretch_shorter++;
+        } else if (fill < USB_FEEDBACK_TARGET_FRAMES - AUDIO_STRETCH_MARGIN) {
+            out_frames++;
+            overflow_counters.stretch_longer++;
+        }
+        if (out_frames != frame_count) {
+            // the pipeline is idle when a packet goes straight through, its buffer is free
+            if (!samples) {
+                decode_usb_frames(packet_samples, data, frame_count, subframe_size);
+                samples = packet_samples;
+            }
+            stretch_packet(stretch_samples, samples, frame_count, out_frames);
+            samples = stretch_samples;
+            frame_count = out_frames;
+        }
+    }
 
+    // a packet can straddle two S/PDIF blocks (e.g. 44/45 frame packets into 192 frame blocks at 44.1k)
+    // never wait for a block here, the USB IRQ would back up behind us
+    uint pos = 0;
+    while (pos < frame_count) {
+        uint room;
+        spdif_subframe_t *dst = audio_spdif_get_write_window(&room, false);
+        if (!dst) {
+            if (overflow_policy == AUDIO_OVERFLOW_DROP_OLDEST && audio_spdif_drop_oldest_block()) {
+                // those frames were counted as received but will never be played
+                usb_frames_received -= PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT;
+                overflow_counters.blocks_dropped++;
+                continue;
+            }
+            overflow_counters.frames_dropped += frame_count - pos;
+            break;
+        }
+        uint n = MIN(room, frame_count - pos);
+        if (samples) {
+            encode_samples(dst, samples + pos * 2, n);
+        } else {
+            encode_usb_frames(dst, data + pos * 2 * subframe_size, n, subframe_size);
+        }
+        audio_spdif_commit_frames(n);
+        pos += n;
+    }
 
-    //gpio_put(18, !gpio_get(18));
+    usb_frames_received += pos;
+
+    // the meter in a pass of its own, fused into the encoder loops its sums would be spilled
+    // to the stack (see level_meter.h)
+    _Static_assert(AUDIO_MAX_FRAMES + 1 <= LEVEL_METER_MAX_FRAMES, "level meter sums would overflow");
+    struct level_meter_packet meter;
+    level_meter_packet_init(&meter);
+    if (samples) {
+        level_meter_add_samples(&meter, samples, pos);
+    } else if (subframe_size == 3) {
+        level_meter_add_s24(&meter, data, pos);
+    } else {
+        level_meter_add_s16(&meter, data, pos);
+    }
+    level_meter_publish(&meter, pos);
 }
 
-static void __not_in_flash_func(_as_audio_packet)(struct usb_endpoint *ep) {
-    assert(ep->current_transfer);
-    struct usb_buffer *usb_buffer = usb_current_out_packet_buffer(ep);
-    DEBUG_PINS_SET(audio_timing, 1);
-    // todo deal with blocking correctly
+// Decode one packet and hand it to the DSP pipeline, or encode it straight away if nothing needs
+// the samples; runs in the deferred IRQ, not in the USB IRQ. The pipeline's output is picked up
+// by a later run of the deferred IRQ, so the packet comes out up to a packet later.
+static void __not_in_flash_func(audio_process_packet)(const uint8_t *data, uint data_len, uint subframe_size) {
+    uint frame_count = data_len / (2 * subframe_size);
+    if (frame_count > AUDIO_MAX_FRAMES) frame_count = AUDIO_MAX_FRAMES;
+
+    // EQ, spectrum and ASRC work on whole packets, so they need the samples decoded first. An
+    // EQ with every band flat (and its limiter at unity) leaves them as they are.
+    bool eq_on = biquad_eq_get_enabled();
+#if AUDIO_ASRC
+    if (asrc_pending_freq) {
+        asrc_reset(asrc_pending_freq);
+        asrc_pending_freq = 0;
+    }
+    // from here on frames are output frames, which is also what the feedback loop counts
+    asrc_set_out_rate(usb_feedback_get_rate_q16());
+#endif
+    // the pipeline is idle here, so its rounds can change
+    if (dsp_plan_pending) {
+        dsp_plan_pending = false;
+        audio_plan_dsp();
+    }
+    bool decode = dsp_pipeline_begin_packet() || spectrum_wants_samples();
+    if (!decode) {
+        audio_encode_packet(NULL, data, frame_count, subframe_size);
+
+        if (eq_on && frame_count >= 2) {
+            // so a band coming back in starts from where the signal is
+            int32_t last[4];
+            decode_usb_frames(last, data + (frame_count - 2) * 2 * subframe_size, 2, subframe_size);
+            biquad_eq_track_bypassed(last, 2);
+        }
+        return;
+    }
 
-    gpio_put(25, 1);
-    struct audio_buffer* audio_buffer = take_audio_buffer(producer_pool, true);
+    decode_usb_frames(packet_samples, data, frame_count, subframe_size);
 
+    spectrum_consume_samples(packet_samples, frame_count, audio_state.freq);
 
-    DEBUG_PINS_CLR(audio_timing, 1);
-    //assert(!(usb_buffer->data_len & 3u));
-    audio_buffer->sample_count = usb_buffer->data_len / 4;
-    //assert(audio_buffer->sample_count);
-    //assert(audio_buffer->max_sample_count >= audio_buffer->sample_count);
-    uint16_t vol_mul = audio_state.vol_mul;
-    int16_t *out = (int16_t *) audio_buffer->buffer->bytes;
-    int16_t *in = (int16_t *) usb_buffer->data;
+    dsp_pipeline_start(packet_samples, frame_count);
+}
 
-    memcpy(out, in, usb_buffer->data_len);
+// Pended by the USB IRQ for each packet and by dsp_async when the cores finish a round. Only
+// one packet is in the pipeline at a time (block state is shared by both cores' parts), the
+// ones behind it wait in packet_slots.
+static void __not_in_flash_func(audio_deferred_irq)(void) {
+    DEBUG_PINS_SET(audio_timing, 4);
+    while (true) {
+        if (!dsp_pipeline_idle()) {
+            const struct dsp_packet *done = dsp_pipeline_poll();
+            if (!done) break;
+            audio_encode_packet(done->samples, NULL, done->frames, 0);
+            continue;
+        }
+        if (packet_rd == packet_wr) break;
 
-    //for (int i = 0; i < audio_buffer->sample_count * 2; i++) {
-    //    out[i] = (int16_t) ((in[i] * vol_mul) >> 15u);
-    //}
+        struct audio_packet_slot *slot = &packet_slots[packet_rd & (AUDIO_PACKET_SLOTS - 1)];
+        audio_process_packet(slot->data, slot->len, slot->subframe_size);
+        __dmb();
+        packet_rd++;
+    }
+    DEBUG_PINS_CLR(audio_timing, 4);
+}
 
-    spectrum_consume_samples(out, audio_buffer->sample_count, audio_state.freq);
+// only takes a copy of the packet so the endpoint buffer can go straight back to the hardware,
+// everything else happens in audio_deferred_irq
+static void __not_in_flash_func(_as_audio_packet)(struct usb_endpoint *ep) {
+    assert(ep->current_transfer);
+    struct usb_buffer *usb_buffer = usb_current_out_packet_buffer(ep);
+    DEBUG_PINS_SET(audio_timing, 1);
+    gpio_put(25, 1);
 
-    biquad_eq_process_inplace(out, audio_buffer->sample_count);
+    if ((uint8_t) (packet_wr - packet_rd) < AUDIO_PACKET_SLOTS) {
+        struct audio_packet_slot *slot = &packet_slots[packet_wr & (AUDIO_PACKET_SLOTS - 1)];
+        uint len = MIN(usb_buffer->data_len, sizeof(slot->data));
+        memcpy(slot->data, usb_buffer->data, len);
+        slot->len = len;
+        slot->subframe_size = audio_state.subframe_size;
+        __dmb();
+        packet_wr++;
+    } else {
+        // the deferred stage is behind, drop the packet
+        overflow_counters.packets_dropped++;
+    }
+    irq_set_pending(AUDIO_DEFERRED_IRQ);
 
-    give_audio_buffer(producer_pool, audio_buffer);
     gpio_put(25, 0);
-
-    //gpio_put(25, 0);
+    DEBUG_PINS_CLR(audio_timing, 1);
 
     // keep on truckin'
     usb_grow_transfer(ep->current_transfer, 1);
@@ -363,12 +716,7 @@ static void __not_in_flash_func(_as_sync_packet)(struct usb_endpoint *ep) {
     assert(buffer->data_max >= 3);
     buffer->data_len = 3;
 
-    int32_t diff = audio_state.freq - rate;
-
-    // todo lie thru our teeth for now
-    uint feedback = (audio_state.freq << 14u) / 1000u;
-    //uint feedback = (rate << 14u) / 1000u;
-    //uint feedback = ((audio_state.freq + diff) << 14u) / 1000u;
+    uint feedback = usb_feedback_get_10_14();
 
     buffer->data[0] = feedback;
     buffer->data[1] = feedback >> 8u;
@@ -377,15 +725,6 @@ static void __not_in_flash_func(_as_sync_packet)(struct usb_endpoint *ep) {
     // keep on truckin'
     usb_grow_transfer(ep->current_transfer, 1);
     usb_packet_done(ep);
-
-    //    sof_runs++;
-    //    if(sof_runs == 50) {
-    //        sof_runs = 0;
-    //        //sof_avg = 0;
-    //
-    //        //printf("%d\n", audio_state.freq + diff);
-    //        printf("%d %d\n", rate, overruns);
-    //    }
 }
 
 static const struct usb_transfer_type as_transfer_type = {
@@ -500,36 +839,46 @@ static struct audio_control_cmd {
     uint8_t len;
 } audio_control_cmd_t;
 
+// after raising the core voltage, before the system clock goes over 133MHz
+#define AUDIO_VREG_SETTLE_US 10000
+
+// only re-clocks when the plan for the new rate is on a different PLL setting
+static void audio_set_sys_clock(const struct clock_plan *plan) {
+    if (plan->vco_freq == sys_pll.vco_freq && plan->post_div1 == sys_pll.post_div1 && plan->post_div2 == sys_pll.post_div2) {
+        return;
+    }
+    set_sys_clock_pll(plan->vco_freq, plan->post_div1, plan->post_div2);
+    sys_pll.vco_freq = plan->vco_freq;
+    sys_pll.post_div1 = plan->post_div1;
+    sys_pll.post_div2 = plan->post_div2;
+}
+
 static void _audio_reconfigure() {
-    switch (audio_state.freq) {
-    case 44100:
-    case 48000:
-    case 96000:
-        break;
-    default:
+    const struct clock_plan *plan = clock_plan_get(audio_state.freq);
+    if (!plan) {
         audio_state.freq = 44100;
+        plan = clock_plan_get(audio_state.freq);
     }
 
-    // if we're going to 48/96 from 44.1, clock up the system PLL
-    if((audio_state.freq == 48000 || audio_state.freq == 96000) && clock_176mhz) {
-        // 192.0MHz
-        set_sys_clock_pll(1536000000, 4, 2);
-        clock_176mhz = 0;
-    } else if(audio_state.freq == 44100 && !clock_176mhz) {
-        // 176.57142857142858 MHz, closest PLL frequency near 176.4 MHz (multiple of 44.1)
-        // results in a PIO frequency of 44098.7582418 when rounding up in update_pio_frequency
-        set_sys_clock_pll(1236000000, 7, 1);
-        clock_176mhz = 1;
-    }
+#if AUDIO_ASRC
+    // S/PDIF and the system clock stay at ASRC_OUT_FREQ, only the converter follows the host
+    asrc_pending_freq = audio_state.freq;
+
+    usb_feedback_reset(ASRC_OUT_FREQ, audio_state.freq);
+#else
+    audio_set_sys_clock(plan);
+    audio_spdif_set_frequency(plan->sample_freq, plan->pio_div_q8, plan->cs_freq_code);
 
     // todo hack overwriting const
     ((struct audio_format *) producer_pool->format)->sample_freq = audio_state.freq;
 
+    usb_feedback_reset(audio_state.freq, audio_state.freq);
+#endif
+
     biquad_eq_set_fs(audio_state.freq);
 
-    rate = audio_state.freq;
-    sof_dma_buf_filled = 0;
-    sof_dma_buf_pos = 0;
+    // new packet size, and without the ASRC a new system clock
+    dsp_plan_pending = true;
 }
 
 static void audio_set_volume(int16_t volume) {
@@ -573,7 +922,9 @@ static void audio_cmd_packet(struct usb_endpoint *ep) {
 
                 if (audio_state.freq != new_freq) {
                     audio_state.freq = new_freq;
+                    uint32_t t0 = time_us_32();
                     _audio_reconfigure();
+                    reconfigure_us = time_us_32() - t0;
                 }
             }
         }
@@ -591,7 +942,12 @@ static const struct usb_transfer_type _audio_cmd_transfer_type = {
 static bool as_set_alternate(struct usb_interface *interface, uint alt) {
     assert(interface == &as_op_interface);
     usb_warn("SET ALTERNATE %d\n", alt);
-    return alt < 2;
+    if (alt == AUDIO_ALT_24BIT) {
+        audio_state.subframe_size = 3;
+    } else if (alt == AUDIO_ALT_16BIT) {
+        audio_state.subframe_size = 2;
+    }
+    return alt <= AUDIO_ALT_24BIT;
 }
 
 static bool do_set_current(struct usb_setup_packet *setup) {
@@ -671,7 +1027,13 @@ void usb_sound_card_init() {
     static struct usb_endpoint *const op_endpoints[] = {
             &ep_op_out, &ep_op_sync
     };
-    usb_interface_init(&as_op_interface, &audio_device_config.as_op_interface, op_endpoints, count_of(op_endpoints), true);
+    // endpoint buffers are sized from the descriptor, so init from the alternate with the biggest packets
+    // (16 bit goes up to 192k, 24 bit only to 96k)
+    const struct usb_interface_descriptor *largest_alt = &audio_device_config.as_op_interface;
+    if (audio_device_config.ep1_24.core.wMaxPacketSize > audio_device_config.ep1.core.wMaxPacketSize) {
+        largest_alt = &audio_device_config.as_op_interface_24;
+    }
+    usb_interface_init(&as_op_interface, largest_alt, op_endpoints, count_of(op_endpoints), true);
     as_op_interface.set_alternate_handler = as_set_alternate;
     ep_op_out.setup_request_handler = _as_setup_request_handler;
     as_transfer.type = &as_transfer_type;
@@ -695,7 +1057,7 @@ void usb_sound_card_init() {
 
 // initialize for 48k we allow changing later
 struct audio_format audio_format_48k = {
-        .format = AUDIO_BUFFER_FORMAT_PCM_S16,
+        .format = AUDIO_BUFFER_FORMAT_PCM_S32,
         .sample_freq = 48000,
         .channel_count = 2,
 };
@@ -708,16 +1070,17 @@ struct audio_spdif_config config = {
 
 struct audio_buffer_format producer_format = {
         .format = &audio_format_48k,
-        .sample_stride = 4
+        .sample_stride = 8
 };
 
 // Core split:
-// core 0 handles high-priority tasks: USB and SPDIF IRQs
-// core 1 handles low-priority tasks: LVGL, OLED, WM8805 polling and TPA6130 volume
+// core 0 handles high-priority tasks: USB and SPDIF IRQs, and its half of the DSP in thread mode
+// core 1 handles low-priority tasks: LVGL, OLED, WM8805 polling and TPA6130 volume, and the
+// other half of the DSP in its SIO FIFO IRQ
 
 static void core1_worker() {
     watchdog_update();
-    biquad_eq_init_core1();
+    dsp_async_init_core1();
 
     // Init the oled twice, in case the first time glitched
     busy_wait_ms(50);
@@ -756,10 +1119,26 @@ void core0_init() {
     // Grant high bus priority to the DMA
     bus_ctrl_hw->priority = BUSCTRL_BUS_PRIORITY_DMA_W_BITS | BUSCTRL_BUS_PRIORITY_DMA_R_BITS;
 
-    // Init EQ
-    biquad_eq_init();
+    // Init EQ, with coefficients ready for every rate the host can pick
+    static const uint32_t host_rates[] = { CLOCK_PLAN_RATES(AUDIO_RATE) };
+    biquad_eq_init(host_rates, count_of(host_rates));
+
+#if AUDIO_ASRC
+    // Init ASRC, with its filters for the same rates; the S/PDIF rate never changes after this
+    asrc_init(host_rates, count_of(host_rates));
+    audio_format_48k.sample_freq = ASRC_OUT_FREQ;
+#endif
+
+    // DSP chain, in order, planned again on every rate change
+    dsp_pipeline_add(&biquad_eq_block);
+    dsp_pipeline_add(&biquad_eq_limiter_block);
+#if AUDIO_ASRC
+    dsp_pipeline_add(&asrc_block);
+#endif
+    dsp_pipeline_add(&dither_block);
+    audio_plan_dsp();
 
-    producer_pool = audio_new_producer_pool(&producer_format, AUDIO_BUFFER_COUNT, 192);
+    producer_pool = audio_new_producer_pool(&producer_format, 1, 192);
 
     const struct audio_format *output_format;
     output_format = audio_spdif_setup(&audio_format_48k, &config);
@@ -770,6 +1149,17 @@ void core0_init() {
     bool __unused ok = audio_spdif_connect_extra(producer_pool, false, AUDIO_BUFFER_COUNT / 2, NULL);
     assert(ok);
 
+#if AUDIO_ASRC
+    const struct clock_plan *plan = clock_plan_get(ASRC_OUT_FREQ);
+    audio_spdif_set_frequency(plan->sample_freq, plan->pio_div_q8, plan->cs_freq_code);
+#endif
+
+    // Packet processing runs below the USB IRQ (core 0), and again when the cores finish a round
+    dsp_async_init_core0(AUDIO_DEFERRED_IRQ);
+    irq_set_exclusive_handler(AUDIO_DEFERRED_IRQ, audio_deferred_irq);
+    irq_set_priority(AUDIO_DEFERRED_IRQ, PICO_LOWEST_IRQ_PRIORITY);
+    irq_set_enabled(AUDIO_DEFERRED_IRQ, true);
+
     //irq_set_priority(USBCTRL_IRQ, 0x40);
     usb_sound_card_init();
 
@@ -785,15 +1175,14 @@ void core0_init() {
 }
 
 int main(void) {
-    // 17.2032 MHz is a common multiple for all three sample rates we do:
-    // https://www.electronicdesign.com/technologies/embedded-revolution/article/21801786/achieving-bitperfect-usb-audio
-    // 17.2032*10=172.032MHz is not exactly doable by the PLL but 172.0MHz is
-    // if we just ignore 44.1 instead, 192000 is a nice integer multiple for 48 and 96
-    // ideally the core would run at 96MHz to avoid running overclocked, but this seems to be fine
-    //set_sys_clock_khz(192000, true);
-
-    // 192.0MHz
-    set_sys_clock_pll(1536000000, 4, 2);
+    // System clock from the clock plan for the rate we start at (fixed from here on with the ASRC),
+    // so the UART comes up at the clock it will run at
+    clock_plan_init();
+    // every plan is up to CLOCK_PLAN_SYS_MAX_HZ, the core needs more than the default 1.10V for
+    // that; give the regulator time to settle before the clock goes up
+    vreg_set_voltage(VREG_VOLTAGE_1_15);
+    busy_wait_us(AUDIO_VREG_SETTLE_US);
+    audio_set_sys_clock(clock_plan_get(AUDIO_ASRC ? ASRC_OUT_FREQ : audio_state.freq));
 
     // Debug UART
     stdout_uart_init();
@@ -808,6 +1197,8 @@ int main(void) {
     multicore_launch_core1(core1_worker);
 
     while (1) {
+        // core 0's half of the DSP, woken by the deferred IRQ posting a round or core 1 finishing one
+        dsp_async_run_core0();
         __wfe();
     }
 }
@@ -1 +1,38 @@
+/*
+ * usb_spdif.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: alex
+ */
+
+#ifndef FOXDAC_USB_SPDIF_H_
+#define FOXDAC_USB_SPDIF_H_
+
+#include <stdint.h>
+
+// what to do when USB audio arrives faster than the S/PDIF side takes it
+typedef enum {
+    AUDIO_OVERFLOW_DROP_NEWEST,    // throw away what doesn't fit of the incoming packet
+    AUDIO_OVERFLOW_DROP_OLDEST,    // throw away the oldest queued S/PDIF block to make room
+    AUDIO_OVERFLOW_STRETCH,        // resample packets a frame shorter while the fill is high and a
+                                   // frame longer while it is low, then as drop newest
+    AUDIO_OVERFLOW_POLICY_COUNT
+} audio_overflow_policy_t;
+
+struct audio_overflow_counters {
+    uint32_t packets_dropped;      // USB packets lost because processing was behind
+    uint32_t frames_dropped;       // frames dropped from incoming packets
+    uint32_t blocks_dropped;       // queued S/PDIF blocks thrown away (drop oldest)
+    uint32_t stretch_shorter;      // packets resampled a frame shorter while the fill was high
+    uint32_t stretch_longer;       // packets resampled a frame longer while the fill was low
+    uint32_t underruns;            // S/PDIF blocks sent as silence
+};
+
 void usb_spdif_audio_init(void);
+void usb_audio_set_overflow_policy(audio_overflow_policy_t policy);
+audio_overflow_policy_t usb_audio_get_overflow_policy(void);
+void usb_audio_get_overflow_counters(struct audio_overflow_counters *counters);
+// microseconds the last SET_CUR sample rate request spent in the USB IRQ
+uint32_t usb_audio_get_reconfigure_us(void);
+
+#endif /* FOXDAC_USB_SPDIF_H_ */
@@ -77,6 +77,12 @@ inline static void list_append_with_tail(audio_buffer_t **phead, audio_buffer_t
 audio_buffer_t *get_free_audio_buffer(audio_buffer_pool_t *context, bool block) {
     audio_buffer_t *ab;
 
+    if (context->lock_free) {
+        while (!(ab = audio_buffer_ring_pop(&context->free_ring)) && block) {
+            __wfe();
+        }
+        return ab;
+    }
     do {
         uint32_t save = spin_lock_blocking(context->free_list_spin_lock);
         ab = list_remove_head(&context->free_list);
@@ -89,6 +95,11 @@ audio_buffer_t *get_free_audio_buffer(audio_buffer_pool_t *context, bool block)
 
 void queue_free_audio_buffer(audio_buffer_pool_t *context, audio_buffer_t *ab) {
     assert(!ab->next);
+    if (context->lock_free) {
+        audio_buffer_ring_push(&context->free_ring, ab);
+        __sev();
+        return;
+    }
     uint32_t save = spin_lock_blocking(context->free_list_spin_lock);
     list_prepend(&context->free_list, ab);
     spin_unlock(context->free_list_spin_lock, save);
@@ -98,6 +109,12 @@ void queue_free_audio_buffer(audio_buffer_pool_t *context, audio_buffer_t *ab) {
 audio_buffer_t *get_full_audio_buffer(audio_buffer_pool_t *context, bool block) {
     audio_buffer_t *ab;
 
+    if (context->lock_free) {
+        while (!(ab = audio_buffer_ring_pop(&context->prepared_ring)) && block) {
+            __wfe();
+        }
+        return ab;
+    }
     do {
         uint32_t save = spin_lock_blocking(context->prepared_list_spin_lock);
         ab = list_remove_head_with_tail(&context->prepared_list, &context->prepared_list_tail);
@@ -110,6 +127,11 @@ audio_buffer_t *get_full_audio_buffer(audio_buffer_pool_t *context, bool block)
 
 void queue_full_audio_buffer(audio_buffer_pool_t *context, audio_buffer_t *ab) {
     assert(!ab->next);
+    if (context->lock_free) {
+        audio_buffer_ring_push(&context->prepared_ring, ab);
+        __sev();
+        return;
+    }
     uint32_t save = spin_lock_blocking(context->prepared_list_spin_lock);
     list_append_with_tail(&context->prepared_list, &context->prepared_list_tail, ab);
     spin_unlock(context->prepared_list_spin_lock, save);
@@ -199,6 +221,31 @@ audio_new_consumer_pool(audio_buffer_format_t *format, int buffer_count, int buf
     return ac;
 }
 
+static void audio_make_pool_lock_free(audio_buffer_pool_t *ac, int buffer_count) {
+    audio_buffer_ring_init(&ac->free_ring, buffer_count);
+    audio_buffer_ring_init(&ac->prepared_ring, buffer_count);
+    // move the initial free list into the ring
+    audio_buffer_t *ab;
+    while ((ab = list_remove_head(&ac->free_list))) {
+        audio_buffer_ring_push(&ac->free_ring, ab);
+    }
+    ac->lock_free = true;
+}
+
+audio_buffer_pool_t *
+audio_new_lock_free_producer_pool(audio_buffer_format_t *format, int buffer_count, int buffer_sample_count) {
+    audio_buffer_pool_t *ac = audio_new_producer_pool(format, buffer_count, buffer_sample_count);
+    audio_make_pool_lock_free(ac, buffer_count);
+    return ac;
+}
+
+audio_buffer_pool_t *
+audio_new_lock_free_consumer_pool(audio_buffer_format_t *format, int buffer_count, int buffer_sample_count) {
+    audio_buffer_pool_t *ac = audio_new_consumer_pool(format, buffer_count, buffer_sample_count);
+    audio_make_pool_lock_free(ac, buffer_count);
+    return ac;
+}
+
 void audio_complete_connection(audio_connection_t *connection, audio_buffer_pool_t *producer_pool,
                                audio_buffer_pool_t *consumer_pool) {
     assert(producer_pool->type == audio_buffer_pool::ac_producer);
@@ -10,6 +10,7 @@
 #include "pico.h"
 #include "pico/util/buffer.h"
 #include "hardware/sync.h"
+#include "pico/audio_buffer_ring.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -42,6 +43,7 @@ extern "C" {
 #define AUDIO_BUFFER_FORMAT_PCM_S8 2           ///< signed 8bit PCM
 #define AUDIO_BUFFER_FORMAT_PCM_U16 3          ///< unsigned 16bit PCM
 #define AUDIO_BUFFER_FORMAT_PCM_U8 4           ///< unsigned 16bit PCM
+#define AUDIO_BUFFER_FORMAT_PCM_S32 5          ///< signed 32bit PCM, MSB aligned (e.g. 24bit samples << 8)
 
 /** \brief Audio format definition
  */
@@ -85,6 +87,10 @@ typedef struct audio_buffer_pool {
     spin_lock_t *prepared_list_spin_lock;
     audio_buffer_t *prepared_list;
     audio_buffer_t *prepared_list_tail;
+    // used instead of the lists above for pools made by the audio_new_lock_free_* functions
+    bool lock_free;
+    audio_buffer_ring_t free_ring;
+    audio_buffer_ring_t prepared_ring;
 } audio_buffer_pool_t;
 
 typedef struct audio_connection audio_connection_t;
@@ -124,6 +130,35 @@ audio_buffer_pool_t *audio_new_producer_pool(audio_buffer_format_t *format, int
 audio_buffer_pool_t *audio_new_consumer_pool(audio_buffer_format_t *format, int buffer_count,
                                                          int buffer_sample_count);
 
+/*! \brief Allocate and initialise an audio producer pool that does not use spin locks
+ *  \ingroup pico_audio
+ *
+ * The free and prepared queues are lock-free rings. Each of them must only ever have one
+ * context (IRQ handler, core or thread) adding buffers and one taking them; that is the
+ * case for a plain producer -> connection -> consumer chain where each side runs in a
+ * single context.
+ *
+ * \param format Format of the audio buffer
+ * \param buffer_count Number of buffers in the pool
+ * \param buffer_sample_count Number of samples in each buffer
+ * \return Pointer to an audio_buffer_pool
+ */
+audio_buffer_pool_t *audio_new_lock_free_producer_pool(audio_buffer_format_t *format, int buffer_count,
+                                                       int buffer_sample_count);
+
+/*! \brief Allocate and initialise an audio consumer pool that does not use spin locks
+ *  \ingroup pico_audio
+ *
+ * See audio_new_lock_free_producer_pool() for the restrictions.
+ *
+ * \param format Format of the audio buffer
+ * \param buffer_count Number of buffers in the pool
+ * \param buffer_sample_count Number of samples in each buffer
+ * \return Pointer to an audio_buffer_pool
+ */
+audio_buffer_pool_t *audio_new_lock_free_consumer_pool(audio_buffer_format_t *format, int buffer_count,
+                                                       int buffer_sample_count);
+
 /*! \brief Allocate and initialise an audio wrapping buffer
  *  \ingroup pico_audio
  *
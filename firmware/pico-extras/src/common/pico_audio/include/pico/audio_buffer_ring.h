@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2020 Raspberry Pi (Trading) Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef _PICO_AUDIO_BUFFER_RING_H
+#define _PICO_AUDIO_BUFFER_RING_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "hardware/sync.h"
+
+/** \file audio_buffer_ring.h
+ *
+ * Single producer / single consumer queue of buffers for the lock-free audio pools. The tail
+ * is only published after the slot is written, and the head only advanced after it is read,
+ * so no lock is needed. Header only so the host tests can run it.
+ */
+
+struct audio_buffer;
+
+/** \brief Single producer / single consumer queue of buffers, no locks
+ */
+typedef struct audio_buffer_ring {
+    struct audio_buffer **slots;
+    uint32_t mask;                  ///< slot count - 1, slot count is a power of 2
+    volatile uint32_t head;         ///< free-running, only written by the consumer
+    volatile uint32_t tail;         ///< free-running, only written by the producer
+} audio_buffer_ring_t;
+
+static inline void audio_buffer_ring_init(audio_buffer_ring_t *ring, int buffer_count) {
+    uint32_t size = 1;
+    while (size < (uint32_t) buffer_count) size <<= 1u;
+    ring->slots = (struct audio_buffer **) calloc(size, sizeof(struct audio_buffer *));
+    ring->mask = size - 1;
+    ring->head = ring->tail = 0;
+}
+
+static inline void audio_buffer_ring_push(audio_buffer_ring_t *ring, struct audio_buffer *ab) {
+    uint32_t tail = ring->tail;
+    assert(tail - ring->head <= ring->mask);
+    ring->slots[tail & ring->mask] = ab;
+    __mem_fence_release();
+    ring->tail = tail + 1;
+}
+
+static inline struct audio_buffer *audio_buffer_ring_pop(audio_buffer_ring_t *ring) {
+    uint32_t head = ring->head;
+    if (head == ring->tail) return NULL;
+    __mem_fence_acquire();
+    struct audio_buffer *ab = ring->slots[head & ring->mask];
+    __mem_fence_release();
+    ring->head = head + 1;
+    return ab;
+}
+
+#endif //_PICO_AUDIO_BUFFER_RING_H
@@ -32,6 +32,9 @@ typedef struct : public FmtDetails<uint16_t> {
 typedef struct : public FmtDetails<int16_t> {
 } FmtS16;
 
+typedef struct : public FmtDetails<int32_t> {
+} FmtS32;
+
 // Multi channel is just N samples back to back
 template<typename Fmt, uint ChannelCount>
 struct MultiChannelFmt {
@@ -82,6 +85,22 @@ struct sample_converter<FmtS16, FmtU8> {
     }
 };
 
+template<>
+struct sample_converter<FmtS16, FmtS32> {
+    static int16_t convert_sample(const int32_t &sample) {
+        return sample >> 16u;
+    }
+};
+
+// converters to S32
+
+template<>
+struct sample_converter<FmtS32, FmtS16> {
+    static int32_t convert_sample(const int16_t &sample) {
+        return ((int32_t) sample) << 16u;
+    }
+};
+
 // converters to U16
 
 template<>
@@ -28,8 +28,15 @@ CU_REGISTER_DEBUG_PINS(audio_timing)
 struct {
     audio_buffer_t *playing_buffer;
     uint32_t freq;
+    uint32_t control_word;
     uint8_t pio_sm;
     uint8_t dma_channel;
+    // frame counters for rate measurement, see audio_spdif_get_frame_counters
+    volatile uint32_t counter_seq;
+    volatile uint32_t frames_played;
+    volatile uint32_t frames_silence;
+    volatile uint32_t transfer_frames;
+    volatile bool transfer_is_silence;
 } shared_state;
 
 static audio_format_t pio_spdif_consumer_format;
@@ -51,8 +58,9 @@ const audio_spdif_config_t audio_spdif_default_config = {
     .dma_channel = 0,
 };
 
+// IEC 60958-3 channel status bits 24-27, sample frequency
 #define SR_44100 0
-#define SR_48000 1
+#define SR_48000 2
 
 #define PREAMBLE_X 0b11001001
 #define PREAMBLE_Y 0b01101001
@@ -94,7 +102,7 @@ static void init_spdif_buffer(audio_buffer_t *buffer) {
     assert(buffer->max_sample_count == PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT);
     spdif_subframe_t *p = (spdif_subframe_t *)buffer->buffer->bytes;
     for(uint i=0;i<PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT;i++) {
-        uint c_bit = i < 32 ? (SPDIF_CONTROL_WORD >> i) & 1u: 0;
+        uint c_bit = i < 32 ? (shared_state.control_word >> i) & 1u: 0;
 //        p->l = (i ? PREAMBLE_X : PREAMBLE_Z) | 0b10101010101010100000000 | 0x55000000;
 //        p->h = 0x55000000u | (c_bit << 25u) | 0x0055555555;
 //        p++;
@@ -112,7 +120,22 @@ static void init_spdif_buffer(audio_buffer_t *buffer) {
     }
 }
 
+// rewrite the channel status bits carried by the first 32 frames of a block, the parity is
+// fixed up when the samples are written
+static void update_control_bits(spdif_subframe_t *p) {
+    for(uint i=0;i<32;i++) {
+        uint32_t c = ((shared_state.control_word >> i) & 1u) << 29u;
+        p->h = (p->h & ~(1u << 29u)) | c;
+        p++;
+        p->h = (p->h & ~(1u << 29u)) | c;
+        p++;
+    }
+}
+
 uint32_t spdif_lookup[256];
+#if PICO_AUDIO_SPDIF_24BIT
+uint32_t spdif_lookup12[4096];
+#endif
 
 const audio_format_t *audio_spdif_setup(const audio_format_t *intended_audio_format,
                                                const audio_spdif_config_t *config) {
@@ -127,6 +150,14 @@ const audio_format_t *audio_spdif_setup(const audio_format_t *intended_audio_for
         }
         spdif_lookup[i] = v | (p << 16u);
     }
+#if PICO_AUDIO_SPDIF_24BIT
+    // each 12 bit half is two byte lookups glued together
+    for(uint i=0;i<4096;i++) {
+        uint32_t lo = spdif_lookup[i & 0xffu];
+        uint32_t hi = spdif_lookup[i >> 8u];
+        spdif_lookup12[i] = (lo & 0xffffu) | ((hi & 0xffu) << 16u) | (((lo ^ hi) >> 16u) << 31u);
+    }
+#endif
     uint func = GPIO_FUNC_PIOx;
     gpio_set_function(config->pin, func);
 
@@ -137,6 +168,7 @@ const audio_format_t *audio_spdif_setup(const audio_format_t *intended_audio_for
 
     spdif_program_init(audio_pio, sm, offset, config->pin);
 
+    shared_state.control_word = SPDIF_CONTROL_WORD;
     silence_buffer.buffer = pico_buffer_alloc(PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT * 2 * sizeof(spdif_subframe_t));
     init_spdif_buffer(&silence_buffer);
     spdif_subframe_t *sf = (spdif_subframe_t *)silence_buffer.buffer->bytes;
@@ -174,6 +206,13 @@ const audio_format_t *audio_spdif_setup(const audio_format_t *intended_audio_for
 
 static audio_buffer_pool_t *audio_spdif_consumer;
 
+static void set_pio_divider(uint32_t sample_freq, uint32_t divider) {
+    printf("System clock at %u, S/PDIF clock divider 0x%x/256\n", (uint) clock_get_hz(clk_sys), (uint)divider);
+    assert(divider >= 0x100 && divider < 0x1000000);
+    pio_sm_set_clkdiv_int_frac(audio_pio, shared_state.pio_sm, divider >> 8u, divider & 0xffu);
+    shared_state.freq = sample_freq;
+}
+
 static void update_pio_frequency(uint32_t sample_freq) {
     printf("setting pio freq %d\n", (int) sample_freq);
     uint32_t system_clock_frequency = clock_get_hz(clk_sys);
@@ -184,10 +223,25 @@ static void update_pio_frequency(uint32_t sample_freq) {
     // ceil the divider instead (gets us a closer hit to 44100 at 176.57142857142858 MHz: 44098.7583844)
     uint32_t divider = system_clock_frequency / sample_freq + (system_clock_frequency % sample_freq != 0);
 
-    printf("System clock at %u, S/PDIF clock divider 0x%x/256\n", (uint) system_clock_frequency, (uint)divider);
-    assert(divider < 0x1000000);
-    pio_sm_set_clkdiv_int_frac(audio_pio, shared_state.pio_sm, divider >> 8u, divider & 0xffu);
-    shared_state.freq = sample_freq;
+    set_pio_divider(sample_freq, divider);
+}
+
+void audio_spdif_set_frequency(uint32_t sample_freq, uint32_t divider, uint8_t cs_freq_code) {
+    if (divider) {
+        set_pio_divider(sample_freq, divider);
+    } else {
+        update_pio_frequency(sample_freq);
+    }
+
+    shared_state.control_word = (shared_state.control_word & ~(0xfu << 24u)) | ((cs_freq_code & 0xfu) << 24u);
+
+    // the silence block is never refilled, so patch it (and its parity) here
+    spdif_subframe_t *sf = (spdif_subframe_t *)silence_buffer.buffer->bytes;
+    update_control_bits(sf);
+    for(uint i=0;i<32;i++) {
+        spdif_update_subframe(sf++, 0);
+        spdif_update_subframe(sf++, 0);
+    }
 }
 
 static audio_buffer_t *wrap_consumer_take(audio_connection_t *connection, bool block) {
@@ -195,7 +249,11 @@ static audio_buffer_t *wrap_consumer_take(audio_connection_t *connection, bool b
     if (connection->producer_pool->format->sample_freq != shared_state.freq) {
         update_pio_frequency(connection->producer_pool->format->sample_freq);
     }
-    return consumer_pool_take_buffer_default(connection, block);
+    audio_buffer_t *buffer = consumer_pool_take_buffer_default(connection, block);
+    if (buffer) {
+        update_control_bits((spdif_subframe_t *)buffer->buffer->bytes);
+    }
+    return buffer;
 }
 
 static void wrap_producer_give(audio_connection_t *connection, audio_buffer_t *buffer) {
@@ -205,6 +263,10 @@ static void wrap_producer_give(audio_connection_t *connection, audio_buffer_t *b
         mono_to_spdif_producer_give(connection, buffer);
 #else
         stereo_to_spdif_producer_give(connection, buffer);
+#endif
+#if PICO_AUDIO_SPDIF_24BIT && !PICO_AUDIO_SPDIF_MONO_INPUT
+    } else if (buffer->format->format->format == AUDIO_BUFFER_FORMAT_PCM_S32) {
+        stereo_s32_to_spdif_producer_give(connection, buffer);
 #endif
     } else {
         panic_unsupported();
@@ -220,6 +282,44 @@ static struct producer_pool_blocking_give_connection m2s_audio_spdif_connection
         }
 };
 
+spdif_subframe_t *audio_spdif_get_write_window(uint *frame_count, bool block) {
+    struct producer_pool_blocking_give_connection *pbc = &m2s_audio_spdif_connection;
+    if (!pbc->current_consumer_buffer) {
+        pbc->current_consumer_buffer = get_free_audio_buffer(audio_spdif_consumer, block);
+        if (!pbc->current_consumer_buffer) {
+            *frame_count = 0;
+            return NULL;
+        }
+        pbc->current_consumer_buffer_pos = 0;
+        update_control_bits((spdif_subframe_t *)pbc->current_consumer_buffer->buffer->bytes);
+    }
+    *frame_count = pbc->current_consumer_buffer->max_sample_count - pbc->current_consumer_buffer_pos;
+    return ((spdif_subframe_t *) pbc->current_consumer_buffer->buffer->bytes) + pbc->current_consumer_buffer_pos * 2;
+}
+
+void audio_spdif_commit_frames(uint frame_count) {
+    struct producer_pool_blocking_give_connection *pbc = &m2s_audio_spdif_connection;
+    assert(pbc->current_consumer_buffer);
+    pbc->current_consumer_buffer_pos += frame_count;
+    assert(pbc->current_consumer_buffer_pos <= pbc->current_consumer_buffer->max_sample_count);
+    if (pbc->current_consumer_buffer_pos == pbc->current_consumer_buffer->max_sample_count) {
+        pbc->current_consumer_buffer->sample_count = pbc->current_consumer_buffer->max_sample_count;
+        queue_full_audio_buffer(audio_spdif_consumer, pbc->current_consumer_buffer);
+        pbc->current_consumer_buffer = NULL;
+    }
+}
+
+bool audio_spdif_drop_oldest_block(void) {
+    // the DMA IRQ both takes from the prepared queue and returns to the free queue, keep it out
+    uint32_t save = save_and_disable_interrupts();
+    audio_buffer_t *ab = get_full_audio_buffer(audio_spdif_consumer, false);
+    if (ab) {
+        queue_free_audio_buffer(audio_spdif_consumer, ab);
+    }
+    restore_interrupts(save);
+    return ab != NULL;
+}
+
 bool audio_spdif_connect_thru(audio_buffer_pool_t *producer, audio_connection_t *connection) {
     return audio_spdif_connect_extra(producer, true, 2, connection);
 }
@@ -232,15 +332,30 @@ bool audio_spdif_connect_extra(audio_buffer_pool_t *producer, bool buffer_on_giv
                                audio_connection_t *connection) {
     printf("Connecting PIO S/PDIF audio\n");
 
-    assert(producer->format->format == AUDIO_BUFFER_FORMAT_PCM_S16);
+    assert(producer->format->format == AUDIO_BUFFER_FORMAT_PCM_S16 ||
+           (PICO_AUDIO_SPDIF_24BIT && producer->format->format == AUDIO_BUFFER_FORMAT_PCM_S32));
     pio_spdif_consumer_format.format = AUDIO_BUFFER_FORMAT_PIO_SPDIF;
     pio_spdif_consumer_format.sample_freq = producer->format->sample_freq;
     pio_spdif_consumer_format.channel_count = 2;
     pio_spdif_consumer_buffer_format.sample_stride = 2 * sizeof(spdif_subframe_t);
 
+#if PICO_AUDIO_SPDIF_LOCK_FREE_POOL
+    audio_spdif_consumer = audio_new_lock_free_consumer_pool(&pio_spdif_consumer_buffer_format, buffer_count, PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT);
+#else
     audio_spdif_consumer = audio_new_consumer_pool(&pio_spdif_consumer_buffer_format, buffer_count, PICO_AUDIO_SPDIF_BLOCK_SAMPLE_COUNT);
-    for (audio_buffer_t *buffer = audio_spdif_consumer->free_list; buffer; buffer = buffer->next) {
+#endif
+    // take every buffer out to pre-fill it, then put them all back (works whichever way the pool queues them)
+    audio_buffer_t *prefilled = NULL;
+    for (audio_buffer_t *buffer; (buffer = get_free_audio_buffer(audio_spdif_consumer, false)); ) {
         init_spdif_buffer(buffer);
+        buffer->next = prefilled;
+        prefilled = buffer;
+    }
+    while (prefilled) {
+        audio_buffer_t *buffer = prefilled;
+        prefilled = buffer->next;
+        buffer->next = NULL;
+        queue_free_audio_buffer(audio_spdif_consumer, buffer);
     }
 
     update_pio_frequency(producer->format->sample_freq);
@@ -319,6 +434,7 @@ static void __time_critical_func(audio_start_dma_transfer)() {
     audio_buffer_t *ab = take_audio_buffer(audio_spdif_consumer, false);
 
     shared_state.playing_buffer = ab;
+    bool silence = !ab;
     if (!ab) {
 
         extern volatile uint8_t ui_suspended;
@@ -344,7 +460,47 @@ static void __time_critical_func(audio_start_dma_transfer)() {
     //assert(ab->format->format->channel_count == 2);
     //assert(ab->format->sample_stride == 2 * sizeof(spdif_subframe_t));
 
+    // retire the previous transfer into the counters and describe the new one; odd sequence
+    // numbers tell readers (on either core) that the counters are being updated
+    shared_state.counter_seq++;
+    __mem_fence_release();
+
     dma_channel_transfer_from_buffer_now(shared_state.dma_channel, ab->buffer->bytes, ab->sample_count * 4);
+
+    if (shared_state.transfer_is_silence) {
+        shared_state.frames_silence += shared_state.transfer_frames;
+    } else {
+        shared_state.frames_played += shared_state.transfer_frames;
+    }
+    shared_state.transfer_frames = ab->sample_count;
+    shared_state.transfer_is_silence = silence;
+    __mem_fence_release();
+    shared_state.counter_seq++;
+}
+
+void __time_critical_func(audio_spdif_get_frame_counters)(uint32_t *frames_played, uint32_t *frames_silence) {
+    uint32_t seq, played, silent, transfer_frames, remaining;
+    bool is_silence;
+    do {
+        seq = shared_state.counter_seq;
+        __mem_fence_acquire();
+        played = shared_state.frames_played;
+        silent = shared_state.frames_silence;
+        transfer_frames = shared_state.transfer_frames;
+        is_silence = shared_state.transfer_is_silence;
+        // 4 words (two subframes) per frame
+        remaining = dma_channel_hw_addr(shared_state.dma_channel)->transfer_count / 4;
+        __mem_fence_acquire();
+    } while ((seq & 1u) || seq != shared_state.counter_seq);
+
+    // add what has already gone out of the transfer in flight
+    if (is_silence) {
+        silent += transfer_frames - remaining;
+    } else {
+        played += transfer_frames - remaining;
+    }
+    *frames_played = played;
+    *frames_silence = silent;
 }
 
 // irq handler for DMA
@@ -359,9 +515,6 @@ void __isr __time_critical_func(audio_spdif_dma_irq_handler)() {
         DEBUG_PINS_SET(audio_timing, 4);
         // free the buffer we just finished
         if (shared_state.playing_buffer) {
-            extern volatile uint32_t pio_samples_dma;
-            pio_samples_dma++;
-
             give_audio_buffer(audio_spdif_consumer, shared_state.playing_buffer);
 #ifndef NDEBUG
             shared_state.playing_buffer = NULL;
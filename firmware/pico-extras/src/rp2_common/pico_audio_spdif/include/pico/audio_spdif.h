@@ -8,6 +8,7 @@
 #define _PICO_AUDIO_SPDIF_H
 
 #include "pico/audio.h"
+#include "pico/audio_spdif/sample_encoding.h"
 
 /** \file audio_spdif.h
  *  \defgroup pico_audio_spdif pico_audio_spdif
@@ -76,6 +77,16 @@ extern "C" {
 #endif
 #endif
 
+// PICO_CONFIG: PICO_AUDIO_SPDIF_24BIT, Accept AUDIO_BUFFER_FORMAT_PCM_S32 producers and send 24 bit samples (costs a 16K lookup table in RAM), type=bool, default=1, group=pico_audio_spdif
+#ifndef PICO_AUDIO_SPDIF_24BIT
+#define PICO_AUDIO_SPDIF_24BIT 1
+#endif
+
+// PICO_CONFIG: PICO_AUDIO_SPDIF_LOCK_FREE_POOL, Use a lock-free consumer pool; only valid when the blocks are filled from a single context and the DMA IRQ is the only consumer, type=bool, default=0, group=pico_audio_spdif
+#ifndef PICO_AUDIO_SPDIF_LOCK_FREE_POOL
+#define PICO_AUDIO_SPDIF_LOCK_FREE_POOL 0
+#endif
+
 #ifndef PICO_AUDIO_SPDIF_MONO_INPUT
 #define PICO_AUDIO_SPDIF_MONO_INPUT 0
 #endif
@@ -156,6 +167,62 @@ bool audio_spdif_connect_extra(audio_buffer_pool_t *producer, bool buffer_on_giv
  */
 void audio_spdif_set_enabled(bool enabled);
 
+/** \brief Change the S/PDIF sample rate
+ * \ingroup audio_spdif
+ *
+ * Sets the PIO clock divider and the sample frequency code sent in the channel status. Blocks
+ * pick up the new channel status as they are refilled.
+ *
+ * \param sample_freq The nominal sample rate
+ * \param divider PIO clock divider in 16.8 fixed point (system clocks per frame), or 0 to work it out from clk_sys
+ * \param cs_freq_code IEC 60958-3 channel status sample frequency code (bits 24-27)
+ */
+void audio_spdif_set_frequency(uint32_t sample_freq, uint32_t divider, uint8_t cs_freq_code);
+
+/** \brief Get the number of frames sent out by the S/PDIF DMA so far
+ * \ingroup audio_spdif
+ *
+ * The counters are free-running (they wrap) and include the progress of the block currently
+ * being transferred, so they are good for measuring the actual output sample rate. They are
+ * read consistently against the DMA IRQ handler and may be called from either core.
+ *
+ * \param frames_played Frames that came from buffers supplied by the producer
+ * \param frames_silence Frames of silence sent because no buffer was ready (underruns)
+ */
+void audio_spdif_get_frame_counters(uint32_t *frames_played, uint32_t *frames_silence);
+
+/** \brief Get the unfilled part of the S/PDIF block currently being filled, to encode into directly
+ * \ingroup audio_spdif
+ *
+ * This skips the producer pool and the copy in the connection: the caller encodes subframes
+ * (e.g. with spdif_update_subframe_24()) straight into the block and then calls
+ * audio_spdif_commit_frames(). Only for the default connection, and not to be mixed with giving
+ * producer buffers.
+ *
+ * \param frame_count Returns the number of stereo frames that can be written
+ * \param block Whether to wait for a free block
+ * \return The first subframe to write (two per frame), or NULL if there is no free block and block is false
+ */
+spdif_subframe_t *audio_spdif_get_write_window(uint *frame_count, bool block);
+
+/** \brief Mark frames written into the window from audio_spdif_get_write_window() as ready
+ * \ingroup audio_spdif
+ *
+ * A block is queued for the DMA once all of its frames are committed.
+ *
+ * \param frame_count The number of stereo frames written, at most what the window had room for
+ */
+void audio_spdif_commit_frames(uint frame_count);
+
+/** \brief Throw away the oldest block queued for the DMA, to make room when the producer is running ahead
+ * \ingroup audio_spdif
+ *
+ * Must be called on the core that handles the S/PDIF DMA IRQ.
+ *
+ * \return true if a block was freed, false if none was queued
+ */
+bool audio_spdif_drop_oldest_block(void);
+
 #ifdef __cplusplus
 }
 #endif
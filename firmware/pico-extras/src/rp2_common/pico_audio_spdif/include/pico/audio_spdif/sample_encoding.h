@@ -15,6 +15,7 @@ extern "C" {
 
 void mono_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_t *buffer);
 void stereo_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_t *buffer);
+void stereo_s32_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_t *buffer);
 
 typedef struct {
     uint32_t l;
@@ -37,6 +38,22 @@ static inline void spdif_update_subframe(spdif_subframe_t *subframe, int16_t sam
     subframe->h = h | ((ph&0x7f) << 24u) | (p << 31u);
 }
 
+// 12 sample bits encoded to 24 bits, parity of the 12 bits in bit 31
+extern uint32_t spdif_lookup12[4096];
+
+// sample is 24 bit, in the low bits of the int; the whole audio word (subframe bits 4-27) is
+// replaced, so the aux bits are used for sample data
+static inline void spdif_update_subframe_24(spdif_subframe_t *subframe, int32_t sample) {
+    uint32_t sl = spdif_lookup12[sample & 0xfffu];
+    uint32_t sh = spdif_lookup12[(sample >> 12u) & 0xfffu];
+    subframe->l = (subframe->l & 0xffu) | (sl << 8u);
+    uint32_t ph = subframe->h >> 24u;
+    // the two parity bits land on each other in bit 31, sh has nothing in 24-30
+    uint32_t h = sh ^ (sl & 0x80000000u);
+    h ^= ((__mul_instruction(ph&0x2a,0x2a) >> 6u) & 1u) << 31u;
+    subframe->h = h | ((ph&0x7f) << 24u);
+}
+
 #ifdef __cplusplus
 }
 #endif
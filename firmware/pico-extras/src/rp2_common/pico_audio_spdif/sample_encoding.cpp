@@ -26,6 +26,18 @@ struct converting_copy<Stereo<FmtSPDIF>, Stereo<FromFmt>> {
     }
 };
 
+#if PICO_AUDIO_SPDIF_24BIT
+// keep all 24 bits rather than going through FmtS16
+template<>
+struct converting_copy<Stereo<FmtSPDIF>, Stereo<FmtS32>> {
+    static void copy(FmtSPDIF::sample_t *dest, const FmtS32::sample_t *src, uint sample_count) {
+        for (uint i = 0; i < sample_count * 2; i++) {
+            spdif_update_subframe_24(dest++, *src++ >> 8);
+        }
+    }
+};
+#endif
+
 template<typename FromFmt>
 struct converting_copy<Stereo<FmtSPDIF>, Mono<FromFmt>> {
     static void copy(FmtSPDIF::sample_t *dest, const typename FromFmt::sample_t *src, uint sample_count) {
@@ -42,6 +54,12 @@ void stereo_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_
     producer_pool_blocking_give<Stereo<FmtSPDIF>, Stereo<FmtS16>>(connection, buffer);
 }
 
+#if PICO_AUDIO_SPDIF_24BIT
+void stereo_s32_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_t *buffer) {
+    producer_pool_blocking_give<Stereo<FmtSPDIF>, Stereo<FmtS32>>(connection, buffer);
+}
+#endif
+
 void mono_to_spdif_producer_give(audio_connection_t *connection, audio_buffer_t *buffer) {
     producer_pool_blocking_give<Stereo<FmtSPDIF>, Mono<FmtS16>>(connection, buffer);
 }